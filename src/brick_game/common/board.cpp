@@ -0,0 +1,10 @@
+#include "../../inc/board.h"
+
+/** @file */
+
+namespace s21 {
+
+// Every game in the tree plays on this board, so it is compiled once here
+template class Board<FIELD_W, FIELD_H>;
+
+}  // namespace s21
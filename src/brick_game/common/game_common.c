@@ -2,117 +2,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-/**
- * @brief Prints a rectangle on a given window using ncurses extended characters.
- *
- * @param[in] win the window to draw the rectangle on
- * @param[in] top_y the y-coordinate of the top of the rectangle
- * @param[in] bottom_y the y-coordinate of the bottom of the rectangle
- * @param[in] left_x the x-coordinate of the left of the rectangle
- * @param[in] right_x the x-coordinate of the right of the rectangle
- */
-void print_rectangle(WINDOW *win, int top_y, int bottom_y, int left_x, int right_x) {
-  mvwaddch(win, top_y, left_x, ACS_ULCORNER);
-
-  int i = left_x + 1;
-  while (i < right_x) {
-    mvwaddch(win, top_y, i++, ACS_HLINE);
-  }
-  mvwaddch(win, top_y, i, ACS_URCORNER);
-
-  for (int i = top_y + 1; i < bottom_y; i++) {
-    mvwaddch(win, i, left_x, ACS_VLINE);
-    mvwaddch(win, i, right_x, ACS_VLINE);
-  }
-
-  mvwaddch(win, bottom_y, left_x, ACS_LLCORNER);
-  i = left_x + 1;
-  while (i < right_x) {
-    mvwaddch(win, bottom_y, i++, ACS_HLINE);
-  }
-  mvwaddch(win, bottom_y, i, ACS_LRCORNER);
-}
-
-/**
- * @brief Prints the game field border.
- *
- * @param[in] win the window to draw the game field on
- */
-void print_field(WINDOW *win) {
-  print_rectangle(win, 0, FIELD_HEIGHT, 0, FIELD_WIDTH);
-}
-
-/**
- * @brief Prints the game field on the given window.
- *
- * @param[in] win the window to draw the game field on
- * @param[in] game_info the game information structure
- */
-void print_play_field(WINDOW *win, GameInfo *game_info){
-  for (int y = 0; y < FIELD_H; ++y) {
-    for (int x = 0; x < FIELD_W; ++x) {
-      switch (game_info->field[y][x]) {
-        case 0: 
-          wattron(win, COLOR_PAIR(1));
-          mvwaddch(win, y+1, x+1, '.');
-          wattroff(win, COLOR_PAIR(1));
-          break;
-        case 1: 
-          mvwaddch(win, y+1, x+1, 'o');
-          break;
-        case 2: 
-          mvwaddch(win, y+1, x+1, '0');
-          break;
-        case 3: 
-          wattron(win, COLOR_PAIR(3));
-          mvwaddch(win, y+1, x+1, '@');
-          wattroff(win, COLOR_PAIR(3));
-          break;
-        default: 
-          break;
-      }
-    }
-  }
-}
-
-/**
- * @brief Prints the information bar on the game window.
- *
- * @param[in] win the window to draw the information bar on
- * @param[in] game_info the game information structure
- */
-void print_info_bar(WINDOW *win, GameInfo *game_info) {
-  print_rectangle(win, 0, 4, FIELD_WIDTH + 2, FIELD_WIDTH + 18);
-  mvwprintw(win, 1, 19, "Level:");
-  mvwprintw(win, 3, 21, "%d", game_info->level);
-
-  print_rectangle(win, 5, 9, FIELD_WIDTH + 2, FIELD_WIDTH + 18);
-  mvwprintw(win, 6, 19, "Score:");
-  mvwprintw(win, 8, 16, "%6d", game_info->score);
-
-  print_rectangle(win, 10, 14, FIELD_WIDTH + 2, FIELD_WIDTH + 18);
-  mvwprintw(win, 11, 16, "High Score:");
-  mvwprintw(win, 13, 16, "%6d", game_info->high_score);
-
-  print_rectangle(win, 15, FIELD_HEIGHT, FIELD_WIDTH + 2, FIELD_WIDTH + 18);
-}
-
-/**
- * @brief Prints additional messages on the game window.
- *
- * @param[in] win the window to print the message on
- * @param[in] pause_state the current pause state of the game
- */
-void print_other_message(WINDOW *win, int pause_state) {
-  if (pause_state == PAUSED) {
-    mvwprintw(win, 1, 1, "PAUSE");
-  } else if (pause_state == WIN) {
-    mvwprintw(win, 1, 1, "You won!!!");
-  } else if (pause_state == LOSED) {
-    mvwprintw(win, 1, 1, "You lost!");
-  }
-}
-
 /**
  * @brief Gets the current high score from a file.
  *
@@ -164,32 +53,53 @@ void update_level_speed(GameInfo *game_info, int speed_step) {
 }
 
 /**
- * @brief Handles user input and returns the corresponding action.
+ * @brief Lists a changed cell, or asks for a full redraw once the journal
+ * is full.
+ *
+ * @param[in,out] journal the journal to write to
+ * @param[in] x column of the cell
+ * @param[in] y row of the cell
+ */
+void journal_cell(ChangeJournal *journal, int x, int y) {
+  if (journal->count < CHANGE_JOURNAL_CELLS) {
+    journal->cells[journal->count++] = (uint16_t)(y << 8 | x);
+  } else {
+    journal->flags |= CHANGED_CELLS_ALL;
+  }
+}
+
+/**
+ * @brief Marks the rows top to bottom as changed as a whole.
  *
- * @param[in] ch the character input from the user
- * @return the corresponding UserAction
+ * @param[in,out] journal the journal to write to
+ * @param[in] top first row
+ * @param[in] bottom last row, included
  */
-UserAction handle_user_input(int ch) {
-  switch (ch) {
-    case KEY_UP:
-      return Up;
-    case KEY_DOWN:
-      return Down;
-    case KEY_LEFT:
-      return Left;
-    case KEY_RIGHT:
-      return Right;
-    case 'p':
-    case 'P':
-      return Pause;
-    case 'q':
-    case 'Q':
-      return Terminate;
-    case '\n':
-      return Start;
-    case ' ':
-      return Action;
-    default:
-      return 333; // Default action
+void journal_rows(ChangeJournal *journal, int top, int bottom) {
+  if (top < 0 || bottom >= CHANGE_JOURNAL_ROWS) {
+    journal->flags |= CHANGED_CELLS_ALL;
+  } else {
+    for (int y = top; y <= bottom; ++y) journal->rows |= 1u << y;
   }
-} 
\ No newline at end of file
+}
+
+/**
+ * @brief Forgets the changes after a renderer has drawn them.
+ *
+ * @param[out] journal the journal to clear
+ */
+void journal_clear(ChangeJournal *journal) {
+  journal->count = 0;
+  journal->flags = 0;
+  journal->rows = 0;
+}
+
+/**
+ * @brief Tells whether anything changed since the journal was cleared.
+ *
+ * @param[in] journal the journal to look at
+ * @return true when there is nothing to redraw
+ */
+bool journal_is_empty(const ChangeJournal *journal) {
+  return journal->count == 0 && journal->flags == 0 && journal->rows == 0;
+}
@@ -0,0 +1,250 @@
+#include "../../inc/replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** @file */
+
+#define ACTION_BITS 3
+#define ACTION_MASK ((1u << ACTION_BITS) - 1u)
+
+static void put_u32(uint8_t *out, uint32_t value) {
+  for (int i = 0; i < 4; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static void put_u64(uint8_t *out, uint64_t value) {
+  for (int i = 0; i < 8; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) value |= (uint32_t)in[i] << (8 * i);
+  return value;
+}
+
+static uint64_t get_u64(const uint8_t *in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) value |= (uint64_t)in[i] << (8 * i);
+  return value;
+}
+
+/**
+ * @brief Appends a LEB128 varint to the input stream.
+ *
+ * @param[in,out] replay the replay to extend
+ * @param[in] value the value to encode
+ * @return false if the stream could not grow, the replay is left unchanged
+ */
+static bool put_varint(Replay *replay, uint64_t value) {
+  if (replay->size + 10 > replay->capacity) {
+    size_t capacity = replay->capacity ? replay->capacity * 2 : 256;
+    uint8_t *data = (uint8_t *)realloc(replay->data, capacity);
+    if (!data) return false;
+    replay->data = data;
+    replay->capacity = capacity;
+  }
+  while (value >= 0x80) {
+    replay->data[replay->size++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  replay->data[replay->size++] = (uint8_t)value;
+  return true;
+}
+
+/**
+ * @brief Starts an empty recording.
+ *
+ * @param[out] replay the replay to initialize
+ * @param[in] game REPLAY_TETRIS or REPLAY_SNAKE
+ * @param[in] seed the seed the game was created with
+ * @param[in] flags REPLAY_FLAG_* bits
+ */
+void replay_init(Replay *replay, uint8_t game, uint64_t seed, uint8_t flags) {
+  memset(replay, 0, sizeof(*replay));
+  replay->game = game;
+  replay->flags = flags;
+  replay->seed = seed;
+}
+
+/**
+ * @brief Frees the inputs of a replay.
+ *
+ * @param[in,out] replay the replay to free
+ */
+void replay_free(Replay *replay) {
+  free(replay->data);
+  replay->data = NULL;
+  replay->size = replay->capacity = 0;
+}
+
+/**
+ * @brief Appends an input. Ticks must not decrease between calls.
+ *
+ * @param[in,out] replay the replay to extend
+ * @param[in] tick number of ticks run before the input
+ * @param[in] action the input, values outside UserAction are ignored
+ * @return false if the input was not recorded
+ */
+bool replay_record(Replay *replay, uint32_t tick, UserAction action) {
+  if ((unsigned)action > ACTION_MASK || tick < replay->last_tick) return false;
+  uint64_t delta = tick - replay->last_tick;
+  if (!put_varint(replay, (delta << ACTION_BITS) | (unsigned)action))
+    return false;
+  replay->last_tick = tick;
+  replay->events++;
+  return true;
+}
+
+/**
+ * @brief Stores the outcome a playback has to reproduce.
+ *
+ * @param[in,out] replay the replay to finish
+ * @param[in] ticks ticks run by the whole session
+ * @param[in] score the final score
+ * @param[in] board_hash field_hash of the final field
+ */
+void replay_finish(Replay *replay, uint32_t ticks, int score,
+                   uint64_t board_hash) {
+  replay->ticks = ticks;
+  replay->score = score;
+  replay->board_hash = board_hash;
+}
+
+/**
+ * @brief Writes a replay to a file.
+ *
+ * @param[in] replay the replay to write
+ * @param[in] path the file to create
+ * @return false if the file could not be written
+ */
+bool replay_save(const Replay *replay, const char *path) {
+  uint8_t header[REPLAY_HEADER_SIZE] = {0};
+  memcpy(header, REPLAY_MAGIC, 4);
+  header[4] = REPLAY_VERSION;
+  header[5] = replay->game;
+  header[6] = replay->flags;
+  put_u64(header + 8, replay->seed);
+  put_u32(header + 16, replay->ticks);
+  put_u32(header + 20, (uint32_t)replay->score);
+  put_u64(header + 24, replay->board_hash);
+  put_u32(header + 32, replay->events);
+  put_u32(header + 36, (uint32_t)replay->size);
+
+  bool saved = false;
+  FILE *file = fopen(path, "wb");
+  if (file) {
+    saved = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+            fwrite(replay->data, 1, replay->size, file) == replay->size;
+    saved = fclose(file) == 0 && saved;
+  }
+  return saved;
+}
+
+/**
+ * @brief Reads a replay written by replay_save.
+ *
+ * @param[out] replay the replay to fill, free it with replay_free
+ * @param[in] path the file to read
+ * @return false if the file is missing, truncated or not a replay
+ */
+bool replay_load(Replay *replay, const char *path) {
+  uint8_t header[REPLAY_HEADER_SIZE];
+  bool loaded = false;
+  memset(replay, 0, sizeof(*replay));
+
+  FILE *file = fopen(path, "rb");
+  long length = -1;
+  if (file && !fseek(file, 0, SEEK_END)) {
+    length = ftell(file);
+    rewind(file);
+  }
+  if (file) {
+    if (length >= REPLAY_HEADER_SIZE &&
+        fread(header, 1, sizeof(header), file) == sizeof(header) &&
+        !memcmp(header, REPLAY_MAGIC, 4) && header[4] == REPLAY_VERSION) {
+      replay->game = header[5];
+      replay->flags = header[6];
+      replay->seed = get_u64(header + 8);
+      replay->ticks = get_u32(header + 16);
+      replay->score = (int32_t)get_u32(header + 20);
+      replay->board_hash = get_u64(header + 24);
+      replay->events = get_u32(header + 32);
+      replay->size = get_u32(header + 36);
+      // The size comes from the file, so it is checked before allocating
+      if (replay->size <= (size_t)(length - REPLAY_HEADER_SIZE)) {
+        replay->data = (uint8_t *)malloc(replay->size ? replay->size : 1);
+      }
+      if (replay->data) {
+        replay->capacity = replay->size;
+        loaded = fread(replay->data, 1, replay->size, file) == replay->size;
+      }
+    }
+    fclose(file);
+  }
+  if (!loaded) replay_free(replay);
+  return loaded;
+}
+
+/**
+ * @brief Positions a cursor before the first input.
+ */
+void replay_cursor_init(ReplayCursor *cursor, const Replay *replay) {
+  cursor->replay = replay;
+  cursor->offset = 0;
+  cursor->tick = 0;
+  cursor->events = 0;
+}
+
+/**
+ * @brief Decodes the next input.
+ *
+ * @param[in,out] cursor the read position
+ * @param[out] tick number of ticks to run before the input
+ * @param[out] action the input
+ * @return false after the last input or on a damaged stream
+ */
+bool replay_cursor_next(ReplayCursor *cursor, uint32_t *tick,
+                        UserAction *action) {
+  const Replay *replay = cursor->replay;
+  uint64_t value = 0;
+  bool complete = false;
+
+  if (cursor->events < replay->events) {
+    for (int shift = 0; shift < 64 && cursor->offset < replay->size;
+         shift += 7) {
+      uint8_t byte = replay->data[cursor->offset++];
+      value |= (uint64_t)(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        complete = true;
+        break;
+      }
+    }
+  }
+  if (complete) {
+    cursor->tick += (uint32_t)(value >> ACTION_BITS);
+    cursor->events++;
+    *tick = cursor->tick;
+    *action = (UserAction)(value & ACTION_MASK);
+  }
+  return complete;
+}
+
+/**
+ * @brief FNV-1a hash of every cell of a field.
+ *
+ * @param[in] field rows of cells
+ * @param[in] rows number of rows
+ * @param[in] cols number of cells in a row
+ * @return the hash
+ */
+uint64_t field_hash(int **field, int rows, int cols) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (int y = 0; y < rows; y++) {
+    for (int x = 0; x < cols; x++) {
+      hash ^= (uint32_t)field[y][x];
+      hash *= 0x100000001B3ull;
+    }
+  }
+  return hash;
+}
@@ -0,0 +1,77 @@
+#include "../../inc/rng.h"
+
+/** @file */
+
+static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+/**
+ * @brief Advances a splitmix64 state and returns its next output.
+ *
+ * @param[in,out] state the splitmix64 state
+ * @return the next output
+ */
+static uint64_t splitmix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/**
+ * @brief Seeds a generator. Equal seeds give equal sequences.
+ *
+ * The seed is expanded with splitmix64, so nearby seeds such as consecutive
+ * game indices still give unrelated sequences and the state is never zero.
+ *
+ * @param[out] rng the generator to seed
+ * @param[in] seed any 64-bit value
+ */
+void rng_seed(Rng *rng, uint64_t seed) {
+  for (int i = 0; i < 4; i++) {
+    rng->s[i] = splitmix64(&seed);
+  }
+}
+
+/**
+ * @brief Returns the next 64 random bits.
+ *
+ * @param[in,out] rng the generator
+ * @return the next output of xoshiro256**
+ */
+uint64_t rng_next(Rng *rng) {
+  uint64_t *s = rng->s;
+  uint64_t result = rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+
+  return result;
+}
+
+/**
+ * @brief Returns a uniformly distributed number in [0, bound).
+ *
+ * Uses a multiply and shift instead of a modulo, with rejection of the few
+ * values that would bias the result.
+ *
+ * @param[in,out] rng the generator
+ * @param[in] bound the exclusive upper limit, must be positive
+ * @return a number below bound
+ */
+uint32_t rng_below(Rng *rng, uint32_t bound) {
+  uint64_t product = (rng_next(rng) >> 32) * bound;
+  uint32_t low = (uint32_t)product;
+  if (low < bound) {
+    uint32_t threshold = (uint32_t)-bound % bound;
+    while (low < threshold) {
+      product = (rng_next(rng) >> 32) * bound;
+      low = (uint32_t)product;
+    }
+  }
+  return (uint32_t)(product >> 32);
+}
@@ -7,72 +7,103 @@ namespace s21 {
 /**
  * @brief Construct a new Snake object
  *
- * Constructor for Snake class. Seed for random is set.
- * Memory for game field and apple is allocated.
+ * Constructor for Snake class that reads and saves the high score file.
+ */
+template <int W, int H>
+BasicSnake<W, H>::BasicSnake() : BasicSnake(true) {}
+
+/**
+ * @brief Construct a new Snake object
+ *
+ * Apples are seeded from the current time.
+ *
+ * @param persist_high_score false for simulated games, which start with a
+ * high score of 0 and never touch HIGH_SCORE_PATH_SNAKE.
+ */
+template <int W, int H>
+BasicSnake<W, H>::BasicSnake(bool persist_high_score)
+    : BasicSnake(persist_high_score,
+            static_cast<std::uint64_t>(std::time(nullptr))) {}
+
+/**
+ * @brief Construct a new Snake object
+ *
+ * Constructor for Snake class. The apple generator is seeded, so snakes with
+ * equal seeds and equal moves get equal apples.
+ * The field and the apple live in the object and GameInfo points at them.
  * High score is set from file, level speed and pause status are set to default.
  * Direction is set to Up and last time is set to current time.
  * Snake is initialized and apple is generated.
+ *
+ * @param persist_high_score false for simulated games, which start with a
+ * high score of 0 and never touch HIGH_SCORE_PATH_SNAKE.
+ * @param seed seed of the apple generator
  */
-Snake::Snake() {
-  std::srand(std::time(nullptr));
-
-  game_info_.field = new int *[FIELD_H];
-  for (int i = 0; i < FIELD_H; i++) {
-    game_info_.field[i] = new int[FIELD_H]();
-  }
-
-  game_info_.next = new int *[1];
-  game_info_.next[0] = new int[2]();
-  game_info_.next[0][0] = -1;  // Инициализируем с невалидными координатами
-  game_info_.next[0][1] = -1;
-
-  game_info_.high_score = get_high_score_from_file(HIGH_SCORE_PATH_SNAKE);
+template <int W, int H>
+BasicSnake<W, H>::BasicSnake(bool persist_high_score, std::uint64_t seed)
+    : persist_high_score_(persist_high_score), seed_(seed) {
+  rng_seed(&rng_, seed);
+
+  game_info_.field = board_.Rows();
+  apple_rows_[0] = apple_;
+  game_info_.next = apple_rows_;
+  ResetApple();
+
+  game_info_.high_score =
+      persist_high_score_ ? get_high_score_from_file(HIGH_SCORE_PATH_SNAKE) : 0;
   game_info_.level = LEVEL_MIN;
   game_info_.speed = SPEED_1_SNAKE;
   game_info_.pause = NOT_STARTED;
   game_info_.score = NOT_STARTED;
+  game_info_.tetris = nullptr;
 
   direction_ = Up;
-  last_time_ = clock();
   move_flag_ = true;
+  journal_clear(&changes_);
   InitSnake();
   GenerateApple();
+  changes_.flags |= CHANGED_EVERYTHING;
 }
 
 /**
  * @brief Destructor for Snake class
  *
- * Deallocates memory for game field and apple.
+ * The field and the apple belong to the object, nothing is freed.
  */
-Snake::~Snake() {
-  for (int i = 0; i < FIELD_H; ++i) {
-    delete[] game_info_.field[i];
-  }
-  delete[] game_info_.field;
+template <int W, int H>
+BasicSnake<W, H>::~BasicSnake() {}
 
-  delete[] game_info_.next[0];
-  delete[] game_info_.next;
+/**
+ * @brief Marks the apple as not placed yet.
+ */
+template <int W, int H>
+void BasicSnake<W, H>::ResetApple() {
+  apple_[0] = -1;  // Инициализируем с невалидными координатами
+  apple_[1] = -1;
 }
 
 /**
  * @brief Generates a new apple at random position on the field
  *
  * This method ensures that the generated apple does not overlap with the
- * snake's body.
+ * snake's body. The apple cell goes into the change journal.
  */
-void Snake::GenerateApple() {
+template <int W, int H>
+void BasicSnake<W, H>::GenerateApple() {
   
   SnakeElements position;
 
   do {
-    position.x = rand() % FIELD_W;
-    position.y = rand() % FIELD_H;
+    position.x = static_cast<int>(rng_below(&rng_, W));
+    position.y = static_cast<int>(rng_below(&rng_, H));
   } while (CheckSnakeBody(position.x, position.y));
 
   game_info_.next[0][0] = position.x;
   game_info_.next[0][1] = position.y;
 
   game_info_.field[position.y][position.x] = 3;  // 3 - яблоко
+  journal_cell(&changes_, position.x, position.y);
+  changes_.flags |= CHANGED_NEXT;
 }
 
 /**
@@ -83,11 +114,12 @@ void Snake::GenerateApple() {
  * orientation with a default length.
  */
 
-void Snake::InitSnake() {
-  snake_coordinates_ = {{FIELD_W / 2, FIELD_H / 2 - 1},
-                        {FIELD_W / 2, FIELD_H / 2},
-                        {FIELD_W / 2, FIELD_H / 2 + 1},
-                        {FIELD_W / 2, FIELD_H / 2 + 2}};
+template <int W, int H>
+void BasicSnake<W, H>::InitSnake() {
+  snake_coordinates_ = {{W / 2, H / 2 - 1},
+                        {W / 2, H / 2},
+                        {W / 2, H / 2 + 1},
+                        {W / 2, H / 2 + 2}};
   
   // Сохраняем координаты змейки в игровое поле
   // 1 - тело змейки, 2 - голова змейки
@@ -113,10 +145,17 @@ void Snake::InitSnake() {
  * the snake does not move. If the snake eats an apple, a new
  * apple is generated and the game's speed is updated.
  *
+ * Only the cells that change are written: the old head becomes body, the
+ * new head is drawn and the tail, unless the snake grows, is cleared. A
+ * head that runs into the body leaves the body cell as it is, as it did
+ * when the whole body was written every move. The three cells go into the
+ * change journal.
+ *
  * @param action The direction in which to move the snake.
  */
 
-void Snake::MoveSnake(UserAction action) {
+template <int W, int H>
+void BasicSnake<W, H>::MoveSnake(UserAction action) {
   CheckEndGame();
   if (game_info_.pause != STARTED) {
     return;
@@ -142,6 +181,7 @@ void Snake::MoveSnake(UserAction action) {
 
   // Проверяем, съела ли змейка яблоко
   bool ate_apple = CheckAteApple();
+  SnakeElements neck = snake_coordinates_.front();
   snake_coordinates_.push_front(head);
 
 
@@ -153,21 +193,17 @@ void Snake::MoveSnake(UserAction action) {
     // Змейка не съела яблоко - удаляем хвост и очищаем его из поля
     SnakeElements tail = snake_coordinates_.back();
     game_info_.field[tail.y][tail.x] = 0;
+    journal_cell(&changes_, tail.x, tail.y);
     snake_coordinates_.pop_back();
   }
 
-  // Обновляем поле с новыми позициями змейки
-  for (size_t i = 0; i < snake_coordinates_.size(); ++i) {
-    int x = snake_coordinates_[i].x;
-    int y = snake_coordinates_[i].y;
-    if (i == 0) {
-      // Голова змейки
-      game_info_.field[y][x] = 2;
-    } else {
-      // Тело змейки
-      game_info_.field[y][x] = 1;
-    }
+  // Обновляем поле только там, где змейка сдвинулась
+  game_info_.field[neck.y][neck.x] = 1;
+  journal_cell(&changes_, neck.x, neck.y);
+  if (game_info_.field[head.y][head.x] != 1) {
+    game_info_.field[head.y][head.x] = 2;
   }
+  journal_cell(&changes_, head.x, head.y);
 
   move_flag_ = true;
 }
@@ -180,7 +216,8 @@ void Snake::MoveSnake(UserAction action) {
  * the snake from reversing directly onto itself.
  */
 
-void Snake::MoveLeft() {
+template <int W, int H>
+void BasicSnake<W, H>::MoveLeft() {
   if (direction_ != Right) {
     direction_ = Left;
     move_flag_ = false;
@@ -194,7 +231,8 @@ void Snake::MoveLeft() {
  * the current direction is left, to prevent the snake from
  * reversing directly onto itself.
  */
-void Snake::MoveRight() {
+template <int W, int H>
+void BasicSnake<W, H>::MoveRight() {
   if (direction_ != Left) {
     direction_ = Right;
     move_flag_ = false;
@@ -209,7 +247,8 @@ void Snake::MoveRight() {
  * reversing directly onto itself.
  */
 
-void Snake::MoveDown() {
+template <int W, int H>
+void BasicSnake<W, H>::MoveDown() {
   if (direction_ != Up) {
     direction_ = Down;
     move_flag_ = false;
@@ -224,7 +263,8 @@ void Snake::MoveDown() {
  * the snake from reversing directly onto itself.
  */
 
-void Snake::MoveUp() {
+template <int W, int H>
+void BasicSnake<W, H>::MoveUp() {
   if (direction_ != Down) {
     direction_ = Up;
     move_flag_ = false;
@@ -236,7 +276,11 @@ void Snake::MoveUp() {
  *
  * This method ends the game by setting the pause field of GameInfo to QUIT.
  */
-void Snake::TerminateGame() { game_info_.pause = QUIT; }
+template <int W, int H>
+void BasicSnake<W, H>::TerminateGame() {
+  game_info_.pause = QUIT;
+  changes_.flags |= CHANGED_STATE;
+}
 
 /**
  * @brief Starts the game.
@@ -244,7 +288,11 @@ void Snake::TerminateGame() { game_info_.pause = QUIT; }
  * This method sets the pause field of GameInfo to STARTED,
  * which starts the game.
  */
-void Snake::StartGame() { game_info_.pause = STARTED; }
+template <int W, int H>
+void BasicSnake<W, H>::StartGame() {
+  game_info_.pause = STARTED;
+  changes_.flags |= CHANGED_STATE;
+}
 
 /**
  * @brief Toggles the pause state of the game.
@@ -253,8 +301,10 @@ void Snake::StartGame() { game_info_.pause = STARTED; }
  * PAUSED. If the game is paused, this method sets the pause field of GameInfo
  * to STARTED.
  */
-void Snake::PauseGame() {
+template <int W, int H>
+void BasicSnake<W, H>::PauseGame() {
   game_info_.pause = (game_info_.pause == PAUSED) ? STARTED : PAUSED;
+  changes_.flags |= CHANGED_STATE;
 }
 
 /**
@@ -268,10 +318,12 @@ void Snake::PauseGame() {
  * @return true if the snake has eaten the apple, false otherwise.
  */
 
-bool Snake::CheckAteApple() {
+template <int W, int H>
+bool BasicSnake<W, H>::CheckAteApple() {
   if (snake_coordinates_.front().x == game_info_.next[0][0] &&
       snake_coordinates_.front().y == game_info_.next[0][1]) {
     ++game_info_.score;
+    changes_.flags |= CHANGED_SCORE;
     return true;
   }
   return false;
@@ -287,7 +339,8 @@ bool Snake::CheckAteApple() {
  *
  * @return true if the snake has eaten itself, false otherwise.
  */
-bool Snake::CheckAteItself() {
+template <int W, int H>
+bool BasicSnake<W, H>::CheckAteItself() {
   for (size_t i = 1; i < snake_coordinates_.size(); ++i) {
     if (snake_coordinates_[0].x == snake_coordinates_[i].x &&
         snake_coordinates_[0].y == snake_coordinates_[i].y) {
@@ -311,9 +364,10 @@ bool Snake::CheckAteItself() {
  * @return true if the coordinates are part of the snake's body, false
  * otherwise.
  */
-bool Snake::CheckSnakeBody(int x, int y) {
+template <int W, int H>
+bool BasicSnake<W, H>::CheckSnakeBody(int x, int y) {
   // Проверяем границы поля
-  if (x < 0 || x >= FIELD_W || y < 0 || y >= FIELD_H) {
+  if (!GameBoard::Contains(x, y)) {
     return true; // За пределами поля считаем занятым
   }
   
@@ -333,16 +387,18 @@ bool Snake::CheckSnakeBody(int x, int y) {
  * to LOSED. If the score is 200, it sets the pause field
  * to WIN.
  */
-void Snake::CheckEndGame() {
+template <int W, int H>
+void BasicSnake<W, H>::CheckEndGame() {
+  int pause = game_info_.pause;
   for (size_t i = 0; i < snake_coordinates_.size(); ++i) {
     if (snake_coordinates_.front().x <= 0 && GetDirection() == Left) {
       game_info_.pause = LOSED;
-    } else if (snake_coordinates_.front().x >= FIELD_W - 1 &&
+    } else if (snake_coordinates_.front().x >= W - 1 &&
                GetDirection() == Right) {
       game_info_.pause = LOSED;
     } else if (snake_coordinates_.front().y <= 0 && GetDirection() == Up) {
       game_info_.pause = LOSED;
-    } else if (snake_coordinates_.front().y >= FIELD_H - 1 &&
+    } else if (snake_coordinates_.front().y >= H - 1 &&
                GetDirection() == Down) {
       game_info_.pause = LOSED;
     } else if (game_info_.score == 200) {
@@ -353,9 +409,11 @@ void Snake::CheckEndGame() {
   if (CheckAteItself()) {
     game_info_.pause = LOSED;
   }
+  if (game_info_.pause != pause) changes_.flags |= CHANGED_STATE;
 }
 
-UserAction Snake::GetDirection() { return this->direction_; }
+template <int W, int H>
+UserAction BasicSnake<W, H>::GetDirection() { return this->direction_; }
 
 /**
  * @brief Gets the current high score from a file.
@@ -367,7 +425,8 @@ UserAction Snake::GetDirection() { return this->direction_; }
  *
  * @return The high score read from the file
  */
-int Snake::GetHighScore() {
+template <int W, int H>
+int BasicSnake<W, H>::GetHighScore() {
   return get_high_score_from_file(HIGH_SCORE_PATH_SNAKE);
 }
 
@@ -382,7 +441,8 @@ int Snake::GetHighScore() {
  * if successful, the high score is written to it, and the file is closed.
  */
 
-void Snake::SaveHighScore() {
+template <int W, int H>
+void BasicSnake<W, H>::SaveHighScore() {
   if (game_info_.score >= game_info_.high_score) {
     save_high_score_to_file(HIGH_SCORE_PATH_SNAKE, game_info_.score);
   }
@@ -398,58 +458,94 @@ void Snake::SaveHighScore() {
  * It then checks if the current score is greater than the high score.
  * If it is, it updates the high score and calls SaveHighScore.
  */
-void Snake::UpdateLevelSpeed() {
+template <int W, int H>
+void BasicSnake<W, H>::UpdateLevelSpeed() {
+  int level = game_info_.level;
   update_level_speed(&game_info_, SPEED_STEP_SNAKE);
+  if (game_info_.level != level) changes_.flags |= CHANGED_LEVEL;
 
   if (game_info_.score > game_info_.high_score) {
     game_info_.high_score = game_info_.score;
-    SaveHighScore();
+    if (persist_high_score_) SaveHighScore();
   }
 }
 
 /**
  * @brief Resets the game to its initial state.
  *
- * This function resets the game to its initial state by deleting
- * the existing game field and apple, and allocating new memory for
- * them. It also resets the game's state variables such as the high
- * score, level, speed, pause, and score. It then calls the
+ * This function resets the game to its initial state by clearing
+ * the game field and the apple. It also resets the game's state
+ * variables such as the high score, level, speed, pause, and score. It then calls the
  * GenerateApple and InitSnake functions to reset the game's state.
  *
  */
-void Snake::ResetSnake() {
-  for (int i = 0; i < FIELD_H; ++i) {
-    delete[] game_info_.field[i];
-  }
-  delete[] game_info_.field;
-
-  game_info_.field = new int *[FIELD_H];
-  for (int i = 0; i < FIELD_H; ++i) {
-    game_info_.field[i] = new int[FIELD_H]();
-  }
-
-  for (int i = 0; i < 1; ++i) {
-    delete[] game_info_.next[i];
-  }
-  delete[] game_info_.next;
-
-  game_info_.next = new int *[1];
-  game_info_.next[0] = new int[2]();
-  game_info_.next[0][0] = -1;
-  game_info_.next[0][1] = -1;
-
-
-  game_info_.high_score = get_high_score_from_file(HIGH_SCORE_PATH_SNAKE);
+template <int W, int H>
+void BasicSnake<W, H>::ResetSnake() {
+  board_.Clear();
+  game_info_.field = board_.Rows();
+  game_info_.next = apple_rows_;
+  ResetApple();
+
+  game_info_.high_score =
+      persist_high_score_ ? get_high_score_from_file(HIGH_SCORE_PATH_SNAKE) : 0;
   game_info_.level = LEVEL_MIN;
   game_info_.speed = SPEED_1_SNAKE;
   game_info_.pause = NOT_STARTED;
   game_info_.score = NOT_STARTED;
 
   direction_ = Up;
-  last_time_ = clock();
 
   GenerateApple();
   InitSnake();
+  changes_.flags |= CHANGED_EVERYTHING;
 }
 
+/**
+ * @brief Copies the whole game.
+ *
+ * Every part of a snake is plain data of a fixed size, so the copy needs no
+ * allocation and shares nothing with the snake.
+ *
+ * @param[out] snapshot where the copy goes
+ */
+template <int W, int H>
+void BasicSnake<W, H>::Clone(Snapshot &snapshot) const {
+  snapshot.cells = board_.GetCells();
+  snapshot.body = snake_coordinates_;
+  snapshot.game_info = game_info_;
+  snapshot.apple[0] = apple_[0];
+  snapshot.apple[1] = apple_[1];
+  snapshot.direction = direction_;
+  snapshot.move_flag = move_flag_;
+  snapshot.rng = rng_;
+}
+
+/**
+ * @brief Puts back a game saved by Clone.
+ *
+ * The snapshot may come from another snake of the same board. The field
+ * and apple pointers keep leading into this snake, and the whole game is
+ * marked as changed for renderers.
+ *
+ * @param[in] snapshot the saved game
+ */
+template <int W, int H>
+void BasicSnake<W, H>::Restore(const Snapshot &snapshot) {
+  board_.SetCells(snapshot.cells);
+  snake_coordinates_ = snapshot.body;
+  game_info_ = snapshot.game_info;
+  game_info_.field = board_.Rows();
+  game_info_.next = apple_rows_;
+  apple_[0] = snapshot.apple[0];
+  apple_[1] = snapshot.apple[1];
+  direction_ = snapshot.direction;
+  move_flag_ = snapshot.move_flag;
+  rng_ = snapshot.rng;
+  changes_.flags |= CHANGED_EVERYTHING;
+}
+
+template class BasicSnake<FIELD_W, FIELD_H>;
+template class BasicSnake<16, 40>;
+template class BasicSnake<64, 64>;
+
 }  // namespace s21
\ No newline at end of file
@@ -4,7 +4,9 @@
 
 namespace s21 {
 
-SnakeController::SnakeController(Snake &snakeInstance)
+template <int W, int H>
+BasicSnakeController<W, H>::BasicSnakeController(
+    BasicSnake<W, H> &snakeInstance)
     : snake_(snakeInstance) {}
 
 /**
@@ -23,7 +25,8 @@ SnakeController::SnakeController(Snake &snakeInstance)
  * held.
  */
 
-void SnakeController::UserInput(UserAction action, bool hold) {
+template <int W, int H>
+void BasicSnakeController<W, H>::UserInput(UserAction action, bool hold) {
   if (snake_.GetPauseState() == STARTED) {
     
     if (snake_.GetMoveFlag()) {
@@ -76,33 +79,91 @@ void SnakeController::UserInput(UserAction action, bool hold) {
  * direction and returns a GameInfo object with the current game state.
  *
  * This function is used to update the snake's state at a given frequency
- * (determined by the Snake's speed). It returns a GameInfo object with the
- * current state of the game, including the snake's position, score, and other
- * relevant data.
+ * (determined by the Snake's speed). The deadline of every move is kept on
+ * the monotonic clock and the next one follows it by one period, so late
+ * calls do not shift the rhythm; after a stall of a whole period the missed
+ * moves are dropped instead of made up. A snake that is not running loses
+ * its schedule and starts a whole period after it runs again. It returns a
+ * GameInfo object with the current state of the game, including the snake's
+ * position, score, and other relevant data.
  *
  * @return A GameInfo object containing the current game state.
  */
-GameInfo SnakeController::UpdateCurrentState() {
+template <int W, int H>
+GameInfo BasicSnakeController<W, H>::UpdateCurrentState() {
   GameInfo game;
-  clock_t current_time = clock();
-  if ((current_time - snake_.last_time_) >=
-      snake_.GetSpeed() * CLOCKS_PER_SEC / 1000) {
-    snake_.MoveSnake(snake_.GetDirection());
-    snake_.last_time_ = current_time;
+  Clock::time_point now = Clock::now();
+  if (snake_.GetPauseState() != STARTED) {
+    scheduled_ = false;
+  } else if (!scheduled_) {
+    next_tick_ = now + std::chrono::milliseconds(snake_.GetSpeed());
+    scheduled_ = true;
+  } else if (now >= next_tick_) {
+    double jitter_ms =
+        std::chrono::duration<double, std::milli>(now - next_tick_).count();
+    tick_stats_.ticks++;
+    tick_stats_.total_jitter_ms += jitter_ms;
+    if (jitter_ms > tick_stats_.max_jitter_ms) {
+      tick_stats_.max_jitter_ms = jitter_ms;
+    }
+    Tick();  // A new level changes the speed from the next period on
+    next_tick_ += std::chrono::milliseconds(snake_.GetSpeed());
+    if (next_tick_ <= now) {
+      tick_stats_.skipped++;
+      next_tick_ = now + std::chrono::milliseconds(snake_.GetSpeed());
+    }
   }
   return game;
 }
 
+/**
+ * @brief Tells how long a frontend may sleep before UpdateCurrentState has
+ * to move the snake.
+ *
+ * @return milliseconds to the next move, rounded up, 0 if it is due and -1
+ * if the snake is not moving, so that only input can change the game
+ */
+template <int W, int H>
+int BasicSnakeController<W, H>::MillisecondsToNextTick() const {
+  if (!scheduled_ || snake_.GetPauseState() != STARTED) return -1;
+  auto left = std::chrono::ceil<std::chrono::milliseconds>(next_tick_ -
+                                                           Clock::now());
+  return left.count() > 0 ? static_cast<int>(left.count()) : 0;
+}
+
+/**
+ * @brief Moves the snake one step in its current direction.
+ *
+ * This is one game tick without any timing, used by UpdateCurrentState once
+ * enough time has passed and by simulations that run ticks back to back.
+ * Ticks are counted so that replays can place inputs between them.
+ */
+template <int W, int H>
+void BasicSnakeController<W, H>::Tick() {
+  snake_.MoveSnake(snake_.GetDirection());
+  ++ticks_;
+}
+
 /**
  * @brief Resets the snake's state to the initial state.
  *
  * This function calls the Snake's ResetSnake function to reset the snake's
  * state to the initial state. This involves resetting the snake's position,
  * score, high score, level, speed, and pause state. It also resets the game's
- * state variables such as the game's field, apple, and snake elements.
+ * state variables such as the game's field, apple, and snake elements. The
+ * schedule of the moves starts over.
  */
-void SnakeController::ResetController() { snake_.ResetSnake(); }
+template <int W, int H>
+void BasicSnakeController<W, H>::ResetController() {
+  snake_.ResetSnake();
+  scheduled_ = false;
+}
+
+template <int W, int H>
+BasicSnakeController<W, H>::~BasicSnakeController() {}
 
-SnakeController::~SnakeController() {}
+template class BasicSnakeController<FIELD_W, FIELD_H>;
+template class BasicSnakeController<16, 40>;
+template class BasicSnakeController<64, 64>;
 
 }  // namespace s21
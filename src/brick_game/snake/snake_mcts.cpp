@@ -0,0 +1,389 @@
+#include "../../inc/snake/snake_mcts.h"
+
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+/** @file */
+
+namespace s21 {
+
+namespace {
+
+// Moves the tree branches on, in the order ties are broken in
+constexpr UserAction kMoves[] = {Up, Down, Left, Right};
+
+// Nodes one tree may hold; a full tree keeps iterating without growing
+constexpr int kMaxNodes = 1 << 13;
+
+// Ticks a tree looks ahead before the rollout takes over
+constexpr int kMaxDepth = 64;
+
+// Worth of an apple or of a tick survived, per tick it lies ahead
+constexpr double kDiscount = 0.9;
+
+UserAction Reverse(UserAction move) {
+  switch (move) {
+    case Up:
+      return Down;
+    case Down:
+      return Up;
+    case Left:
+      return Right;
+    default:
+      return Left;
+  }
+}
+
+/**
+ * @brief Spreads a seed, a decision and a tree over the generator seeds.
+ */
+std::uint64_t MixSeed(std::uint64_t value) {
+  value += 0x9E3779B97F4A7C15ull;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+}  // namespace
+
+/**
+ * @brief Settings for live play: two trees, a 25th of a tick at the first
+ * level and greedy rollouts across half the board.
+ */
+template <int W, int H>
+typename BasicSnakeMcts<W, H>::Config BasicSnakeMcts<W, H>::DefaultConfig() {
+  return {2, SPEED_1_SNAKE / 25.0, 0, (W + H) / 2, true, 0.2, 1};
+}
+
+template <int W, int H>
+BasicSnakeMcts<W, H>::BasicSnakeMcts() : BasicSnakeMcts(DefaultConfig()) {}
+
+/**
+ * @brief Allocates the trees and starts their threads.
+ *
+ * @param config trees, limits and rollouts, out of range values are clamped;
+ * without a time limit every tree makes at least 1000 iterations
+ */
+template <int W, int H>
+BasicSnakeMcts<W, H>::BasicSnakeMcts(const Config &config) : config_(config) {
+  if (config_.threads < 1) config_.threads = 1;
+  if (config_.iterations < 0) config_.iterations = 0;
+  if (config_.time_limit_ms <= 0 && !config_.iterations) {
+    config_.iterations = 1000;
+  }
+  if (config_.rollout_ticks < 0) config_.rollout_ticks = 0;
+
+  for (int i = 0; i < config_.threads; ++i) {
+    auto tree = std::make_unique<Tree>();
+    tree->nodes.resize(kMaxNodes);
+    tree->snake = std::make_unique<GameSnake>(false, 0);
+    tree->controller =
+        std::make_unique<BasicSnakeController<W, H>>(*tree->snake);
+    trees_.push_back(std::move(tree));
+  }
+  for (int i = 1; i < config_.threads; ++i) {
+    threads_.emplace_back(&BasicSnakeMcts::Worker, this, i);
+  }
+}
+
+/**
+ * @brief Stops the threads.
+ */
+template <int W, int H>
+BasicSnakeMcts<W, H>::~BasicSnakeMcts() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread &thread : threads_) thread.join();
+}
+
+/**
+ * @brief Body of a started thread: grows its tree for every decision.
+ */
+template <int W, int H>
+void BasicSnakeMcts<W, H>::Worker(int index) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  unsigned seen = 0;
+  while (!quit_) {
+    wake_.wait(lock, [&] { return job_id_ != seen || quit_; });
+    if (!quit_) {
+      seen = job_id_;
+      lock.unlock();
+      GrowTree(*trees_[index]);
+      lock.lock();
+      if (--busy_ == 0) idle_.notify_one();
+    }
+  }
+}
+
+/**
+ * @brief Picks the move of the next tick.
+ *
+ * Every tree starts from a snapshot of the game with apples of its own
+ * after the current one, and grows until it has its iterations or the time
+ * is up; the root move visited most often over all trees is returned. A
+ * snake that can not turn this tick keeps its direction without a search.
+ *
+ * @param snake the game, it is only read
+ *
+ * @return Up, Down, Left or Right, to pass to UserInput before the tick
+ */
+template <int W, int H>
+UserAction BasicSnakeMcts<W, H>::Plan(const GameSnake &snake) {
+  Tree &first = *trees_[0];
+  snake.Clone(first.root);
+  if (snake.GetPauseState() != STARTED || !snake.GetMoveFlag()) {
+    return first.root.direction;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  has_deadline_ = config_.time_limit_ms > 0;
+  deadline_ = start + std::chrono::duration_cast<
+                          std::chrono::steady_clock::duration>(
+                          std::chrono::duration<double, std::milli>(
+                              config_.time_limit_ms));
+  for (int i = 0; i < config_.threads; ++i) {
+    Tree &tree = *trees_[i];
+    if (i) tree.root = first.root;
+    rng_seed(&tree.rng, MixSeed(MixSeed(config_.seed) ^
+                                static_cast<std::uint64_t>(stats_.decisions)
+                                    << 8 ^
+                                static_cast<std::uint64_t>(i)));
+    rng_seed(&tree.root.rng, rng_next(&tree.rng));
+  }
+
+  if (!threads_.empty()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++job_id_;
+      busy_ = static_cast<int>(threads_.size());
+    }
+    wake_.notify_all();
+  }
+  GrowTree(first);
+  if (!threads_.empty()) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [&] { return busy_ == 0; });
+  }
+
+  // Every tree lists the root moves in the same order
+  const Node &root = first.nodes[0];
+  UserAction best = first.root.direction;
+  long best_visits = -1;
+  for (int c = 0; c < root.child_count; ++c) {
+    long visits = 0;
+    for (const auto &tree : trees_) {
+      visits += tree->nodes[tree->nodes[0].first_child + c].visits;
+    }
+    if (visits > best_visits) {
+      best_visits = visits;
+      best = first.nodes[root.first_child + c].action;
+    }
+  }
+
+  for (const auto &tree : trees_) {
+    stats_.iterations += tree->iterations;
+    stats_.nodes += tree->node_count;
+    stats_.ticks += tree->ticks;
+  }
+  double elapsed = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  ++stats_.decisions;
+  stats_.total_ms += elapsed;
+  if (elapsed > stats_.longest_ms) stats_.longest_ms = elapsed;
+  return best;
+}
+
+/**
+ * @brief Grows one tree until it has its iterations or the time is up.
+ * Every tree makes at least one iteration.
+ */
+template <int W, int H>
+void BasicSnakeMcts<W, H>::GrowTree(Tree &tree) {
+  tree.nodes[0] = {tree.root.direction, -1, 0, 0, 0};
+  tree.node_count = 1;
+  tree.iterations = 0;
+  tree.ticks = 0;
+  do {
+    Iterate(tree);
+  } while ((!config_.iterations || tree.iterations < config_.iterations) &&
+           (!has_deadline_ || std::chrono::steady_clock::now() < deadline_));
+}
+
+/**
+ * @brief Adds a child for every move that neither reverses nor runs into a
+ * wall or the body, as long as the tree has room. A tree always plays the
+ * same apples, so a node stands for one position and the moves that lose
+ * there need no visits to be known.
+ */
+template <int W, int H>
+void BasicSnakeMcts<W, H>::Expand(Tree &tree, int node, UserAction direction) {
+  int count = 0;
+  if (tree.node_count + 3 <= kMaxNodes) {
+    tree.nodes[node].first_child = tree.node_count;
+    for (UserAction move : kMoves) {
+      if (move != Reverse(direction) && IsSafe(tree, move)) {
+        tree.nodes[tree.node_count++] = {move, -1, 0, 0, 0};
+        ++count;
+      }
+    }
+  }
+  tree.nodes[node].child_count = count;
+}
+
+/**
+ * @brief Picks the child to go down: every child once in order, then by
+ * UCT.
+ */
+template <int W, int H>
+int BasicSnakeMcts<W, H>::SelectChild(const Tree &tree, int node) const {
+  const Node &parent = tree.nodes[node];
+  double log_visits = std::log(static_cast<double>(parent.visits));
+  int best = -1;
+  double best_score = -std::numeric_limits<double>::max();
+  for (int c = parent.first_child;
+       c < parent.first_child + parent.child_count; ++c) {
+    const Node &child = tree.nodes[c];
+    if (!child.visits) return c;
+    double score = child.reward / child.visits +
+                   config_.exploration * std::sqrt(log_visits / child.visits);
+    if (score > best_score) {
+      best_score = score;
+      best = c;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Whether the head of the tree's game stays on the board and off
+ * the body with a move.
+ */
+template <int W, int H>
+bool BasicSnakeMcts<W, H>::IsSafe(const Tree &tree, UserAction move) const {
+  auto head = tree.snake->snake_coordinates_.front();
+  int x = head.x + (move == Right) - (move == Left);
+  int y = head.y + (move == Down) - (move == Up);
+  const int *const *field = tree.snake->GetField();
+  return Board<W, H>::Contains(x, y) && field[y][x] != 1 && field[y][x] != 2;
+}
+
+/**
+ * @brief Move of a rollout tick: a safe one, closest to the apple when
+ * greedy, else at random.
+ */
+template <int W, int H>
+UserAction BasicSnakeMcts<W, H>::RolloutMove(Tree &tree) {
+  GameSnake &snake = *tree.snake;
+  const int *apple = snake.GetApple()[0];
+  auto head = snake.snake_coordinates_.front();
+  UserAction direction = snake.GetDirection();
+
+  UserAction best = direction;
+  int best_score = std::numeric_limits<int>::min();
+  for (UserAction move : kMoves) {
+    if (move == Reverse(direction)) continue;
+    int x = head.x + (move == Right) - (move == Left);
+    int y = head.y + (move == Down) - (move == Up);
+    // Random low bits break ties, and are all that count when not greedy
+    int score = static_cast<int>(rng_below(&tree.rng, 4));
+    if (config_.greedy_rollouts) {
+      score -= 4 * (std::abs(x - apple[0]) + std::abs(y - apple[1]));
+    }
+    if (!IsSafe(tree, move)) score -= 4 * (W + H + 1);
+    if (score > best_score) {
+      best_score = score;
+      best = move;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Plays one tick of an iteration and counts its apple, worth less
+ * the later it is eaten.
+ */
+template <int W, int H>
+void BasicSnakeMcts<W, H>::Step(Tree &tree, UserAction move) {
+  tree.controller->UserInput(move, false);
+  tree.controller->Tick();
+  ++tree.ticks;
+  tree.discount *= kDiscount;
+  if (tree.snake->GetScore() != tree.score) {
+    tree.score = tree.snake->GetScore();
+    tree.apples += tree.discount;
+  }
+}
+
+/**
+ * @brief Result of an iteration, between 0 and 1: a half for staying alive,
+ * less the sooner the snake died, and up to a half for the apples eaten,
+ * each worth less the later it was eaten.
+ */
+template <int W, int H>
+double BasicSnakeMcts<W, H>::Reward(Tree &tree) {
+  GameSnake &snake = *tree.snake;
+  if (snake.GetPauseState() == STARTED) snake.CheckEndGame();
+  double reward = 0.5 * std::min(tree.apples, 1.0);
+  if (snake.GetPauseState() == STARTED || snake.GetPauseState() == WIN) {
+    reward += 0.5;
+  } else {
+    reward += 0.5 * (1 - tree.discount);
+  }
+  return reward;
+}
+
+/**
+ * @brief One iteration: restores the root, goes down the tree ticking the
+ * engine, grows it by one node, plays a rollout and adds the reward to the
+ * path.
+ */
+template <int W, int H>
+void BasicSnakeMcts<W, H>::Iterate(Tree &tree) {
+  GameSnake &snake = *tree.snake;
+  snake.Restore(tree.root);
+  tree.score = tree.root.game_info.score;
+  tree.apples = 0;
+  tree.discount = 1;
+
+  int path[kMaxDepth + 1] = {0};
+  int depth = 0;
+  UserAction direction = tree.root.direction;
+  bool expanded = false;
+  while (!expanded && snake.GetPauseState() == STARTED &&
+         depth < kMaxDepth) {
+    int node = path[depth];
+    if (tree.nodes[node].first_child < 0) {
+      Expand(tree, node, direction);
+      expanded = true;
+    }
+    if (!tree.nodes[node].child_count) break;
+    int child = SelectChild(tree, node);
+    direction = tree.nodes[child].action;
+    Step(tree, direction);
+    path[++depth] = child;
+  }
+  for (int tick = 0;
+       tick < config_.rollout_ticks && snake.GetPauseState() == STARTED;
+       ++tick) {
+    Step(tree, RolloutMove(tree));
+  }
+
+  double reward = Reward(tree);
+  for (int i = 0; i <= depth; ++i) {
+    ++tree.nodes[path[i]].visits;
+    tree.nodes[path[i]].reward += reward;
+  }
+  ++tree.iterations;
+}
+
+template class BasicSnakeMcts<FIELD_W, FIELD_H>;
+template class BasicSnakeMcts<16, 40>;
+template class BasicSnakeMcts<64, 64>;
+
+}  // namespace s21
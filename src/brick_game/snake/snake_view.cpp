@@ -1,6 +1,7 @@
 #include "../../inc/snake/snake_view.h"
 #include "../../inc/snake/snake.h"
 #include "../../inc/game_common.h"
+#include "../../inc/game_ui.h"
 
 /** @file */
 
@@ -15,14 +16,75 @@ namespace s21 {
 SnakeView::SnakeView(s21::SnakeController &controller)
     : controller_(controller) {}
 
+SnakeView::~SnakeView() { replay_free(&replay_); }
+
+/**
+ * @brief Records the game into a replay file written when the game is quit.
+ *
+ * @param path the file to write
+ */
+void SnakeView::RecordTo(const std::string &path) {
+  record_path_ = path;
+  replay_free(&replay_);
+  replay_init(&replay_, REPLAY_SNAKE, controller_.snake_.GetSeed(), 0);
+}
+
+/**
+ * @brief Lets the tree search steer the snake. The keys still pause and
+ * quit, and the moves are recorded like keys.
+ *
+ * @param enabled true for the autopilot, false for a human player
+ */
+void SnakeView::UseAutopilot(bool enabled) {
+  if (!enabled) {
+    autopilot_.reset();
+  } else if (!autopilot_) {
+    auto config = SnakeMcts::DefaultConfig();
+    config.seed = controller_.snake_.GetSeed();
+    autopilot_ = std::make_unique<SnakeMcts>(config);
+  }
+}
+
+/**
+ * @brief Plans the move of the coming tick once, if the autopilot is on and
+ * the snake may still turn. The search keeps to its time limit, far below
+ * the length of a tick.
+ */
+void SnakeView::PlayAutopilot() {
+  const Snake &snake = controller_.snake_;
+  if (autopilot_ && snake.GetPauseState() == STARTED && snake.GetMoveFlag() &&
+      controller_.GetTicks() != planned_tick_) {
+    planned_tick_ = controller_.GetTicks();
+    UserAction action = autopilot_->Plan(snake);
+    if (!record_path_.empty()) {
+      replay_record(&replay_, controller_.GetTicks(), action);
+    }
+    controller_.UserInput(action, false);
+  }
+}
+
+/**
+ * @brief Writes the recorded inputs and the final state, if recording.
+ */
+void SnakeView::SaveRecording() {
+  if (record_path_.empty()) return;
+  GameInfo game_info = controller_.snake_.GetGameInfo();
+  replay_finish(&replay_, controller_.GetTicks(), game_info.score,
+                field_hash(game_info.field, FIELD_H, FIELD_W));
+  replay_save(&replay_, record_path_.c_str());
+}
+
 /**
  * @brief Starts the snake game by initializing the game window and handling the
  * game loop.
  *
  * This function creates two windows: one for the start screen and another for
  * the game. The start screen prompts the user to press "Enter" to start the
- * game. Once started, the function enters a game loop where it continuously
- * handles user input and updates the game state until the game is quit.
+ * game. Once started, the function enters a game loop where it handles user
+ * input and updates the game state until the game is quit. Between frames it
+ * sleeps in poll() until a key arrives or the next move of the snake is due,
+ * and without a moving snake only a key wakes it up. A frame only draws
+ * what the change journal of the snake lists, see DrawChanges.
  */
 
 void SnakeView::StartSnakeGame() {
@@ -31,20 +93,49 @@ void SnakeView::StartSnakeGame() {
   while (controller_.snake_.GetPauseState() == NOT_STARTED) {
     print_rectangle(startwin, 0, FIELD_HEIGHT, 0, FIELD_WIDTH + 18);
     mvwprintw(startwin, 10, 6, "Press Enter to start");
-    HandelInput();
     wrefresh(startwin);
+    wait_for_input(-1);
+    HandelInput();
   }
+  // Schedules the first move, the game loop sleeps until it is due
+  controller_.UpdateCurrentState();
   endwin();
 
   WINDOW *gamewin = newwin(20 * 3 + 1, 20 * 2 + 1, 1, 1);
   while (controller_.snake_.GetPauseState() != QUIT) {
-    werase(gamewin);
+    DrawChanges(gamewin);
+    wait_for_input(controller_.MillisecondsToNextTick());
     HandelInput();
-    RefreshGame(gamewin/*, controller_.snake_.GetGameInfo(), controller_.snake_*/);
-    if (controller_.snake_.GetPauseState() == STARTED) {
-      controller_.UpdateCurrentState();
-    }
+    controller_.UpdateCurrentState();
+    // Right after a move, so the plan is ready long before the next one
+    PlayAutopilot();
   }
+  SaveRecording();
+}
+
+/**
+ * @brief Draws what the snake changed since the last frame.
+ *
+ * The window keeps the last frame, so a move only draws the old head, the
+ * new head and the tail again, and the info bar when the score or the level
+ * changed. A change of state or a journal that overflowed redraws the whole
+ * window.
+ *
+ * @param[in] win the game window
+ */
+void SnakeView::DrawChanges(WINDOW *win) {
+  const ChangeJournal &changes = controller_.snake_.GetChanges();
+  if (changes.flags & (CHANGED_CELLS_ALL | CHANGED_STATE)) {
+    werase(win);
+    RefreshGame(win);
+  } else if (!journal_is_empty(&changes)) {
+    GameInfo game_info = controller_.snake_.GetGameInfo();
+    print_changed_cells(win, &game_info, &changes);
+    if (changes.flags & (CHANGED_SCORE | CHANGED_LEVEL)) PrintInfoBar(win);
+    if (debug_) PrintDebugLine(win);
+    wrefresh(win);
+  }
+  controller_.snake_.ClearChanges();
 }
 
 /**
@@ -54,13 +145,16 @@ void SnakeView::StartSnakeGame() {
  * by sending commands to the SnakeController. The input keys include arrow keys
  * for movement, 'p' or 'P' to pause, 'q' or 'Q' to terminate the game, 'Enter'
  * to start, and the space bar for additional actions. The function does not
- * return any value.
+ * return any value. Recognized keys are added to the replay when recording.
  */
 
 
 void SnakeView::HandelInput() {
   int ch = getch();
   UserAction action = handle_user_input(ch);
+  if (!record_path_.empty()) {
+    replay_record(&replay_, controller_.GetTicks(), action);
+  }
 
   bool hold = false;
   if (action == Action) {
@@ -154,6 +248,7 @@ void SnakeView::RefreshGame(WINDOW *win/*, const GameInfo &game_info, Snake &sna
   PrintInfoBar(win);
   DrawGameField(win/*, game_info*/);
   PrintOtherMessage(win);
+  if (debug_) PrintDebugLine(win);
   wrefresh(win);
 }
 
@@ -210,4 +305,18 @@ void SnakeView::PrintOtherMessage(WINDOW *win) {
   print_other_message(win, controller_.snake_.GetPauseState());
 }
 
+/**
+ * @brief Prints the timing of the moves under the field: the moves run on
+ * their deadline, how late they ran on average and at most, and the
+ * deadlines dropped after a stall.
+ *
+ * @param[in] win the window to print the line on.
+ */
+void SnakeView::PrintDebugLine(WINDOW *win) {
+  const SnakeController::TickStats &stats = controller_.GetTickStats();
+  double mean = stats.ticks ? stats.total_jitter_ms / stats.ticks : 0;
+  mvwprintw(win, FIELD_HEIGHT + 1, 0, "ticks %ld jitter %.2f/%.2f ms skip %ld",
+            stats.ticks, mean, stats.max_jitter_ms, stats.skipped);
+}
+
 }  // namespace s21
\ No newline at end of file
@@ -0,0 +1,346 @@
+#include "../../inc/tetris/ai.h"
+
+#include <float.h>
+#include <string.h>
+
+/** @file */
+
+// Score of a placement after which the next piece cannot spawn
+#define AI_LOSS (-DBL_MAX)
+
+/**
+ * @brief Sets the weights of the well known four feature player, leaving
+ * the transition and well terms off, and turns the preview lookahead on.
+ * No table is used until ai->table is set.
+ *
+ * @param ai - pointer to the autoplayer
+ */
+void tetris_ai_init(TetrisAi *ai) {
+  memset(ai, 0, sizeof(*ai));
+  ai->weights.lines = 0.760666;
+  ai->weights.height = -0.510066;
+  ai->weights.holes = -0.35663;
+  ai->weights.bumpiness = -0.184483;
+  ai->weights.row_transitions = 0;
+  ai->weights.column_transitions = 0;
+  ai->weights.wells = 0;
+  ai->lookahead = true;
+}
+
+/**
+ * @brief Tells whether two orientations fill the same cells up to a shift.
+ */
+static bool same_cells(const ShapeOrientation *a, const ShapeOrientation *b) {
+  bool same = a->bottom - a->top == b->bottom - b->top;
+  for (int r = 0; same && r <= a->bottom - a->top; r++) {
+    same = (a->mask.rows[a->top + r] >> a->left) ==
+           (b->mask.rows[b->top + r] >> b->left);
+  }
+  return same;
+}
+
+/**
+ * @brief Lists every placement reachable by rotating in place, shifting
+ * sideways and dropping, the moves get_signal offers before gravity acts.
+ *
+ * Orientations that fill the same cells as an earlier one, such as all
+ * turns of the square, are listed once.
+ *
+ * @param state - board and column heights to place on
+ * @param type - the figure
+ * @param rotation - current rotation of the figure
+ * @param x - current field column of the figure box
+ * @param y - current field row of the figure box
+ * @param out - room for TETRIS_AI_MAX_PLACEMENTS placements
+ *
+ * @return Number of placements written to out
+ */
+int tetris_ai_placements(const TetrisState *state, int type, int rotation,
+                         int x, int y, TetrisPlacement *out) {
+  int count = 0;
+  for (int turn = 0; turn < ROTATIONS_COUNT; turn++) {
+    int r = (rotation + turn) % ROTATIONS_COUNT;
+    const ShapeOrientation *shape = &shape_table[type][r];
+    if (turn && shape_collides(&state->board, shape, x, y)) break;
+
+    bool repeated = false;
+    for (int t = 0; t < turn && !repeated; t++) {
+      repeated = same_cells(
+          shape, &shape_table[type][(rotation + t) % ROTATIONS_COUNT]);
+    }
+    if (repeated) continue;
+
+    int left = x, right = x;
+    while (!shape_collides(&state->board, shape, left - 1, y)) left--;
+    while (!shape_collides(&state->board, shape, right + 1, y)) right++;
+    for (int column = left; column <= right; column++) {
+      out[count].rotation = r;
+      out[count].x = column;
+      out[count].y = shape_landing_row(state, shape, column, y);
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Locks a figure into the board and removes the rows it fills.
+ *
+ * Only the board, the column heights and, when a table is used, the board
+ * hash of the state are kept up to date, which is all the search reads.
+ *
+ * @return Number of cleared rows
+ */
+static int place(const TetrisAi *ai, TetrisState *state,
+                 const ShapeOrientation *shape,
+                 const TetrisPlacement *placement) {
+  Bitboard *board = &state->board;
+  int top = placement->y + shape->top, bottom = placement->y + shape->bottom;
+  if (ai->table) {
+    for (int y = top; y <= bottom; y++) {
+      state->hash ^= zobrist_row(y, board->rows[y]);
+    }
+  }
+  shape_place(board, shape, placement->x, placement->y);
+  int lines = bitboard_remove_full_rows(board, top, bottom);
+  if (ai->table && lines) {
+    state->hash = zobrist_board(board);
+  } else if (ai->table) {
+    for (int y = top; y <= bottom; y++) {
+      state->hash ^= zobrist_row(y, board->rows[y]);
+    }
+  }
+  bitboard_column_heights(board, state->heights);
+  return lines;
+}
+
+/**
+ * @brief Locks a figure into a search state and removes the rows it fills,
+ * as the planner does for every candidate.
+ *
+ * @param ai - the autoplayer, its table decides whether the hash is kept
+ * @param state - board, column heights and hash to update
+ * @param type - the figure
+ * @param placement - from tetris_ai_placements
+ *
+ * @return Number of cleared rows
+ */
+int tetris_ai_place(const TetrisAi *ai, TetrisState *state, int type,
+                    const TetrisPlacement *placement) {
+  return place(ai, state, &shape_table[type][placement->rotation],
+               placement);
+}
+
+/**
+ * @brief Sums up everything a cached value depends on besides the position,
+ * so players with other weights never share entries.
+ */
+static uint64_t weights_salt(const TetrisAi *ai) {
+  uint64_t salt = ai->lookahead;
+  const double values[] = {
+      ai->weights.lines,           ai->weights.height,
+      ai->weights.holes,           ai->weights.bumpiness,
+      ai->weights.row_transitions, ai->weights.column_transitions,
+      ai->weights.wells};
+  for (int i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++) {
+    uint64_t bits;
+    memcpy(&bits, &values[i], sizeof(bits));
+    salt = (salt ^ bits) * 0x100000001B3ull;
+  }
+  return salt;
+}
+
+/**
+ * @brief Looks a position up in the table, counting hits and misses.
+ */
+static bool probe(TetrisAi *ai, uint64_t key, TTableEntry *entry) {
+  bool hit = ai->table && ttable_probe(ai->table, key, entry);
+  if (hit) {
+    ai->table_hits++;
+  } else if (ai->table) {
+    ai->table_misses++;
+  }
+  return hit;
+}
+
+/**
+ * @brief Weighs measured board features and the cleared lines.
+ */
+static double weigh(const TetrisAiWeights *weights,
+                    const BoardFeatures *features, int lines) {
+  return weights->lines * lines + weights->height * features->aggregate_height +
+         weights->holes * features->holes +
+         weights->bumpiness * features->bumpiness +
+         weights->row_transitions * features->row_transitions +
+         weights->column_transitions * features->column_transitions +
+         weights->wells * features->wells;
+}
+
+/**
+ * @brief Scores a board with the cleared lines that led to it.
+ *
+ * @param weights - the feature weights
+ * @param state - board after the placement
+ * @param lines - lines cleared on the way to the board
+ *
+ * @return Higher is better
+ */
+double tetris_ai_evaluate(const TetrisAiWeights *weights,
+                          const TetrisState *state, int lines) {
+  BoardFeatures features;
+  board_features(&state->board, &features);
+  return weigh(weights, &features, lines);
+}
+
+/**
+ * @brief Best score of the preview piece on a board, the lines it clears
+ * included.
+ *
+ * The boards the preview piece leaves are measured a batch at a time, which
+ * the AVX2 kernel does for all of them at once. The result depends on the
+ * board and the preview piece only, so it is cached under the board hash.
+ * It is rounded to float whether it comes from the table or not, so a
+ * table never changes which move is chosen.
+ */
+static double preview_score(TetrisAi *ai, const TetrisState *state,
+                            int next_type, uint64_t salt) {
+  TTableEntry entry = {0};
+  uint64_t key = ttable_key(state->hash, TTABLE_PREVIEW, 0, next_type, salt);
+  if (!probe(ai, key, &entry)) {
+    double best = AI_LOSS;
+    TetrisPlacement placements[TETRIS_AI_MAX_PLACEMENTS];
+    int count = tetris_ai_placements(state, next_type, 0, START_POS_FIGURE_X,
+                                     START_POS_FIGURE_Y, placements);
+    BoardBatch batch;
+    BoardFeatures features[BOARD_BATCH_SIZE];
+    int cleared[BOARD_BATCH_SIZE];
+    for (int first = 0; first < count; first += BOARD_BATCH_SIZE) {
+      int size = count - first < BOARD_BATCH_SIZE ? count - first
+                                                  : BOARD_BATCH_SIZE;
+      for (int i = 0; i < size; i++) {
+        const TetrisPlacement *placement = &placements[first + i];
+        const ShapeOrientation *shape =
+            &shape_table[next_type][placement->rotation];
+        Bitboard child = state->board;
+        shape_place(&child, shape, placement->x, placement->y);
+        cleared[i] =
+            bitboard_remove_full_rows(&child, placement->y + shape->top,
+                                      placement->y + shape->bottom);
+        board_batch_set(&batch, i, &child);
+      }
+      board_features_batch(&batch, size, features);
+      for (int i = 0; i < size; i++) {
+        double score = weigh(&ai->weights, &features[i], cleared[i]);
+        if (score > best) best = score;
+      }
+    }
+    ai->evaluated += count;
+    entry.score = (float)best;
+    if (ai->table) ttable_store(ai->table, key, &entry);
+  }
+  return entry.score;
+}
+
+/**
+ * @brief Scores the board after the current piece, placing the preview
+ * piece first when the lookahead is on.
+ */
+static double score_placement(TetrisAi *ai, const TetrisState *state,
+                              int next_type, int lines, uint64_t salt) {
+  double score = AI_LOSS;
+  if (shape_spawn_blocked(&state->board, next_type)) {
+    score = AI_LOSS;
+  } else if (ai->lookahead) {
+    score = ai->weights.lines * lines +
+            preview_score(ai, state, next_type, salt);
+  } else {
+    ai->evaluated++;
+    score = tetris_ai_evaluate(&ai->weights, state, lines);
+  }
+  return score;
+}
+
+/**
+ * @brief Finds the best placement of the falling tetromino and the inputs
+ * that lead there.
+ *
+ * Every reachable placement of the tetromino is tried, and with the
+ * lookahead every reachable placement of the preview piece on each result.
+ * The moves are the rotations, the shifts and a hard drop, to be fed to
+ * get_signal in order. With a table, plans for a tetromino at its spawn
+ * position and the preview scores are shared with other searches.
+ *
+ * @param ai - pointer to the autoplayer, receives the moves
+ * @param tet - the falling tetromino
+ * @param game_info - the game it falls in
+ *
+ * @return Number of moves in ai->moves
+ */
+int tetris_ai_plan(TetrisAi *ai, const Tetromino *tet,
+                   const GameInfo *game_info) {
+  const TetrisState *state = game_info->tetris;
+  uint64_t salt = ai->table ? weights_salt(ai) : 0;
+  bool at_spawn = tet->rotation == 0 && tet->coord.x == START_POS_FIGURE_X &&
+                  tet->coord.y == START_POS_FIGURE_Y;
+  uint64_t key =
+      ttable_key(state->hash, TTABLE_PLAN, tet->type, tet->next_type, salt);
+  TetrisPlacement best = {tet->rotation, tet->coord.x, tet->coord.y};
+  TTableEntry entry;
+
+  if (ai->table) ttable_age(ai->table);
+  if (at_spawn && probe(ai, key, &entry)) {
+    best.rotation = entry.rotation;
+    best.x = entry.x;
+    best.y = entry.y;
+  } else {
+    TetrisPlacement placements[TETRIS_AI_MAX_PLACEMENTS];
+    int count = tetris_ai_placements(state, tet->type, tet->rotation,
+                                     tet->coord.x, tet->coord.y, placements);
+    double best_score = AI_LOSS;
+    for (int i = 0; i < count; i++) {
+      TetrisState child = *state;
+      const ShapeOrientation *shape =
+          &shape_table[tet->type][placements[i].rotation];
+      int lines = place(ai, &child, shape, &placements[i]);
+      double score =
+          score_placement(ai, &child, tet->next_type, lines, salt);
+      if (i == 0 || score > best_score) {
+        best_score = score;
+        best = placements[i];
+      }
+    }
+    if (at_spawn && ai->table) {
+      entry.score = (float)best_score;
+      entry.rotation = (int8_t)best.rotation;
+      entry.x = (int8_t)best.x;
+      entry.y = (int8_t)best.y;
+      ttable_store(ai->table, key, &entry);
+    }
+  }
+
+  return tetris_ai_moves(ai, tet, &best);
+}
+
+/**
+ * @brief Writes the inputs that bring the falling tetromino to a placement:
+ * the rotations, the shifts and a hard drop, to be fed to get_signal in
+ * order.
+ *
+ * @param ai - pointer to the autoplayer, receives the moves
+ * @param tet - the falling tetromino
+ * @param target - a placement from tetris_ai_placements
+ *
+ * @return Number of moves in ai->moves
+ */
+int tetris_ai_moves(TetrisAi *ai, const Tetromino *tet,
+                    const TetrisPlacement *target) {
+  ai->move_count = 0;
+  int turns = (target->rotation - tet->rotation + ROTATIONS_COUNT) %
+              ROTATIONS_COUNT;
+  for (int i = 0; i < turns; i++) ai->moves[ai->move_count++] = Action;
+  for (int x = tet->coord.x; x != target->x; x += x < target->x ? 1 : -1) {
+    ai->moves[ai->move_count++] = x < target->x ? Right : Left;
+  }
+  ai->moves[ai->move_count++] = Up;
+  return ai->move_count;
+}
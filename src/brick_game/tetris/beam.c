@@ -0,0 +1,520 @@
+#include "../../inc/tetris/beam.h"
+
+#include <float.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** @file */
+
+// Score of a position after which a piece cannot spawn
+#define BEAM_LOSS (-DBL_MAX)
+
+// Part of the time limit kept for waking the threads, the inputs and the
+// scheduler, so a plan ends before the limit and not just at it
+#define BEAM_MARGIN 0.2
+
+/**
+ * @brief A position in the beam and how the search got there
+ */
+typedef struct {
+  TetrisState state;
+  double gained;  // Weighted lines cleared on the way here
+  double score;   // gained and the score of the board
+  int root;       // First placement on the way here
+  int order;      // Parent and placement index, breaks score ties
+} BeamNode;
+
+/**
+ * @brief What one thread produces while a level is expanded, on its own
+ * cache lines
+ */
+typedef struct {
+  _Alignas(64) BeamNode *children;
+  int count;
+  long evaluated;
+  long nodes;
+} BeamWorker;
+
+/**
+ * @brief Where a child is and what it is ranked by
+ */
+typedef struct {
+  double score;
+  int order;
+  int worker;
+  int index;
+} BeamKey;
+
+/**
+ * @brief A started thread and the slot it works in
+ */
+typedef struct {
+  TetrisBeam *beam;
+  int index;
+} BeamThread;
+
+typedef enum { BEAM_EXPAND, BEAM_AVERAGE } BeamJob;
+
+struct TetrisBeam {
+  TetrisBeamConfig config;
+  TetrisAi searcher;  // Weights of the plan, without a table
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;  // A job is posted or the threads must quit
+  pthread_cond_t idle;  // The last thread finished the job
+  pthread_t *threads;
+  BeamThread *thread_slots;
+  int thread_count;  // Started threads, the caller works too
+  unsigned job_id;   // Bumped for every posted job
+  int busy;          // Started threads still on the job
+  bool quit;
+
+  BeamJob job;
+  int type;       // Figure placed by the level
+  int next_type;  // Figure that must still spawn, -1 if unknown
+  bool first;     // The level places the falling piece
+  BeamNode *beam;
+  int beam_count;
+  _Atomic int next_node;
+  _Atomic bool stopped;
+  long long deadline_ns;  // Limit less the margin, 0 for no limit
+  BeamWorker *workers;    // One per thread, the caller first
+
+  BeamNode *kept;  // Room for config.width positions
+  BeamKey *keys;   // Room for the children of a whole level
+  long long sort_ns;  // Slowest ranking of one child in this plan
+  TetrisPlacement roots[TETRIS_AI_MAX_PLACEMENTS];
+  TetrisBeamStats stats;
+};
+
+static long long now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long long)now.tv_sec * 1000000000ll + now.tv_nsec;
+}
+
+/**
+ * @brief Settings that keep a plan well inside one frame of game_loop: the
+ * full depth, a beam of 32 positions on two threads and a quarter of the
+ * frame.
+ *
+ * @param config - receives the settings
+ */
+void tetris_beam_default_config(TetrisBeamConfig *config) {
+  config->depth = TETRIS_BEAM_MAX_DEPTH;
+  config->width = 32;
+  config->threads = 2;
+  config->time_limit_ms = TETRIS_BEAM_TICK_MS / 4.0;
+}
+
+/**
+ * @brief Tells whether a position goes before another one in the beam:
+ * higher scores first, ties in the order they were generated.
+ */
+static int compare_keys(const void *a, const void *b) {
+  const BeamKey *left = a, *right = b;
+  int result = 0;
+  if (left->score != right->score) {
+    result = left->score > right->score ? -1 : 1;
+  } else {
+    result = left->order < right->order ? -1 : left->order > right->order;
+  }
+  return result;
+}
+
+/**
+ * @brief Tells whether the level, and the ranking after it, would end
+ * after the deadline, and stops the level if so.
+ *
+ * It reads the clock, so it is checked after every placement and a level
+ * stops part way through a position.
+ */
+static bool out_of_time(TetrisBeam *beam) {
+  bool late = atomic_load_explicit(&beam->stopped, memory_order_relaxed);
+  if (!late && beam->deadline_ns) {
+    long long ranking =
+        beam->job == BEAM_EXPAND
+            ? beam->sort_ns * beam->beam_count * TETRIS_AI_MAX_PLACEMENTS
+            : beam->sort_ns * beam->beam_count;
+    late = now_ns() + ranking > beam->deadline_ns;
+    if (late) atomic_store_explicit(&beam->stopped, true, memory_order_relaxed);
+  }
+  return late;
+}
+
+/**
+ * @brief Places the figure of the level in every reachable way on one
+ * position and scores the results.
+ */
+static void expand_node(TetrisBeam *beam, int index, BeamWorker *worker) {
+  const BeamNode *node = &beam->beam[index];
+  const TetrisState *state = &node->state;
+  const TetrisAiWeights *weights = &beam->searcher.weights;
+  TetrisPlacement placements[TETRIS_AI_MAX_PLACEMENTS];
+  int count = 0;
+  if (beam->first) {
+    count = TETRIS_AI_MAX_PLACEMENTS;
+    memcpy(placements, beam->roots, sizeof(placements));
+    while (count && beam->roots[count - 1].rotation < 0) count--;
+  } else {
+    count = tetris_ai_placements(state, beam->type, 0, START_POS_FIGURE_X,
+                                 START_POS_FIGURE_Y, placements);
+  }
+
+  int i = 0;
+  for (; i < count && !out_of_time(beam); i++) {
+    BeamNode *child = &worker->children[worker->count];
+    child->state = *state;
+    int lines =
+        tetris_ai_place(&beam->searcher, &child->state, beam->type,
+                        &placements[i]);
+    if (beam->next_type < 0 ||
+        !shape_spawn_blocked(&child->state.board, beam->next_type)) {
+      child->gained = node->gained + weights->lines * lines;
+      child->score =
+          child->gained + tetris_ai_evaluate(weights, &child->state, 0);
+      child->root = beam->first ? i : node->root;
+      child->order = index * TETRIS_AI_MAX_PLACEMENTS + i;
+      worker->count++;
+    }
+  }
+  worker->evaluated += i;
+}
+
+/**
+ * @brief Scores a position by the best placement of every figure that can
+ * come next, averaged over the figures.
+ */
+static void average_node(TetrisBeam *beam, int index, BeamWorker *worker) {
+  BeamNode *node = &beam->beam[index];
+  const TetrisAiWeights *weights = &beam->searcher.weights;
+  double sum = 0;
+  bool lost = false;
+  for (int type = 0; type < FIGURES_COUNT && !lost; type++) {
+    lost = shape_spawn_blocked(&node->state.board, type);
+    TetrisPlacement placements[TETRIS_AI_MAX_PLACEMENTS];
+    int count = lost ? 0
+                     : tetris_ai_placements(&node->state, type, 0,
+                                            START_POS_FIGURE_X,
+                                            START_POS_FIGURE_Y, placements);
+    double best = BEAM_LOSS;
+    int i = 0;
+    for (; i < count && !out_of_time(beam); i++) {
+      TetrisState child = node->state;
+      int lines = tetris_ai_place(&beam->searcher, &child, type,
+                                  &placements[i]);
+      double score = tetris_ai_evaluate(weights, &child, lines);
+      if (score > best) best = score;
+    }
+    worker->evaluated += i;
+    lost = lost || !count;
+    sum += best;
+  }
+  node->score = lost ? BEAM_LOSS : node->gained + sum / FIGURES_COUNT;
+}
+
+/**
+ * @brief Takes positions of the posted job until none are left or the
+ * time runs out.
+ */
+static void run_job(TetrisBeam *beam, BeamWorker *worker) {
+  int index = 0;
+  while (!out_of_time(beam) &&
+         (index = atomic_fetch_add_explicit(&beam->next_node, 1,
+                                            memory_order_relaxed)) <
+             beam->beam_count) {
+    if (beam->job == BEAM_EXPAND) {
+      expand_node(beam, index, worker);
+    } else {
+      average_node(beam, index, worker);
+    }
+    worker->nodes++;
+  }
+}
+
+/**
+ * @brief Body of a started thread: waits for jobs and works on them.
+ */
+static void *beam_thread(void *arg) {
+  BeamThread *slot = arg;
+  TetrisBeam *beam = slot->beam;
+  pthread_mutex_lock(&beam->lock);
+  unsigned seen = 0;
+  while (!beam->quit) {
+    while (beam->job_id == seen && !beam->quit) {
+      pthread_cond_wait(&beam->wake, &beam->lock);
+    }
+    if (!beam->quit) {
+      seen = beam->job_id;
+      pthread_mutex_unlock(&beam->lock);
+      run_job(beam, &beam->workers[slot->index]);
+      pthread_mutex_lock(&beam->lock);
+      if (--beam->busy == 0) pthread_cond_signal(&beam->idle);
+    }
+  }
+  pthread_mutex_unlock(&beam->lock);
+  return NULL;
+}
+
+/**
+ * @brief Works on the posted job with every thread and waits until all of
+ * them are done.
+ */
+static void run_level(TetrisBeam *beam, BeamJob job) {
+  beam->job = job;
+  atomic_store_explicit(&beam->next_node, 0, memory_order_relaxed);
+  for (int i = 0; i < beam->config.threads; i++) beam->workers[i].count = 0;
+  bool spread = beam->thread_count && beam->beam_count > 1;
+  if (spread) {
+    pthread_mutex_lock(&beam->lock);
+    beam->job_id++;
+    beam->busy = beam->thread_count;
+    pthread_cond_broadcast(&beam->wake);
+    pthread_mutex_unlock(&beam->lock);
+  }
+  run_job(beam, &beam->workers[0]);
+  if (spread) {
+    pthread_mutex_lock(&beam->lock);
+    while (beam->busy) pthread_cond_wait(&beam->idle, &beam->lock);
+    pthread_mutex_unlock(&beam->lock);
+  }
+}
+
+/**
+ * @brief Copies the best config.width children of all threads into the
+ * beam, or moves the best position of an averaged beam to its front.
+ *
+ * Only small keys are sorted, the positions are copied once. The time per
+ * ranked child is kept, so the time limit can leave room for ranking.
+ *
+ * @return Number of positions in the beam
+ */
+static int keep_best(TetrisBeam *beam, bool children) {
+  long long start = now_ns();
+  int count = 0;
+  for (int w = 0; children && w < beam->config.threads; w++) {
+    for (int i = 0; i < beam->workers[w].count; i++) {
+      const BeamNode *child = &beam->workers[w].children[i];
+      beam->keys[count++] = (BeamKey){child->score, child->order, w, i};
+    }
+  }
+  for (int i = 0; !children && i < beam->beam_count; i++) {
+    const BeamNode *node = &beam->beam[i];
+    beam->keys[count++] = (BeamKey){node->score, node->order, -1, i};
+  }
+  qsort(beam->keys, count, sizeof(BeamKey), compare_keys);
+  int ranked = count;
+
+  if (count > beam->config.width) count = beam->config.width;
+  if (children) {
+    for (int i = 0; i < count; i++) {
+      const BeamKey *key = &beam->keys[i];
+      beam->kept[i] = beam->workers[key->worker].children[key->index];
+    }
+  } else if (count) {
+    BeamNode best = beam->beam[beam->keys[0].index];
+    beam->beam[beam->keys[0].index] = beam->beam[0];
+    beam->beam[0] = best;
+  }
+  beam->beam = beam->kept;
+  beam->beam_count = count;
+
+  long long cost = (now_ns() - start) / (ranked ? ranked : 1);
+  if (cost > beam->sort_ns) beam->sort_ns = cost;
+  return count;
+}
+
+/**
+ * @brief Frees a search and everything it allocated so far.
+ */
+static void free_beam(TetrisBeam *beam) {
+  if (beam->workers) {
+    for (int i = 0; i < beam->config.threads; i++) {
+      free(beam->workers[i].children);
+    }
+  }
+  free(beam->workers);
+  free(beam->kept);
+  free(beam->keys);
+  free(beam->threads);
+  free(beam->thread_slots);
+  free(beam);
+}
+
+/**
+ * @brief Allocates a beam search and starts its threads.
+ *
+ * @param config - depth, width, threads and time limit, out of range values
+ * are clamped
+ *
+ * @return Pointer to the search, NULL if it cannot be allocated
+ */
+TetrisBeam *tetris_beam_create(const TetrisBeamConfig *config) {
+  TetrisBeam *beam = calloc(1, sizeof(TetrisBeam));
+  bool ok = beam != NULL;
+  if (ok) {
+    beam->config = *config;
+    if (beam->config.depth < 1) beam->config.depth = 1;
+    if (beam->config.depth > TETRIS_BEAM_MAX_DEPTH) {
+      beam->config.depth = TETRIS_BEAM_MAX_DEPTH;
+    }
+    if (beam->config.width < 1) beam->config.width = 1;
+    if (beam->config.threads < 1) beam->config.threads = 1;
+
+    int threads = beam->config.threads;
+    size_t room = (size_t)beam->config.width * TETRIS_AI_MAX_PLACEMENTS;
+    beam->workers =
+        aligned_alloc(_Alignof(BeamWorker), threads * sizeof(BeamWorker));
+    beam->kept = malloc(beam->config.width * sizeof(BeamNode));
+    beam->keys = malloc(room * threads * sizeof(BeamKey));
+    beam->threads = calloc(threads, sizeof(pthread_t));
+    beam->thread_slots = calloc(threads, sizeof(BeamThread));
+    ok = beam->workers && beam->kept && beam->keys && beam->threads &&
+         beam->thread_slots;
+    if (beam->workers) memset(beam->workers, 0, threads * sizeof(BeamWorker));
+    for (int i = 0; ok && i < threads; i++) {
+      beam->workers[i].children = malloc(room * sizeof(BeamNode));
+      ok = beam->workers[i].children != NULL;
+    }
+    if (!ok) {
+      free_beam(beam);
+      beam = NULL;
+    }
+  }
+  if (beam) {
+    pthread_mutex_init(&beam->lock, NULL);
+    pthread_cond_init(&beam->wake, NULL);
+    pthread_cond_init(&beam->idle, NULL);
+    for (int i = 1; i < beam->config.threads; i++) {
+      BeamThread *slot = &beam->thread_slots[beam->thread_count];
+      *slot = (BeamThread){beam, i};
+      if (!pthread_create(&beam->threads[beam->thread_count], NULL,
+                          beam_thread, slot)) {
+        beam->thread_count++;
+      }
+    }
+  }
+  return beam;
+}
+
+/**
+ * @brief Stops the threads of a search and frees it.
+ *
+ * @param beam - pointer to the search, may be NULL
+ */
+void tetris_beam_destroy(TetrisBeam *beam) {
+  if (beam) {
+    pthread_mutex_lock(&beam->lock);
+    beam->quit = true;
+    pthread_cond_broadcast(&beam->wake);
+    pthread_mutex_unlock(&beam->lock);
+    for (int i = 0; i < beam->thread_count; i++) {
+      pthread_join(beam->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&beam->lock);
+    pthread_cond_destroy(&beam->wake);
+    pthread_cond_destroy(&beam->idle);
+    free_beam(beam);
+  }
+}
+
+/**
+ * @brief Finds a placement of the falling tetromino with a beam search and
+ * the inputs that lead there.
+ *
+ * Every level places one piece on each position of the beam, the falling
+ * piece first and the preview piece second, and keeps the config.width
+ * best results. At depth 3 the positions of the last beam are scored by the
+ * best placement of every figure, averaged, since the piece after the
+ * preview is unknown. The positions of a level are shared by the threads.
+ *
+ * After every placement a thread checks that the ranking of the level
+ * still ends before the time limit, less a margin of BEAM_MARGIN of it.
+ * Otherwise the level is dropped, even part way through a position, and
+ * the best position of the last finished level is played. If the first
+ * level is dropped, the best of the placements it scored is played, or
+ * the first reachable one if it scored none.
+ *
+ * @param beam - the search
+ * @param ai - weights to score with, receives the moves and the count of
+ * scored placements
+ * @param tet - the falling tetromino
+ * @param game_info - the game it falls in
+ *
+ * @return Number of moves in ai->moves
+ */
+int tetris_beam_plan(TetrisBeam *beam, TetrisAi *ai, const Tetromino *tet,
+                     const GameInfo *game_info) {
+  long long start = now_ns();
+  beam->searcher = *ai;
+  beam->searcher.table = NULL;
+  beam->deadline_ns =
+      beam->config.time_limit_ms > 0
+          ? start + (long long)(beam->config.time_limit_ms *
+                                (1 - BEAM_MARGIN) * 1e6)
+          : 0;
+  atomic_store_explicit(&beam->stopped, false, memory_order_relaxed);
+  beam->sort_ns = 0;
+  for (int i = 0; i < beam->config.threads; i++) {
+    beam->workers[i].evaluated = 0;
+    beam->workers[i].nodes = 0;
+  }
+
+  memset(beam->roots, 0xFF, sizeof(beam->roots));
+  tetris_ai_placements(game_info->tetris, tet->type, tet->rotation,
+                       tet->coord.x, tet->coord.y, beam->roots);
+  TetrisPlacement best = beam->roots[0];
+
+  BeamNode *root = &beam->kept[0];
+  root->state = *game_info->tetris;
+  root->gained = 0;
+  root->root = 0;
+  root->order = 0;
+  beam->beam = root;
+  beam->beam_count = 1;
+
+  int level = 0;
+  bool finished = true;
+  while (finished && level < beam->config.depth && beam->beam_count) {
+    beam->first = level == 0;
+    beam->type = level == 0 ? tet->type : tet->next_type;
+    beam->next_type = level == 0 ? tet->next_type : -1;
+    run_level(beam, level < 2 ? BEAM_EXPAND : BEAM_AVERAGE);
+    finished = !atomic_load_explicit(&beam->stopped, memory_order_relaxed);
+    // Every child of a dropped first level is fully scored
+    if (finished || level == 0) keep_best(beam, level < 2);
+    if ((finished || level == 0) && beam->beam_count &&
+        beam->beam[0].score > BEAM_LOSS) {
+      best = beam->roots[beam->beam[0].root];
+    }
+    if (finished) level++;
+  }
+
+  for (int i = 0; i < beam->config.threads; i++) {
+    ai->evaluated += beam->workers[i].evaluated;
+    beam->stats.nodes += beam->workers[i].nodes;
+  }
+  int moves = tetris_ai_moves(ai, tet, &best);
+  double elapsed = (now_ns() - start) / 1e6;
+  beam->stats.plans++;
+  beam->stats.levels += level;
+  beam->stats.timeouts += !finished;
+  beam->stats.overruns +=
+      beam->config.time_limit_ms > 0 && elapsed > beam->config.time_limit_ms;
+  beam->stats.total_ms += elapsed;
+  if (elapsed > beam->stats.longest_ms) beam->stats.longest_ms = elapsed;
+  return moves;
+}
+
+/**
+ * @brief Copies the counters of all plans made so far.
+ *
+ * @param beam - the search
+ * @param stats - receives the counters
+ */
+void tetris_beam_stats(const TetrisBeam *beam, TetrisBeamStats *stats) {
+  *stats = beam->stats;
+}
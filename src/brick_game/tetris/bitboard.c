@@ -0,0 +1,161 @@
+#include "../../inc/tetris/bitboard.h"
+
+#include <string.h>
+
+/** @file */
+
+/**
+ * @brief Moves a figure row mask to column x of the field.
+ *
+ * @param mask figure row mask, bit c is box column c
+ * @param x field column of the box's left edge
+ * @param out the mask in field coordinates
+ *
+ * @return false if any cell of the row ends up outside the field walls
+ */
+static bool shift_piece_row(BoardRow mask, int x, BoardRow *out) {
+  bool inside = true;
+  if (x <= -MAX_FIGURE_SIZE || x >= TETRIS_W) {
+    inside = false;
+  } else if (x < 0) {
+    inside = !(mask & (BoardRow)(BOARD_BIT(-x) - 1u));
+    *out = (BoardRow)(mask >> -x);
+  } else {
+    inside = !(mask & (BoardRow)~(BOARD_FULL_ROW >> x));
+    *out = (BoardRow)(mask << x);
+  }
+  return inside;
+}
+
+/**
+ * @brief Empties every row of the board.
+ *
+ * @param board the board to clear
+ */
+void bitboard_clear(Bitboard *board) { memset(board, 0, sizeof(*board)); }
+
+/**
+ * @brief Rebuilds the board from an int field.
+ *
+ * Used when the field was filled through the GameInfo view directly, so the
+ * packed copy matches it again.
+ *
+ * @param board the board to fill
+ * @param field TETRIS_H rows of TETRIS_W cells, non-zero cells are filled
+ */
+void bitboard_load_field(Bitboard *board, int **field) {
+  for (int y = 0; y < TETRIS_H; y++) {
+    BoardRow row = 0;
+    for (int x = 0; x < TETRIS_W; x++) {
+      if (field[y][x]) row |= BOARD_BIT(x);
+    }
+    board->rows[y] = row;
+  }
+}
+
+/**
+ * @brief Checks whether a figure placed at (x, y) hits a wall, the floor or a
+ * filled cell.
+ *
+ * Each figure row is shifted to the field column and ANDed with the matching
+ * board row, so the check costs one operation per figure row.
+ *
+ * @param board the board to test against
+ * @param mask the packed figure
+ * @param x field column of the figure box
+ * @param y field row of the figure box
+ *
+ * @return true if the figure does not fit
+ */
+bool bitboard_collides(const Bitboard *board, const PieceMask *mask, int x,
+                       int y) {
+  bool collides = false;
+  for (int r = 0; r < MAX_FIGURE_SIZE && !collides; r++) {
+    if (mask->rows[r]) {
+      int y_field = y + r;
+      BoardRow shifted = 0;
+      if (y_field < 0 || y_field >= TETRIS_H ||
+          !shift_piece_row(mask->rows[r], x, &shifted)) {
+        collides = true;
+      } else {
+        collides = (shifted & board->rows[y_field]) != 0;
+      }
+    }
+  }
+  return collides;
+}
+
+/**
+ * @brief ORs a figure into the board. The figure must fit at (x, y).
+ *
+ * @param board the board to update
+ * @param mask the packed figure
+ * @param x field column of the figure box
+ * @param y field row of the figure box
+ */
+void bitboard_place(Bitboard *board, const PieceMask *mask, int x, int y) {
+  for (int r = 0; r < MAX_FIGURE_SIZE; r++) {
+    BoardRow shifted = 0;
+    if (mask->rows[r] && shift_piece_row(mask->rows[r], x, &shifted)) {
+      board->rows[y + r] |= shifted;
+    }
+  }
+}
+
+/**
+ * @brief Checks whether every cell of a row is filled.
+ *
+ * @param board the board to test
+ * @param y the row index
+ *
+ * @return true if the row is full
+ */
+bool bitboard_row_is_full(const Bitboard *board, int y) {
+  return board->rows[y] == BOARD_FULL_ROW;
+}
+
+/**
+ * @brief Removes the full rows among rows top to bottom and drops the rows
+ * above them, all on the packed words.
+ *
+ * @param board the board to update
+ * @param top the highest row to check
+ * @param bottom the lowest row to check
+ *
+ * @return the number of removed rows
+ */
+int bitboard_remove_full_rows(Bitboard *board, int top, int bottom) {
+  int removed = 0;
+  for (int y = top; y <= bottom; y++) removed += bitboard_row_is_full(board, y);
+  if (removed) {
+    int write = bottom;
+    for (int read = bottom; read >= 0; read--) {
+      if (read < top || !bitboard_row_is_full(board, read)) {
+        board->rows[write--] = board->rows[read];
+      }
+    }
+    for (; write >= 0; write--) board->rows[write] = 0;
+  }
+  return removed;
+}
+
+/**
+ * @brief Computes the height of every column, 0 for an empty column.
+ *
+ * Rows are scanned top-down as words, each column takes the height of the
+ * first row that has its bit set. The scan stops once every column is known.
+ *
+ * @param board the board to measure
+ * @param heights TETRIS_W heights to overwrite
+ */
+void bitboard_column_heights(const Bitboard *board, int8_t *heights) {
+  BoardRow seen = 0;
+  memset(heights, 0, TETRIS_W * sizeof(*heights));
+  for (int y = 0; y < TETRIS_H && seen != BOARD_FULL_ROW; y++) {
+    BoardRow first = (BoardRow)(board->rows[y] & ~seen);
+    for (int x = 0; first; x++, first >>= 1) {
+      if (first & 1u) heights[x] = (int8_t)(TETRIS_H - y);
+    }
+    seen |= board->rows[y];
+  }
+}
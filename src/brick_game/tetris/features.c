@@ -0,0 +1,143 @@
+#include "../../inc/tetris/features.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** @file */
+
+/**
+ * @brief Sums the height differences of neighbouring columns and the
+ * heights, which all kernels share.
+ */
+static void finish_heights(BoardFeatures *features) {
+  features->aggregate_height = 0;
+  features->bumpiness = 0;
+  for (int x = 0; x < TETRIS_W; x++) {
+    features->aggregate_height += features->heights[x];
+    if (x) {
+      features->bumpiness +=
+          (int16_t)abs(features->heights[x] - features->heights[x - 1]);
+    }
+  }
+}
+
+/**
+ * @brief Measures a board with word operations, one row at a time.
+ *
+ * A mask of the columns filled in any row above gives the holes and the
+ * wells, shifted copies of a row give its transitions, the walls count as
+ * filled cells.
+ *
+ * @param board the board to measure
+ * @param features receives the measurements
+ */
+void board_features_scalar(const Bitboard *board, BoardFeatures *features) {
+  BoardRow covered = 0, previous = 0;
+  int holes = 0, row_transitions = 0, column_transitions = 0, wells = 0;
+  for (int y = 0; y < TETRIS_H; y++) {
+    BoardRow row = board->rows[y];
+    covered |= row;
+    holes += BOARD_ROW_COUNT((BoardRow)(covered & ~row));
+    row_transitions +=
+        BOARD_ROW_COUNT((BoardRow)((row ^ row >> 1) & BOARD_FULL_ROW >> 1)) +
+        !(row & 1u) + !(row & BOARD_BIT(TETRIS_W - 1));
+    column_transitions += BOARD_ROW_COUNT((BoardRow)(row ^ previous));
+    BoardRow sides =
+        (BoardRow)((row << 1 | 1u) & (row >> 1 | BOARD_BIT(TETRIS_W - 1)));
+    wells += BOARD_ROW_COUNT((BoardRow)(sides & ~covered & BOARD_FULL_ROW));
+    previous = row;
+  }
+  column_transitions += BOARD_ROW_COUNT((BoardRow)(previous ^ BOARD_FULL_ROW));
+
+  bitboard_column_heights(board, features->heights);
+  features->holes = (int16_t)holes;
+  features->row_transitions = (int16_t)row_transitions;
+  features->column_transitions = (int16_t)column_transitions;
+  features->wells = (int16_t)wells;
+  finish_heights(features);
+}
+
+/**
+ * @brief Measures a board cell by cell from an int field.
+ *
+ * This is the straightforward nested loop over field[y][x] the kernels are
+ * checked and benchmarked against.
+ *
+ * @param field TETRIS_H rows of TETRIS_W cells, nonzero is filled
+ * @param features receives the measurements
+ */
+void board_features_reference(int **field, BoardFeatures *features) {
+  memset(features, 0, sizeof(*features));
+  for (int x = 0; x < TETRIS_W; x++) {
+    bool covered = false;
+    for (int y = 0; y < TETRIS_H; y++) {
+      bool filled = field[y][x] != 0;
+      bool above = y > 0 && field[y - 1][x] != 0;
+      bool left = x == 0 || field[y][x - 1] != 0;
+      bool right = x == TETRIS_W - 1 || field[y][x + 1] != 0;
+      if (filled && !covered) features->heights[x] = (int8_t)(TETRIS_H - y);
+      if (!filled && covered) features->holes++;
+      if (!filled && !covered && left && right) features->wells++;
+      if (filled != above) features->column_transitions++;
+      if (filled != left) features->row_transitions++;
+      if (x == TETRIS_W - 1 && !filled) features->row_transitions++;
+      covered = covered || filled;
+    }
+    if (!field[TETRIS_H - 1][x]) features->column_transitions++;
+  }
+  finish_heights(features);
+}
+
+/**
+ * @brief Copies a board into one slot of a batch.
+ *
+ * @param batch the batch
+ * @param index the slot, below BOARD_BATCH_SIZE
+ * @param board the board
+ */
+void board_batch_set(BoardBatch *batch, int index, const Bitboard *board) {
+  for (int y = 0; y < TETRIS_H; y++) batch->rows[y][index] = board->rows[y];
+}
+
+/**
+ * @brief Measures the first count boards of a batch one after another.
+ */
+void board_features_batch_scalar(const BoardBatch *batch, int count,
+                                 BoardFeatures *features) {
+  for (int i = 0; i < count; i++) {
+    Bitboard board;
+    for (int y = 0; y < TETRIS_H; y++) board.rows[y] = batch->rows[y][i];
+    board_features_scalar(&board, &features[i]);
+  }
+}
+
+/**
+ * @brief Measures a board with the fastest kernel this CPU runs.
+ *
+ * @param board the board to measure
+ * @param features receives the measurements
+ */
+void board_features(const Bitboard *board, BoardFeatures *features) {
+  if (board_features_avx2_supported()) {
+    board_features_avx2(board, features);
+  } else {
+    board_features_scalar(board, features);
+  }
+}
+
+/**
+ * @brief Measures the first count boards of a batch with the fastest kernel
+ * this CPU runs.
+ *
+ * @param batch the boards
+ * @param count boards to measure, at most BOARD_BATCH_SIZE
+ * @param features receives count measurements
+ */
+void board_features_batch(const BoardBatch *batch, int count,
+                          BoardFeatures *features) {
+  if (board_features_avx2_supported()) {
+    board_features_batch_avx2(batch, count, features);
+  } else {
+    board_features_batch_scalar(batch, count, features);
+  }
+}
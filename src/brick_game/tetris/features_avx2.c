@@ -0,0 +1,259 @@
+#include "../../inc/tetris/features.h"
+
+/** @file */
+
+#if (defined(__x86_64__) || defined(__i386__)) && BOARD_FEATURES_AVX2
+
+#include <immintrin.h>
+
+#define AVX2 __attribute__((target("avx2,popcnt")))
+
+/**
+ * @brief Tells whether the CPU runs the AVX2 kernels.
+ */
+bool board_features_avx2_supported(void) {
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+}
+
+/**
+ * @brief Bit count of every 16-bit lane, from a nibble lookup table.
+ */
+AVX2 static __m256i popcount16(__m256i value) {
+  const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3,
+                                         2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3,
+                                         1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  __m256i bytes = _mm256_add_epi8(
+      _mm256_shuffle_epi8(table, _mm256_and_si256(value, nibble)),
+      _mm256_shuffle_epi8(table,
+                          _mm256_and_si256(_mm256_srli_epi16(value, 4),
+                                           nibble)));
+  return _mm256_add_epi16(_mm256_and_si256(bytes, _mm256_set1_epi16(0xFF)),
+                          _mm256_srli_epi16(bytes, 8));
+}
+
+/**
+ * @brief Sum of all sixteen 16-bit lanes.
+ */
+AVX2 static int sum16(__m256i value) {
+  __m256i pairs = _mm256_madd_epi16(value, _mm256_set1_epi16(1));
+  __m128i half = _mm_add_epi32(_mm256_castsi256_si128(pairs),
+                               _mm256_extracti128_si256(pairs, 1));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+  return _mm_cvtsi128_si32(half);
+}
+
+// Lane i moves to lane i + k, the lowest k lanes become 0, k below 8
+#define SHIFT_LANES_UP(value, k)                                  \
+  _mm256_alignr_epi8((value),                                     \
+                     _mm256_permute2x128_si256((value), (value), 0x08), \
+                     16 - 2 * (k))
+
+/**
+ * @brief ORs every lane into all lanes after it.
+ */
+AVX2 static __m256i prefix_or(__m256i value) {
+  value = _mm256_or_si256(value, SHIFT_LANES_UP(value, 1));
+  value = _mm256_or_si256(value, SHIFT_LANES_UP(value, 2));
+  value = _mm256_or_si256(value, SHIFT_LANES_UP(value, 4));
+  return _mm256_or_si256(value,
+                         _mm256_permute2x128_si256(value, value, 0x08));
+}
+
+/**
+ * @brief Row and well terms of the rows in one vector, see
+ * board_features_scalar.
+ */
+AVX2 static void row_terms(__m256i rows, __m256i covered, __m256i valid,
+                           __m256i *holes, __m256i *row_transitions,
+                           __m256i *wells) {
+  const __m256i full = _mm256_set1_epi16(BOARD_FULL_ROW);
+  const __m256i left_wall = _mm256_set1_epi16(1);
+  const __m256i right_wall = _mm256_set1_epi16(1 << (TETRIS_W - 1));
+  const __m256i pairs = _mm256_set1_epi16((2 << TETRIS_W) - 1);
+
+  __m256i walled = _mm256_or_si256(
+      _mm256_slli_epi16(rows, 1),
+      _mm256_set1_epi16(1 | 1 << (TETRIS_W + 1)));
+  __m256i sides = _mm256_and_si256(
+      _mm256_or_si256(_mm256_slli_epi16(rows, 1), left_wall),
+      _mm256_or_si256(_mm256_srli_epi16(rows, 1), right_wall));
+  *holes = _mm256_andnot_si256(rows, covered);
+  *row_transitions = _mm256_and_si256(
+      _mm256_and_si256(_mm256_xor_si256(walled, _mm256_srli_epi16(walled, 1)),
+                       pairs),
+      valid);
+  *wells = _mm256_and_si256(_mm256_andnot_si256(covered, sides),
+                            _mm256_and_si256(full, valid));
+}
+
+/**
+ * @brief Measures one board with its rows spread over 16-bit lanes.
+ *
+ * Rows 0 to 15 fill one vector and rows 16 to 19 the low lanes of a second
+ * one. The covered mask is a prefix OR across lanes and every count is a
+ * lane-wise bit count. A column's height is the number of rows whose
+ * covered mask has its bit, taken from the lane sign bits.
+ *
+ * @param board the board to measure
+ * @param features receives the measurements
+ */
+AVX2 void board_features_avx2(const Bitboard *board,
+                              BoardFeatures *features) {
+  const __m256i valid_low = _mm256_set1_epi16(-1);
+  const __m256i valid_high = _mm256_setr_epi16(-1, -1, -1, -1, 0, 0, 0, 0,
+                                               0, 0, 0, 0, 0, 0, 0, 0);
+  __m256i low = _mm256_loadu_si256((const __m256i *)board->rows);
+  __m256i high = _mm256_castsi128_si256(
+      _mm_loadl_epi64((const __m128i *)(board->rows + 16)));
+
+  int last = _mm256_extract_epi16(low, 15);
+  __m256i covered_low = prefix_or(low);
+  __m256i covered_high = _mm256_and_si256(
+      _mm256_or_si256(prefix_or(high),
+                      _mm256_set1_epi16(
+                          (short)_mm256_extract_epi16(covered_low, 15))),
+      valid_high);
+
+  __m256i holes_low, holes_high, rows_low, rows_high, wells_low, wells_high;
+  row_terms(low, covered_low, valid_low, &holes_low, &rows_low, &wells_low);
+  row_terms(high, covered_high, valid_high, &holes_high, &rows_high,
+            &wells_high);
+  __m256i above_high =
+      _mm256_insert_epi16(SHIFT_LANES_UP(high, 1), (short)last, 0);
+  __m256i columns = _mm256_add_epi16(
+      popcount16(_mm256_xor_si256(low, SHIFT_LANES_UP(low, 1))),
+      popcount16(
+          _mm256_and_si256(_mm256_xor_si256(high, above_high), valid_high)));
+
+  features->holes = (int16_t)sum16(_mm256_add_epi16(
+      popcount16(holes_low), popcount16(holes_high)));
+  features->row_transitions = (int16_t)sum16(
+      _mm256_add_epi16(popcount16(rows_low), popcount16(rows_high)));
+  features->wells = (int16_t)sum16(
+      _mm256_add_epi16(popcount16(wells_low), popcount16(wells_high)));
+  features->column_transitions = (int16_t)(
+      sum16(columns) + __builtin_popcount(
+                           (unsigned)board->rows[TETRIS_H - 1] ^
+                           BOARD_FULL_ROW));
+
+  for (int x = 0; x < TETRIS_W; x++) {
+    __m128i shift = _mm_cvtsi32_si128(15 - x);
+    unsigned bits =
+        (unsigned)_mm256_movemask_epi8(_mm256_sll_epi16(covered_low, shift));
+    unsigned bits_high =
+        (unsigned)_mm256_movemask_epi8(_mm256_sll_epi16(covered_high, shift));
+    features->heights[x] =
+        (int8_t)(__builtin_popcount(bits & 0xAAAAAAAAu) +
+                 __builtin_popcount(bits_high & 0xAAAAAAAAu));
+  }
+  features->aggregate_height = 0;
+  features->bumpiness = 0;
+  for (int x = 0; x < TETRIS_W; x++) {
+    features->aggregate_height += features->heights[x];
+    if (x) {
+      int step = features->heights[x] - features->heights[x - 1];
+      features->bumpiness += (int16_t)(step < 0 ? -step : step);
+    }
+  }
+}
+
+/**
+ * @brief Measures up to 16 boards at once, board i in lane i.
+ *
+ * Every row of the batch is one vector, so the rows are walked top to
+ * bottom once for all boards together, with one height counter vector per
+ * column.
+ *
+ * @param batch the boards
+ * @param count boards to measure, at most BOARD_BATCH_SIZE
+ * @param features receives count measurements
+ */
+AVX2 void board_features_batch_avx2(const BoardBatch *batch, int count,
+                                    BoardFeatures *features) {
+  const __m256i one = _mm256_set1_epi16(1);
+  const __m256i all = _mm256_set1_epi16(-1);
+  __m256i covered = _mm256_setzero_si256(), previous = covered;
+  __m256i holes = covered, rows = covered, columns = covered, wells = covered;
+  __m256i heights[TETRIS_W];
+  for (int x = 0; x < TETRIS_W; x++) heights[x] = _mm256_setzero_si256();
+
+  for (int y = 0; y < TETRIS_H; y++) {
+    __m256i row = _mm256_load_si256((const __m256i *)batch->rows[y]);
+    covered = _mm256_or_si256(covered, row);
+    __m256i hole, transition, well;
+    row_terms(row, covered, all, &hole, &transition, &well);
+    holes = _mm256_add_epi16(holes, popcount16(hole));
+    rows = _mm256_add_epi16(rows, popcount16(transition));
+    wells = _mm256_add_epi16(wells, popcount16(well));
+    columns = _mm256_add_epi16(
+        columns, popcount16(_mm256_xor_si256(row, previous)));
+    previous = row;
+    for (int x = 0; x < TETRIS_W; x++) {
+      heights[x] = _mm256_add_epi16(
+          heights[x],
+          _mm256_and_si256(
+              _mm256_srl_epi16(covered, _mm_cvtsi32_si128(x)), one));
+    }
+  }
+  columns = _mm256_add_epi16(
+      columns, popcount16(_mm256_xor_si256(
+                   previous, _mm256_set1_epi16(BOARD_FULL_ROW))));
+
+  __m256i aggregate = heights[0], bumpiness = _mm256_setzero_si256();
+  for (int x = 1; x < TETRIS_W; x++) {
+    aggregate = _mm256_add_epi16(aggregate, heights[x]);
+    bumpiness = _mm256_add_epi16(
+        bumpiness, _mm256_abs_epi16(_mm256_sub_epi16(heights[x],
+                                                     heights[x - 1])));
+  }
+
+  int16_t lanes[8][BOARD_BATCH_SIZE] __attribute__((aligned(32)));
+  int16_t column_lanes[TETRIS_W][BOARD_BATCH_SIZE] __attribute__((aligned(32)));
+  _mm256_store_si256((__m256i *)lanes[0], aggregate);
+  _mm256_store_si256((__m256i *)lanes[1], bumpiness);
+  _mm256_store_si256((__m256i *)lanes[2], holes);
+  _mm256_store_si256((__m256i *)lanes[3], rows);
+  _mm256_store_si256((__m256i *)lanes[4], columns);
+  _mm256_store_si256((__m256i *)lanes[5], wells);
+  for (int x = 0; x < TETRIS_W; x++) {
+    _mm256_store_si256((__m256i *)column_lanes[x], heights[x]);
+  }
+  for (int i = 0; i < count; i++) {
+    for (int x = 0; x < TETRIS_W; x++) {
+      features[i].heights[x] = (int8_t)column_lanes[x][i];
+    }
+    features[i].aggregate_height = lanes[0][i];
+    features[i].bumpiness = lanes[1][i];
+    features[i].holes = lanes[2][i];
+    features[i].row_transitions = lanes[3][i];
+    features[i].column_transitions = lanes[4][i];
+    features[i].wells = lanes[5][i];
+  }
+}
+
+#else
+
+/**
+ * @brief Tells whether the CPU runs the AVX2 kernels, never off x86 or on
+ * a board they are not built for.
+ */
+bool board_features_avx2_supported(void) { return false; }
+
+/**
+ * @brief Stands in for the AVX2 kernel off x86 and on other boards.
+ */
+void board_features_avx2(const Bitboard *board, BoardFeatures *features) {
+  board_features_scalar(board, features);
+}
+
+/**
+ * @brief Stands in for the AVX2 batch kernel off x86 and on other boards.
+ */
+void board_features_batch_avx2(const BoardBatch *batch, int count,
+                               BoardFeatures *features) {
+  board_features_batch_scalar(batch, count, features);
+}
+
+#endif
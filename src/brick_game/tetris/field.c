@@ -2,71 +2,204 @@
 #include "../../inc/tetris/tetris.h"
 #include "../../inc/game_common.h"
 
+#include <string.h>
+#include <time.h>
+
 /** @file */
 
 /**
  * @brief Updates the game state and handles all game logic.
  * @details This function updates the game state by spawning a new tetromino,
- * clearing any full lines, dropping any lines above the cleared ones, updating
- * the game score, and then updating the game speed based on the current level.
+ * clearing the full lines among the rows the placed tetromino covers while
+ * dropping the lines above them, updating the game score, and then updating
+ * the game speed based on the current level.
  *
  * @param tetromino - pointer to the Tetromino structure
  * @param game_info - pointer to the Game_Info structure
  */
 void game_update(Tetromino *tetromino, GameInfo *game_info) {
   spawn_new_figure(tetromino, game_info, figures);
-  int cleared = clear_line(game_info);
-  line_dropper(game_info);
+  int cleared = clear_placed_lines(game_info);
+  game_info->tetris->lines_cleared += cleared;
   score_update(game_info, cleared);
   level_speed_update(game_info);
 }
 /**
  * @brief Get a pointer to the game information structure
- * @details This function returns a pointer to the game information structure.
- *          It is a singleton, so it will only allocate memory for the structure
- *          on the first call and return the same pointer on subsequent calls.
+ * @details This function returns a pointer to a newly allocated game
+ *          information structure that reads and saves the high score file.
+ *          Pieces are seeded from the current time.
  * @return A pointer to the game information structure
  */
 GameInfo *get_game_info() {
-  GameInfo *game_info = calloc(1, sizeof(GameInfo));
+  GameInfo *game_info = create_game_info(TRUE);
+  if (game_info) tetris_seed(game_info, (uint64_t)time(NULL), FALSE);
+  return game_info;
+}
 
-  game_info->field = calloc(FIELD_H, sizeof(int **));
-  for (int i = 0; i < FIELD_H; i++) {
-    game_info->field[i] = calloc(FIELD_W, sizeof(int));
-  }
+/**
+ * @brief Allocates a game information structure with an empty field
+ * @details Headless games pass FALSE so that neither the start nor score
+ *          updates touch HIGH_SCORE_PATH; their high score starts at 0.
+ *          Pieces use TETRIS_DEFAULT_SEED until tetris_seed is called.
+ *          The structure, the field, the preview and the engine state are
+ *          one cache aligned block, free_game releases it.
+ * @param persist_high_score Whether the high score file is read and written
+ * @return A pointer to the game information structure, NULL if it cannot
+ *         be allocated
+ */
+GameInfo *create_game_info(bool persist_high_score) {
+  size_t size = (sizeof(TetrisGameBlock) + TETRIS_BLOCK_ALIGN - 1) /
+                TETRIS_BLOCK_ALIGN * TETRIS_BLOCK_ALIGN;
+  TetrisGameBlock *block = aligned_alloc(TETRIS_BLOCK_ALIGN, size);
+  return block ? init_game_info(block, persist_high_score) : NULL;
+}
 
-  game_info->next = calloc(MAX_FIGURE_SIZE, sizeof(int *));
+/**
+ * @brief Starts a new game in a block the caller owns
+ * @details Everything in the block is overwritten, so a block can be used
+ *          for game after game without allocating. The game is the one
+ *          create_game_info returns.
+ * @param block Storage of the game
+ * @param persist_high_score Whether the high score file is read and written
+ * @return The GameInfo of the block
+ */
+GameInfo *init_game_info(TetrisGameBlock *block, bool persist_high_score) {
+  memset(block, 0, sizeof(*block));
+  GameInfo *game_info = &block->game.info;
+
+  for (int i = 0; i < TETRIS_H; i++) {
+    block->field_rows[i] = block->game.field[i];
+  }
   for (int i = 0; i < MAX_FIGURE_SIZE; i++) {
-    game_info->next[i] = calloc(MAX_FIGURE_SIZE, sizeof(int));
+    block->next_rows[i] = block->game.next[i];
   }
+  game_info->field = block->field_rows;
+  game_info->next = block->next_rows;
+  game_info->tetris = &block->game.tetris;
 
-  game_info->high_score = get_high_score_from_file(HIGH_SCORE_PATH);
+  game_info->tetris->persist_high_score = persist_high_score;
+  game_info->tetris->placed_top = game_info->tetris->placed_bottom = -1;
+  tetris_seed(game_info, TETRIS_DEFAULT_SEED, FALSE);
+
+  if (persist_high_score) {
+    game_info->high_score = get_high_score_from_file(HIGH_SCORE_PATH);
+  }
   game_info->level = LEVEL_MIN;
   game_info->speed = SPEED_1;
   game_info->pause = NOT_STARTED;
+  game_info->tetris->changes.flags = CHANGED_EVERYTHING;
   return game_info;
 }
 
+/**
+ * @brief Copies a game and its falling piece
+ * @details The game must come from create_game_info or init_game_info, so
+ *          that all of it is one block. A line clear swaps the row pointers
+ *          of GameInfo::field, so the rows are copied again through them
+ *          and the snapshot holds the field in the order it is seen.
+ * @param game_info The game to copy
+ * @param tet Its falling piece
+ * @param snapshot Where the copy goes
+ */
+void tetris_snapshot_save(const GameInfo *game_info, const Tetromino *tet,
+                          TetrisSnapshot *snapshot) {
+  snapshot->game = ((const TetrisGameBlock *)game_info)->game;
+  for (int y = 0; y < TETRIS_H; y++) {
+    memcpy(snapshot->game.field[y], game_info->field[y],
+           TETRIS_W * sizeof(int));
+  }
+  snapshot->tetromino = *tet;
+}
+
+/**
+ * @brief Puts a game saved by tetris_snapshot_save back
+ * @details The snapshot may come from another game, the pointers of
+ *          game_info keep leading into its own block, row y of the field
+ *          to row y of the block again. The whole game is
+ *          marked as changed for renderers.
+ * @param game_info The game to overwrite, from create_game_info or
+ *          init_game_info
+ * @param tet Its falling piece
+ * @param snapshot The saved game
+ */
+void tetris_snapshot_restore(GameInfo *game_info, Tetromino *tet,
+                             const TetrisSnapshot *snapshot) {
+  TetrisGameBlock *block = (TetrisGameBlock *)game_info;
+  block->game = snapshot->game;
+  for (int i = 0; i < TETRIS_H; i++) {
+    block->field_rows[i] = block->game.field[i];
+  }
+  block->game.info.field = block->field_rows;
+  block->game.info.next = block->next_rows;
+  block->game.info.tetris = &block->game.tetris;
+  block->game.tetris.changes.flags |= CHANGED_EVERYTHING;
+  *tet = snapshot->tetromino;
+}
+
+/**
+ * @brief Rebuilds the packed board from GameInfo::field
+ * @details The engine keeps the board and the field in sync on its own. This
+ * is only needed after writing into game_info->field directly. The column
+ * heights and the board hash are measured again as well, and renderers are
+ * told to redraw the whole field.
+ * @param game_info A pointer to the game information structure
+ */
+void sync_board_with_field(GameInfo *game_info) {
+  bitboard_load_field(&game_info->tetris->board, game_info->field);
+  bitboard_column_heights(&game_info->tetris->board,
+                          game_info->tetris->heights);
+  game_info->tetris->hash = zobrist_board(&game_info->tetris->board);
+  game_info->tetris->changes.flags |= CHANGED_CELLS_ALL;
+}
+
+/**
+ * @brief Returns the Zobrist hash of the locked cells
+ * @details The hash is kept up to date as pieces lock and rows are removed,
+ * so reading it costs nothing. Equal boards have equal hashes in every game
+ * and every build, the falling tetromino is not part of it.
+ * @param game_info A pointer to the game information structure
+ * @return The board hash, 0 for an empty field
+ */
+uint64_t tetris_board_hash(const GameInfo *game_info) {
+  return game_info->tetris->hash;
+}
+
 /**
  * @brief Place a tetromino on the game field
  * @details This function takes a tetromino and the game information structure
  * as parameters. It checks if the tetromino is placed and if it is, it places
- * the tetromino on the game field. It loops over the figure and checks if the
- * given cell is a part of the tetromino (i.e., if the cell is not empty). If it
- * is, it places the cell on the game field by setting the corresponding cell in
- * the game information structure to 1.
+ * the tetromino on the game field. The figure mask is ORed into the packed
+ * board, then every cell that is a part of the tetromino is mirrored into the
+ * field by setting the corresponding cell in the game information structure
+ * to 1. Column heights grow to the highest new cell of each column, the key
+ * of every new cell is XORed into the board hash and the rows the tetromino
+ * covers are kept for clear_placed_lines. The new cells go into the change
+ * journal.
  * @param tetromino A pointer to the tetromino structure
  * @param game_info A pointer to the game information structure
  */
 void place_tetromino_on_field(Tetromino *tetromino, GameInfo *game_info) {
   if (tetromino->is_placed) {
-    for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
-      for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-        if (tetromino->figure[y][x]) {
+    const ShapeOrientation *shape = get_tetromino_shape(tetromino);
+    int8_t *heights = game_info->tetris->heights;
+    shape_place(&game_info->tetris->board, shape, tetromino->coord.x,
+                tetromino->coord.y);
+    game_info->tetris->placed_top = (int8_t)(tetromino->coord.y + shape->top);
+    game_info->tetris->placed_bottom =
+        (int8_t)(tetromino->coord.y + shape->bottom);
+    for (int y = shape->top; y <= shape->bottom; y++) {
+      for (int x = shape->row_offset[y]; x >= 0 && x < MAX_FIGURE_SIZE; x++) {
+        if ((shape->mask.rows[y] >> x) & 1u) {
           int y_field = tetromino->coord.y + y;
           int x_field = tetromino->coord.x + x;
 
           game_info->field[y_field][x_field] = 1;
+          journal_cell(&game_info->tetris->changes, x_field, y_field);
+          game_info->tetris->hash ^= zobrist_keys[y_field][x_field];
+          if (TETRIS_H - y_field > heights[x_field]) {
+            heights[x_field] = (int8_t)(TETRIS_H - y_field);
+          }
         }
       }
     }
@@ -74,82 +207,171 @@ void place_tetromino_on_field(Tetromino *tetromino, GameInfo *game_info) {
 }
 
 /**
- * @brief Clears full lines on the game field
- * @details This function takes a pointer to the game information structure as a
- *          parameter. It loops over the game field and checks for each row
- *          if it is full (i.e., if none of the cells are empty). If a row is
- *          full, it clears the row by setting all cells to 0. The function
- *          returns the number of cleared rows.
+ * @brief Returns the index of the highest row with a filled cell
+ * @param tetris The engine state with up to date column heights
+ * @return The row index, TETRIS_H for an empty field
+ */
+static int highest_filled_row(const TetrisState *tetris) {
+  int height = 0;
+  for (int x = 0; x < TETRIS_W; x++) {
+    if (tetris->heights[x] > height) height = tetris->heights[x];
+  }
+  return TETRIS_H - height;
+}
+
+/**
+ * @brief Removes rows and lets the rows above them fall into their place
+ * @details One sweep from the lowest removed row up to the top of the stack
+ *          moves every kept row straight to its final place. The board moves
+ *          words and the field swaps row pointers, so no cell is copied. The
+ *          rows freed at the top of the stack are emptied afterwards. Only
+ *          the rows of the sweep change, so only their part of the board
+ *          hash is taken out before and put back after, and only they go
+ *          into the change journal.
  * @param game_info A pointer to the game information structure
- * @return The number of cleared rows
+ * @param removed Bit y is set for every row y to remove
+ * @param bottom The lowest removed row
+ * @param top The highest row with a filled cell
  */
-int clear_line(GameInfo *game_info) {
-  int line_counter = 0;
-  for (int y = 0; y < FIELD_H; y++) {
-    int line_incomplete = 0;
-    for (int x = 0; x < FIELD_W && !line_incomplete; x++) {
-      if (!game_info->field[y][x]) {
-        line_incomplete = 1;
+static void remove_rows(GameInfo *game_info, BoardRows removed, int bottom,
+                        int top) {
+  Bitboard *board = &game_info->tetris->board;
+  uint64_t *hash = &game_info->tetris->hash;
+  for (int y = top; y <= bottom; y++) *hash ^= zobrist_row(y, board->rows[y]);
+  int write = bottom;
+  for (int read = bottom; read >= top; read--) {
+    if (!((removed >> read) & 1u)) {
+      if (write != read) {
+        int *row = game_info->field[write];
+        board->rows[write] = board->rows[read];
+        game_info->field[write] = game_info->field[read];
+        game_info->field[read] = row;
       }
+      write--;
     }
-    if (!line_incomplete) {
-      for (int x = 0; x < FIELD_W; x++) {
-        game_info->field[y][x] = 0;
-      }
+  }
+  for (int y = write; y >= top; y--) {
+    board->rows[y] = 0;
+    memset(game_info->field[y], 0, TETRIS_W * sizeof(int));
+  }
+  for (int y = top; y <= bottom; y++) *hash ^= zobrist_row(y, board->rows[y]);
+  journal_rows(&game_info->tetris->changes, top, bottom);
+}
+
+/**
+ * @brief Clears the full rows in a range and drops the rows above them
+ * @details Only the rows from top to bottom are compared with the full row
+ *          mask. A cleared row is full, so it lies below the top cell of
+ *          every column, and each column height shrinks by the number of
+ *          cleared rows unless its top cell itself was cleared. Only then
+ *          are the heights measured again.
+ * @param game_info A pointer to the game information structure
+ * @param top The highest row to check
+ * @param bottom The lowest row to check
+ * @return The number of cleared rows
+ */
+static int clear_full_rows(GameInfo *game_info, int top, int bottom) {
+  TetrisState *tetris = game_info->tetris;
+  BoardRows removed = 0;
+  int line_counter = 0;
+  int lowest = -1;
+  if (top < 0) top = 0;
+  if (bottom >= TETRIS_H) bottom = TETRIS_H - 1;
+  for (int y = bottom; y >= top; y--) {
+    if (bitboard_row_is_full(&tetris->board, y)) {
+      removed |= (BoardRows)1 << y;
       line_counter++;
+      if (lowest < 0) lowest = y;
     }
   }
+
+  if (line_counter) {
+    bool measure = false;
+    remove_rows(game_info, removed, lowest, highest_filled_row(tetris));
+    for (int x = 0; x < TETRIS_W; x++) {
+      int top_row = TETRIS_H - tetris->heights[x];
+      measure = measure || (top_row < TETRIS_H && ((removed >> top_row) & 1u));
+      tetris->heights[x] = (int8_t)(tetris->heights[x] - line_counter);
+    }
+    if (measure) bitboard_column_heights(&tetris->board, tetris->heights);
+  }
   return line_counter;
 }
 
 /**
- * @brief Drops lines in the game field when a row is cleared.
- * @details This function iterates from the bottom of the game field to the top,
- *          checking each row to see if it is empty. If a row is empty, it
- * shifts all rows above it down by one. The operation continues until 100 line
- *          drops have been performed or the top of the field is reached.
+ * @brief Clears full lines among the rows the last placed tetromino covers
+ * @details A lock can only fill rows the tetromino covers, so no other row
+ *          is compared. The rows above the cleared ones drop in the same
+ *          pass, see remove_rows.
+ * @param game_info A pointer to the game information structure
+ * @return The number of cleared rows, for score_update
+ */
+int clear_placed_lines(GameInfo *game_info) {
+  TetrisState *tetris = game_info->tetris;
+  int line_counter = 0;
+  if (tetris->placed_top >= 0) {
+    line_counter =
+        clear_full_rows(game_info, tetris->placed_top, tetris->placed_bottom);
+    tetris->placed_top = tetris->placed_bottom = -1;
+  }
+  return line_counter;
+}
+
+/**
+ * @brief Clears full lines on the game field
+ * @details This function takes a pointer to the game information structure as a
+ *          parameter. It compares every row of the packed board with the full
+ *          row mask, removes the full rows and drops the rows above them.
+ *          The function returns the number of cleared rows.
+ * @param game_info A pointer to the game information structure
+ * @return The number of cleared rows
+ */
+int clear_line(GameInfo *game_info) {
+  return clear_full_rows(game_info, 0, TETRIS_H - 1);
+}
+
+/**
+ * @brief Drops lines in the game field over empty rows.
+ * @details Empty rows below the top of the stack only appear when the field
+ *          is written through GameInfo::field. Every such row is removed in
+ *          one sweep, see remove_rows, and the column heights are measured
+ *          again.
  * @param game_info A pointer to the game information structure.
  */
 void line_dropper(GameInfo *game_info) {
-  int counter = 100;
-  for (int y = FIELD_H - 1; y > 0 && counter; y--) {
-    int line_clear = 1;
-    for (int x = 0; x < FIELD_W && line_clear; x++) {
-      if (game_info->field[y][x]) {
-        line_clear = 0;
-      }
-    }
-    if (line_clear) {
-      for (int k = y; k > 0 && counter; k--) {
-        for (int x = 0; x < FIELD_W; x++) {
-          game_info->field[k][x] = game_info->field[k - 1][x];
-        }
-
-        counter--;
-      }
-      y++;
+  TetrisState *tetris = game_info->tetris;
+  int top = highest_filled_row(tetris);
+  BoardRows removed = 0;
+  int lowest = -1;
+  for (int y = TETRIS_H - 1; y > top; y--) {
+    if (!tetris->board.rows[y]) {
+      removed |= (BoardRows)1 << y;
+      if (lowest < 0) lowest = y;
     }
   }
+  if (removed) {
+    remove_rows(game_info, removed, lowest, top);
+    bitboard_column_heights(&tetris->board, tetris->heights);
+  }
 }
 
 /**
  * @brief Checks if the game is over by determining if the current tetromino can
  * spawn.
- * @details This function iterates over the tetromino's figure and checks if any
- * part of it overlaps with filled cells in the game field. If an overlap is
+ * @details This function tests the figure rows below the top one against the
+ * packed board. If any of them overlaps filled cells, i.e. an overlap is
  * detected, it sets the tetromino's can_spawn attribute to FALSE, indicating
  * that the game is over.
  * @param tetromino A pointer to the tetromino structure.
  * @param game_info A pointer to the game information structure.
  */
 void check_game_over(Tetromino *tetromino, GameInfo *game_info) {
-  for (int y = 1; y < MAX_FIGURE_SIZE; y++) {
-    for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-      if (game_info->field[tetromino->coord.y + y][tetromino->coord.x + x] &&
-          tetromino->figure[y][x]) {
-        tetromino->can_spawn = FALSE;
-        game_info->pause = LOSED;
-      }
-    }
+  PieceMask body = get_tetromino_shape(tetromino)->mask;
+  body.rows[0] = 0;
+  if (bitboard_collides(&game_info->tetris->board, &body, tetromino->coord.x,
+                        tetromino->coord.y)) {
+    tetromino->can_spawn = FALSE;
+    game_info->pause = LOSED;
+    game_info->tetris->changes.flags |= CHANGED_STATE;
   }
-}
\ No newline at end of file
+}
@@ -4,33 +4,50 @@
 /** @file */
 
 /**
- * @brief Set tetromino structure. If tetromino is NULL, allocates memory for
- * it, sets start position, sets type and next type of tetromino, allocates
- * memory for figure and sets it.
+ * @brief Lists the field cells the tetromino covers in the change journal.
  *
- * @param game_info - pointer to Game_Info structure
+ * Called before and after a move, so that a renderer redraws the cells the
+ * tetromino left as well as the ones it entered. Cells above the field are
+ * skipped.
  *
- * @return Pointer to Tetromino structure
+ * @param tet - pointer to the Tetromino structure
+ * @param game_info - pointer to the Game_Info structure
  */
-Tetromino *set_tetromino(GameInfo *game_info) {
-  Tetromino *tetromino = calloc(1, sizeof(Tetromino));
-
-  tetromino->type = generate_figure();
-  tetromino->next_type = generate_figure();
+static void journal_tetromino(const Tetromino *tet, GameInfo *game_info) {
+  const ShapeOrientation *shape = get_tetromino_shape(tet);
+  for (int y = shape->top; y <= shape->bottom; y++) {
+    int y_field = tet->coord.y + y;
+    for (int x = 0; y_field >= 0 && x < MAX_FIGURE_SIZE; x++) {
+      if ((shape->mask.rows[y] >> x) & 1u) {
+        journal_cell(&game_info->tetris->changes, tet->coord.x + x, y_field);
+      }
+    }
+  }
+}
 
-  stat_matrix_to_dyn(game_info->next, figures[tetromino->next_type]);
+/**
+ * @brief Set tetromino structure. Deals the first two pieces of the game,
+ * sets type and next type of tetromino and its start position.
+ *
+ * @param game_info - pointer to Game_Info structure
+ *
+ * @return The tetromino, nothing is allocated
+ */
+Tetromino set_tetromino(GameInfo *game_info) {
+  Tetromino tetromino = {0};
 
-  tetromino->figure = calloc(MAX_FIGURE_SIZE, sizeof(int *));
+  tetromino.type = generate_figure(game_info);
+  tetromino.next_type = generate_figure(game_info);
 
-  for (int row = 0; row < MAX_FIGURE_SIZE; row++) {
-    tetromino->figure[row] = calloc(MAX_FIGURE_SIZE, sizeof(int));
-  }
+  stat_matrix_to_dyn(game_info->next, figures[tetromino.next_type]);
+  game_info->tetris->changes.flags |= CHANGED_NEXT;
 
-  stat_matrix_to_dyn(tetromino->figure, figures[tetromino->type]);
-  set_start_position_for_tetromino(tetromino);
+  tetromino.rotation = 0;
+  set_start_position_for_tetromino(&tetromino);
+  journal_tetromino(&tetromino, game_info);
 
-  tetromino->is_placed = FALSE;
-  tetromino->can_spawn = TRUE;
+  tetromino.is_placed = FALSE;
+  tetromino.can_spawn = TRUE;
 
   return tetromino;
 }
@@ -55,25 +72,24 @@ void set_start_position_for_tetromino(Tetromino *tetromino) {
  * This function takes the previously generated tetromino and moves it to the
  * playing field. It then generates a new tetromino and assigns it to the
  * next_type field of the tetromino structure. The newly generated tetromino is
- * then set to the starting position and its is_spawned flag is reset.
+ * then set to the starting position and its is_spawned flag is reset. The
+ * preview and the cells of the new tetromino go into the change journal.
  *
  * @param tetromino - pointer to the Tetromino structure
  * @param game_info - pointer to the Game_Info structure
  * @param figures - array of figures
  */
 void generate_next_tetromino(Tetromino *tetromino, GameInfo *game_info,
-                             int figures[7][4][4]) {
+                             const int figures[7][4][4]) {
   tetromino->type = tetromino->next_type;
-  for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
-    for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-      tetromino->figure[y][x] = game_info->next[y][x];
-    }
-  }
+  tetromino->rotation = 0;
 
-  tetromino->next_type = generate_figure();
+  tetromino->next_type = generate_figure(game_info);
   stat_matrix_to_dyn(game_info->next, figures[tetromino->next_type]);
+  game_info->tetris->changes.flags |= CHANGED_NEXT;
 
   set_start_position_for_tetromino(tetromino);
+  journal_tetromino(tetromino, game_info);
 
   tetromino->is_placed = FALSE;
 }
@@ -94,7 +110,7 @@ void generate_next_tetromino(Tetromino *tetromino, GameInfo *game_info,
  * @param figures - array of figures
  */
 void spawn_new_figure(Tetromino *tetromino, GameInfo *game_info,
-                      int figures[7][4][4]) {
+                      const int figures[7][4][4]) {
   if (tetromino->is_placed && tetromino->can_spawn) {
     place_tetromino_on_field(tetromino, game_info);
     generate_next_tetromino(tetromino, game_info, figures);
@@ -102,6 +118,30 @@ void spawn_new_figure(Tetromino *tetromino, GameInfo *game_info,
   }
 }
 
+/**
+ * @brief Returns the precomputed orientation the tetromino is in.
+ *
+ * @param tetromino - pointer to the Tetromino structure
+ *
+ * @return Entry of shape_table for the tetromino's type and rotation
+ */
+const ShapeOrientation *get_tetromino_shape(const Tetromino *tetromino) {
+  return &shape_table[tetromino->type][tetromino->rotation];
+}
+
+/**
+ * @brief Tells whether a cell of the tetromino's 4x4 box is filled.
+ *
+ * @param tetromino - pointer to the Tetromino structure
+ * @param x - column inside the box
+ * @param y - row inside the box
+ *
+ * @return 1 for a filled cell, 0 otherwise
+ */
+int tetromino_cell(const Tetromino *tetromino, int x, int y) {
+  return (get_tetromino_shape(tetromino)->mask.rows[y] >> x) & 1u;
+}
+
 /**
  * @brief Moves a tetromino one row down.
  *
@@ -109,33 +149,20 @@ void spawn_new_figure(Tetromino *tetromino, GameInfo *game_info,
  * parameters. It checks if the tetromino can be moved one row down by checking
  * if the block below is empty and if the game is not paused. If the tetromino
  * can be moved, it moves it and if not, it sets the is_placed flag to TRUE.
+ * The cells it left and entered go into the change journal.
  *
  * @param tet - pointer to the Tetromino structure
  * @param game_info - pointer to the Game_Info structure
  */
 void move_tetromino_down_one_row(Tetromino *tet, GameInfo *game_info) {
-  int can_move = 1;
-  for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
-    for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-      if (tet->figure[y][x]) {
-        int y_block = tet->coord.y + y;
-        int x_block = tet->coord.x + x;
-        if (y_block + 1 > FIELD_H - 1 ||
-            game_info->field[y_block + 1][x_block] ||
-            game_info->pause == PAUSED) {
-          tet->is_placed = TRUE;
-          can_move = 0;
-          break;
-        }
-      }
-    }
-    if (!can_move) {
-      break;
-    }
-  }
-
-  if (can_move) {
+  if (game_info->pause == PAUSED ||
+      shape_collides(&game_info->tetris->board, get_tetromino_shape(tet),
+                     tet->coord.x, tet->coord.y + 1)) {
+    tet->is_placed = TRUE;
+  } else {
+    journal_tetromino(tet, game_info);
     tet->coord.y++;
+    journal_tetromino(tet, game_info);
   }
 }
 
@@ -154,6 +181,68 @@ void drop_tetromino(Tetromino *tet, GameInfo *game_info) {
   if (game_info->pause == STARTED) move_tetromino_down_one_row(tet, game_info);
 }
 
+/**
+ * @brief Drops the tetromino to where it lands and marks it as placed.
+ *
+ * @param tet - pointer to the Tetromino structure
+ * @param game_info - pointer to the Game_Info structure
+ */
+void hard_drop_tetromino(Tetromino *tet, GameInfo *game_info) {
+  if (game_info->pause == STARTED) {
+    journal_tetromino(tet, game_info);
+    tet->coord.y = tetromino_landing_row(tet, game_info);
+    journal_tetromino(tet, game_info);
+    tet->is_placed = TRUE;
+  }
+}
+
+/**
+ * @brief Finds the row an orientation placed at (x, y) falls to.
+ *
+ * While every column of the figure is above the top filled cell of its
+ * field column, the figure lands on the highest of those cells, which the
+ * column heights give without touching the board. A figure that is already
+ * below an overhang falls back to stepping down row by row.
+ *
+ * @param tetris - engine state with the board and the column heights
+ * @param shape - the orientation from shape_table, must fit at (x, y)
+ * @param x - field column of the figure box
+ * @param y - field row of the figure box
+ *
+ * @return Field row of the figure box after the drop
+ */
+int shape_landing_row(const TetrisState *tetris, const ShapeOrientation *shape,
+                      int x, int y) {
+  int landing = TETRIS_H;
+  bool above_stack = true;
+  for (int c = shape->left; c <= shape->right; c++) {
+    int bottom = shape->column_bottom[c];
+    if (bottom >= 0) {
+      int surface = TETRIS_H - tetris->heights[x + c];
+      if (surface - 1 - bottom < landing) landing = surface - 1 - bottom;
+      if (y + bottom >= surface) above_stack = false;
+    }
+  }
+  if (!above_stack) {
+    landing = y;
+    while (!shape_collides(&tetris->board, shape, x, landing + 1)) landing++;
+  }
+  return landing;
+}
+
+/**
+ * @brief Finds the row the tetromino would land on, e.g. for a ghost piece.
+ *
+ * @param tet - pointer to the Tetromino structure
+ * @param game_info - pointer to the Game_Info structure
+ *
+ * @return Field row of the tetromino box after a hard drop
+ */
+int tetromino_landing_row(const Tetromino *tet, const GameInfo *game_info) {
+  return shape_landing_row(game_info->tetris, get_tetromino_shape(tet),
+                           tet->coord.x, tet->coord.y);
+}
+
 /**
  * @brief Moves the tetromino one column to the left if the game is not paused.
  *
@@ -166,26 +255,12 @@ void drop_tetromino(Tetromino *tet, GameInfo *game_info) {
  * @param game_info - pointer to the Game_Info structure
  */
 void move_tetromino_left(Tetromino *tet, GameInfo *game_info) {
-  int can_move = 1;
-  for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
-    for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-      if (tet->figure[y][x]) {
-        int y_block = tet->coord.y + y;
-        int x_block = tet->coord.x + x;
-        if (x_block - 1 < 0 || game_info->field[y_block][x_block - 1] ||
-            game_info->pause == PAUSED) {
-          can_move = 0;
-          break;
-        }
-      }
-    }
-    if (!can_move) {
-      break;
-    }
-  }
-
-  if (can_move) {
+  if (game_info->pause != PAUSED &&
+      !shape_collides(&game_info->tetris->board, get_tetromino_shape(tet),
+                      tet->coord.x - 1, tet->coord.y)) {
+    journal_tetromino(tet, game_info);
     tet->coord.x--;
+    journal_tetromino(tet, game_info);
   }
 }
 
@@ -201,27 +276,12 @@ void move_tetromino_left(Tetromino *tet, GameInfo *game_info) {
  * @param game_info - pointer to the Game_Info structure
  */
 void move_tetromino_right(Tetromino *tet, GameInfo *game_info) {
-  int can_move = 1;
-  for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
-    for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-      if (tet->figure[y][x]) {
-        int y_block = tet->coord.y + y;
-        int x_block = tet->coord.x + x;
-        if (x_block + 1 > FIELD_W - 1 ||
-            game_info->field[y_block][x_block + 1] ||
-            game_info->pause == PAUSED) {
-          can_move = 0;
-          break;
-        }
-      }
-    }
-    if (!can_move) {
-      break;
-    }
-  }
-
-  if (can_move) {
+  if (game_info->pause != PAUSED &&
+      !shape_collides(&game_info->tetris->board, get_tetromino_shape(tet),
+                      tet->coord.x + 1, tet->coord.y)) {
+    journal_tetromino(tet, game_info);
     tet->coord.x++;
+    journal_tetromino(tet, game_info);
   }
 }
 
@@ -229,41 +289,22 @@ void move_tetromino_right(Tetromino *tet, GameInfo *game_info) {
  * @brief Rotates the tetromino clockwise if the game is not paused.
  *
  * This function rotates the tetromino clockwise if the game is not paused.
- * The tetromino will not be rotated if it is already at the edge of the field,
- * or if there is already a block in a position that the tetromino would occupy
- * after the rotation.
+ * The next orientation is taken from the precomputed shape_table, so a
+ * rotation is an index change plus one bitboard test. The tetromino will not
+ * be rotated if the turned figure would leave the field or overlap a block.
  *
  * @param tet - pointer to the Tetromino structure
  * @param game_info - pointer to the Game_Info structure
  */
 void rotate_tetromino(Tetromino *tet, GameInfo *game_info) {
-  int rotated[MAX_FIGURE_SIZE][MAX_FIGURE_SIZE];
-
-  int can_rotate = 1;
-  for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
-    for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-      rotated[y][x] = tet->figure[4 - x - 1][y];
-    }
-  }
-
-  for (int y = 0; y < MAX_FIGURE_SIZE && can_rotate; y++) {
-    for (int x = 0; x < MAX_FIGURE_SIZE && can_rotate; x++) {
-      if (rotated[y][x]) {
-        int y_block = tet->coord.y + y;
-        int x_block = tet->coord.x + x;
-        if (y_block + 1 > FIELD_H - 1 || x_block > FIELD_W - 1 || x_block < 0 ||
-            game_info->field[y_block][x_block] || game_info->pause == PAUSED) {
-          can_rotate = 0;
-        }
-      }
-    }
-  }
+  int rotation = (tet->rotation + 1) % ROTATIONS_COUNT;
+  const ShapeOrientation *rotated = &shape_table[tet->type][rotation];
 
-  if (can_rotate) {
-    for (int i = 0; i < MAX_FIGURE_SIZE; i++) {
-      for (int j = 0; j < MAX_FIGURE_SIZE; j++) {
-        tet->figure[i][j] = rotated[i][j];
-      }
-    }
+  if (game_info->pause != PAUSED &&
+      !shape_collides(&game_info->tetris->board, rotated, tet->coord.x,
+                      tet->coord.y)) {
+    journal_tetromino(tet, game_info);
+    tet->rotation = rotation;
+    journal_tetromino(tet, game_info);
   }
 }
@@ -0,0 +1,116 @@
+#include "../../inc/tetris/figures.h"
+
+/** @file */
+
+const int figures[FIGURES_COUNT][MAX_FIGURE_SIZE][MAX_FIGURE_SIZE] = {
+    {{0, 0, 0, 0}, {0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}},
+    {{0, 0, 0, 0}, {1, 1, 1, 1}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+    {{0, 0, 0, 0}, {1, 1, 0, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}},
+    {{0, 0, 0, 0}, {0, 1, 1, 0}, {1, 1, 0, 0}, {0, 0, 0, 0}},
+    {{0, 0, 0, 0}, {1, 1, 1, 0}, {1, 0, 0, 0}, {0, 0, 0, 0}},
+    {{0, 0, 0, 0}, {1, 1, 1, 0}, {0, 0, 1, 0}, {0, 0, 0, 0}},
+    {{0, 0, 0, 0}, {1, 1, 1, 0}, {0, 1, 0, 0}, {0, 0, 0, 0}}};
+
+/**
+ * @brief Every orientation of every figure, indexed by [type][rotation].
+ *
+ * Rotation r + 1 is rotation r turned clockwise inside the 4x4 box, the same
+ * turn rotate_tetromino used to compute at run time. Each entry holds the
+ * packed rows, the first filled column of every row (-1 for an empty row),
+ * the lowest filled row of every column (-1 for an empty column) and the
+ * bounding box {left, right, top, bottom} inside the box.
+ */
+const ShapeOrientation shape_table[FIGURES_COUNT][ROTATIONS_COUNT] = {
+    {{{{0x0, 0x6, 0x6, 0x0}}, {-1, 1, 1, -1}, {-1, 2, 2, -1}, 1, 2, 1, 2},
+     {{{0x0, 0x6, 0x6, 0x0}}, {-1, 1, 1, -1}, {-1, 2, 2, -1}, 1, 2, 1, 2},
+     {{{0x0, 0x6, 0x6, 0x0}}, {-1, 1, 1, -1}, {-1, 2, 2, -1}, 1, 2, 1, 2},
+     {{{0x0, 0x6, 0x6, 0x0}}, {-1, 1, 1, -1}, {-1, 2, 2, -1}, 1, 2, 1, 2}},
+    {{{{0x0, 0xF, 0x0, 0x0}}, {-1, 0, -1, -1}, {1, 1, 1, 1}, 0, 3, 1, 1},
+     {{{0x4, 0x4, 0x4, 0x4}}, {2, 2, 2, 2}, {-1, -1, 3, -1}, 2, 2, 0, 3},
+     {{{0x0, 0x0, 0xF, 0x0}}, {-1, -1, 0, -1}, {2, 2, 2, 2}, 0, 3, 2, 2},
+     {{{0x2, 0x2, 0x2, 0x2}}, {1, 1, 1, 1}, {-1, 3, -1, -1}, 1, 1, 0, 3}},
+    {{{{0x0, 0x3, 0x6, 0x0}}, {-1, 0, 1, -1}, {1, 2, 2, -1}, 0, 2, 1, 2},
+     {{{0x4, 0x6, 0x2, 0x0}}, {2, 1, 1, -1}, {-1, 2, 1, -1}, 1, 2, 0, 2},
+     {{{0x0, 0x6, 0xC, 0x0}}, {-1, 1, 2, -1}, {-1, 1, 2, 2}, 1, 3, 1, 2},
+     {{{0x0, 0x4, 0x6, 0x2}}, {-1, 2, 1, 1}, {-1, 3, 2, -1}, 1, 2, 1, 3}},
+    {{{{0x0, 0x6, 0x3, 0x0}}, {-1, 1, 0, -1}, {2, 2, 1, -1}, 0, 2, 1, 2},
+     {{{0x2, 0x6, 0x4, 0x0}}, {1, 1, 2, -1}, {-1, 1, 2, -1}, 1, 2, 0, 2},
+     {{{0x0, 0xC, 0x6, 0x0}}, {-1, 2, 1, -1}, {-1, 2, 2, 1}, 1, 3, 1, 2},
+     {{{0x0, 0x2, 0x6, 0x4}}, {-1, 1, 1, 2}, {-1, 2, 3, -1}, 1, 2, 1, 3}},
+    {{{{0x0, 0x7, 0x1, 0x0}}, {-1, 0, 0, -1}, {2, 1, 1, -1}, 0, 2, 1, 2},
+     {{{0x6, 0x4, 0x4, 0x0}}, {1, 2, 2, -1}, {-1, 0, 2, -1}, 1, 2, 0, 2},
+     {{{0x0, 0x8, 0xE, 0x0}}, {-1, 3, 1, -1}, {-1, 2, 2, 2}, 1, 3, 1, 2},
+     {{{0x0, 0x2, 0x2, 0x6}}, {-1, 1, 1, 1}, {-1, 3, 3, -1}, 1, 2, 1, 3}},
+    {{{{0x0, 0x7, 0x4, 0x0}}, {-1, 0, 2, -1}, {1, 1, 2, -1}, 0, 2, 1, 2},
+     {{{0x4, 0x4, 0x6, 0x0}}, {2, 2, 1, -1}, {-1, 2, 2, -1}, 1, 2, 0, 2},
+     {{{0x0, 0x2, 0xE, 0x0}}, {-1, 1, 1, -1}, {-1, 2, 2, 2}, 1, 3, 1, 2},
+     {{{0x0, 0x6, 0x2, 0x2}}, {-1, 1, 1, 1}, {-1, 3, 1, -1}, 1, 2, 1, 3}},
+    {{{{0x0, 0x7, 0x2, 0x0}}, {-1, 0, 1, -1}, {1, 2, 1, -1}, 0, 2, 1, 2},
+     {{{0x4, 0x6, 0x4, 0x0}}, {2, 1, 2, -1}, {-1, 1, 2, -1}, 1, 2, 0, 2},
+     {{{0x0, 0x4, 0xE, 0x0}}, {-1, 2, 1, -1}, {-1, 2, 2, 2}, 1, 3, 1, 2},
+     {{{0x0, 0x2, 0x6, 0x2}}, {-1, 1, 1, 1}, {-1, 3, 2, -1}, 1, 2, 1, 3}}};
+
+/**
+ * @brief Moves one packed figure row to column x of the field.
+ *
+ * The bounding box check in the callers keeps every cell inside the walls,
+ * so no bits are lost here.
+ */
+static BoardRow shape_row_at(const ShapeOrientation *shape, int row, int x) {
+  return x >= 0 ? (BoardRow)(shape->mask.rows[row] << x)
+                : (BoardRow)(shape->mask.rows[row] >> -x);
+}
+
+/**
+ * @brief Checks whether an orientation placed at (x, y) hits a wall, the
+ * floor or a filled cell.
+ *
+ * Walls and floor are handled by the bounding box, so only the rows the
+ * figure occupies are ANDed with the board.
+ *
+ * @param board the board to test against
+ * @param shape the orientation from shape_table
+ * @param x field column of the figure box
+ * @param y field row of the figure box
+ *
+ * @return true if the figure does not fit
+ */
+bool shape_collides(const Bitboard *board, const ShapeOrientation *shape,
+                    int x, int y) {
+  bool collides = x + shape->left < 0 || x + shape->right >= TETRIS_W ||
+                  y + shape->top < 0 || y + shape->bottom >= TETRIS_H;
+  for (int r = shape->top; r <= shape->bottom && !collides; r++) {
+    collides = (shape_row_at(shape, r, x) & board->rows[y + r]) != 0;
+  }
+  return collides;
+}
+
+/**
+ * @brief Checks whether a new figure of a type cannot spawn, the test
+ * check_game_over applies to the spawned tetromino.
+ *
+ * @param board the board to test against
+ * @param type the figure
+ *
+ * @return true if the game would be over
+ */
+bool shape_spawn_blocked(const Bitboard *board, int type) {
+  PieceMask body = shape_table[type][0].mask;
+  body.rows[0] = 0;
+  return bitboard_collides(board, &body, START_POS_FIGURE_X,
+                           START_POS_FIGURE_Y);
+}
+
+/**
+ * @brief ORs an orientation into the board. The figure must fit at (x, y).
+ *
+ * @param board the board to update
+ * @param shape the orientation from shape_table
+ * @param x field column of the figure box
+ * @param y field row of the figure box
+ */
+void shape_place(Bitboard *board, const ShapeOrientation *shape, int x, int y) {
+  for (int r = shape->top; r <= shape->bottom; r++) {
+    board->rows[y + r] |= shape_row_at(shape, r, x);
+  }
+}
@@ -27,6 +27,9 @@ void get_signal(Tetromino *tet, GameInfo *game_info, UserAction action) {
     case Down:
       drop_tetromino(tet, game_info);
       break;
+    case Up:
+      hard_drop_tetromino(tet, game_info);
+      break;
     case Right:
       move_tetromino_right(tet, game_info);
       break;
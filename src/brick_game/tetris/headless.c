@@ -0,0 +1,239 @@
+#include "../../inc/tetris/headless.h"
+
+#include "../../inc/tetris/fsm.h"
+
+/** @file */
+
+// Everything of one game in a single block. The game comes first and is
+// aligned, so that it starts on a cache line and the size of a session is
+// whole cache lines, which keeps every session of an arena aligned too
+struct TetrisSession {
+  _Alignas(TETRIS_BLOCK_ALIGN) TetrisGameBlock game;
+  Tetromino piece;
+  GameInfo *game_info;
+  Tetromino *tetromino;
+};
+
+struct TetrisArena {
+  TetrisSession *sessions;
+  int capacity;
+  int used;
+};
+
+/**
+ * @brief Rounds a size up to whole cache lines, as aligned_alloc wants.
+ */
+static size_t block_size(size_t size) {
+  return (size + TETRIS_BLOCK_ALIGN - 1) / TETRIS_BLOCK_ALIGN *
+         TETRIS_BLOCK_ALIGN;
+}
+
+/**
+ * @brief Creates a headless Tetris session.
+ *
+ * The session does not read or write the high score file and never sleeps.
+ * It starts on the start screen, like the console game, so the first input
+ * is usually Start. Pieces come from TETRIS_DEFAULT_SEED.
+ *
+ * @return Pointer to the new session, NULL if it cannot be allocated
+ */
+TetrisSession *tetris_session_create() {
+  return tetris_session_create_seeded(TETRIS_DEFAULT_SEED, FALSE);
+}
+
+/**
+ * @brief Creates a headless Tetris session with its own piece sequence.
+ *
+ * Sessions with equal seeds and equal inputs play identical games, also when
+ * they run on different threads.
+ *
+ * @param seed Seed of the piece generator
+ * @param use_bag TRUE to deal pieces from shuffled bags of all seven
+ *
+ * @return Pointer to the new session, NULL if it cannot be allocated
+ */
+TetrisSession *tetris_session_create_seeded(uint64_t seed, bool use_bag) {
+  TetrisSession *session = aligned_alloc(
+      TETRIS_BLOCK_ALIGN, block_size(sizeof(TetrisSession)));
+  if (session) tetris_session_reset(session, seed, use_bag);
+  return session;
+}
+
+/**
+ * @brief Starts a new game in an existing session without allocating.
+ *
+ * The session then plays exactly the game a new session created with the
+ * same seed would play.
+ *
+ * @param session Pointer to the session
+ * @param seed Seed of the piece generator
+ * @param use_bag TRUE to deal pieces from shuffled bags of all seven
+ */
+void tetris_session_reset(TetrisSession *session, uint64_t seed,
+                          bool use_bag) {
+  session->game_info = init_game_info(&session->game, FALSE);
+  tetris_seed(session->game_info, seed, use_bag);
+  session->piece = set_tetromino(session->game_info);
+  session->tetromino = &session->piece;
+}
+
+/**
+ * @brief Copies the whole state of a session, see tetris_snapshot_save.
+ *
+ * @param session Pointer to the session
+ * @param snapshot Where the copy goes
+ */
+void tetris_session_clone(const TetrisSession *session,
+                          TetrisSnapshot *snapshot) {
+  tetris_snapshot_save(session->game_info, session->tetromino, snapshot);
+}
+
+/**
+ * @brief Returns a session to a state saved by tetris_session_clone.
+ *
+ * The snapshot may come from another session, the session then plays on
+ * from there exactly as that one would.
+ *
+ * @param session Pointer to the session
+ * @param snapshot The saved state
+ */
+void tetris_session_restore(TetrisSession *session,
+                            const TetrisSnapshot *snapshot) {
+  tetris_snapshot_restore(session->game_info, session->tetromino, snapshot);
+}
+
+/**
+ * @brief Frees a session created by tetris_session_create.
+ *
+ * Sessions of an arena belong to the arena and must not be passed here.
+ *
+ * @param session Pointer to the session, may be NULL
+ */
+void tetris_session_destroy(TetrisSession *session) { free(session); }
+
+/**
+ * @brief Creates storage for a number of sessions in one allocation.
+ *
+ * Batch runs take a session from the arena for every game and reset the
+ * arena once the games are over, so the allocator is only used here.
+ *
+ * @param capacity Sessions the arena holds at the same time
+ *
+ * @return Pointer to the new arena, NULL if it cannot be allocated
+ */
+TetrisArena *tetris_arena_create(int capacity) {
+  TetrisArena *arena = calloc(1, sizeof(TetrisArena));
+  if (arena) {
+    arena->capacity = capacity > 0 ? capacity : 1;
+    arena->sessions =
+        aligned_alloc(TETRIS_BLOCK_ALIGN,
+                      block_size(arena->capacity * sizeof(TetrisSession)));
+    if (!arena->sessions) {
+      free(arena);
+      arena = NULL;
+    }
+  }
+  return arena;
+}
+
+/**
+ * @brief Frees an arena together with all of its sessions.
+ *
+ * @param arena Pointer to the arena, may be NULL
+ */
+void tetris_arena_destroy(TetrisArena *arena) {
+  if (arena == NULL) return;
+  free(arena->sessions);
+  free(arena);
+}
+
+/**
+ * @brief Starts a new game in the next free session of the arena.
+ *
+ * @param arena Pointer to the arena
+ * @param seed Seed of the piece generator
+ * @param use_bag TRUE to deal pieces from shuffled bags of all seven
+ *
+ * @return The session, or NULL if all of them are in use
+ */
+TetrisSession *tetris_arena_session(TetrisArena *arena, uint64_t seed,
+                                    bool use_bag) {
+  if (arena->used == arena->capacity) return NULL;
+  TetrisSession *session = &arena->sessions[arena->used++];
+  tetris_session_reset(session, seed, use_bag);
+  return session;
+}
+
+/**
+ * @brief Returns every session to the arena.
+ *
+ * Sessions handed out before are invalid afterwards.
+ *
+ * @param arena Pointer to the arena
+ */
+void tetris_arena_reset(TetrisArena *arena) { arena->used = 0; }
+
+/**
+ * @brief Locks the tetromino if it has landed, as game_loop does every frame.
+ */
+static void lock_if_placed(TetrisSession *session, TetrisStepResult *result) {
+  if (session->game_info->pause == STARTED && session->tetromino->is_placed) {
+    game_update(session->tetromino, session->game_info);
+    result->pieces++;
+  }
+}
+
+/**
+ * @brief Applies a batch of inputs and then runs gravity ticks.
+ *
+ * Every input goes through get_signal and is followed by the same lock check
+ * the console loop performs. Each tick then moves the tetromino one row down
+ * and locks it once it lands. Ticks are only run while the game is started,
+ * so the step stops early on game over, pause or quit.
+ *
+ * @param session Pointer to the session
+ * @param actions Inputs to apply in order, may be NULL if count is 0
+ * @param count Number of inputs
+ * @param ticks Number of gravity ticks to run after the inputs
+ *
+ * @return Score, level, state and what happened during the step
+ */
+TetrisStepResult tetris_session_step(TetrisSession *session,
+                                     const UserAction *actions, int count,
+                                     int ticks) {
+  GameInfo *game_info = session->game_info;
+  Tetromino *tetromino = session->tetromino;
+  TetrisStepResult result = {0};
+  int lines_before = game_info->tetris->lines_cleared;
+
+  for (int i = 0; i < count; i++) {
+    get_signal(tetromino, game_info, actions[i]);
+    lock_if_placed(session, &result);
+  }
+
+  for (; result.ticks < ticks && game_info->pause == STARTED; result.ticks++) {
+    move_tetromino_down_one_row(tetromino, game_info);
+    lock_if_placed(session, &result);
+  }
+
+  result.score = game_info->score;
+  result.level = game_info->level;
+  result.speed = game_info->speed;
+  result.state = game_info->pause;
+  result.lines = game_info->tetris->lines_cleared - lines_before;
+  return result;
+}
+
+/**
+ * @brief Read-only view of the session's field, preview and counters.
+ */
+const GameInfo *tetris_session_info(const TetrisSession *session) {
+  return session->game_info;
+}
+
+/**
+ * @brief Read-only view of the falling tetromino.
+ */
+const Tetromino *tetris_session_tetromino(const TetrisSession *session) {
+  return session->tetromino;
+}
@@ -0,0 +1,482 @@
+#include "../../inc/tetris/mcts.h"
+
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../inc/tetris/fsm.h"
+
+/** @file */
+
+// Children a position can have, one per placement of its piece
+#define MCTS_FANOUT TETRIS_AI_MAX_PLACEMENTS
+
+// Nodes of a full tree: the root, its children and their children
+#define MCTS_MAX_NODES (1 + MCTS_FANOUT + MCTS_FANOUT * MCTS_FANOUT)
+
+/**
+ * @brief A position in a tree and what the iterations through it found
+ */
+typedef struct {
+  TetrisPlacement placement;  // Where the parent's piece went to get here
+  int first_child;            // Index of the first child, -1 if unexpanded
+  int child_count;
+  int visits;
+  int losses;    // Iterations through here that ended the game
+  double value;  // Sum of the values of the other iterations
+} MctsNode;
+
+/**
+ * @brief One tree, grown by one thread, on its own cache lines
+ */
+typedef struct {
+  _Alignas(64) MctsNode *nodes;
+  int node_count;
+  double low, high;  // Smallest and largest value seen, for the UCT range
+  GameInfo *game;    // Copy of the root the iterations play in
+  Tetromino tet;
+  TetrisAi player;   // Writes the inputs, places the greedy rollout pieces
+  Rng rng;
+  long iterations;
+  long placements;
+} MctsTree;
+
+/**
+ * @brief A started thread and the tree it grows
+ */
+typedef struct {
+  TetrisMcts *mcts;
+  int index;
+} MctsThread;
+
+struct TetrisMcts {
+  TetrisMctsConfig config;
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;  // A decision is posted or the threads must quit
+  pthread_cond_t idle;  // The last thread finished its tree
+  pthread_t *threads;
+  MctsThread *thread_slots;
+  int thread_count;  // Started threads, the caller grows a tree too
+  unsigned job_id;   // Bumped for every decision
+  int busy;          // Started threads still growing their tree
+  bool quit;
+
+  TetrisSnapshot root;
+  int root_lines;         // Lines cleared in the game before the decision
+  long long deadline_ns;  // 0 for no limit
+  MctsTree *trees;        // One per thread, the caller first
+  TetrisMctsStats stats;
+};
+
+static long long now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long long)now.tv_sec * 1000000000ll + now.tv_nsec;
+}
+
+/**
+ * @brief Spreads a seed, a decision and a tree over the generator seeds.
+ */
+static uint64_t mix_seed(uint64_t value) {
+  value += 0x9E3779B97F4A7C15ull;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+/**
+ * @brief Settings for live play: two trees, a quarter of a frame of
+ * game_loop and short greedy rollouts.
+ *
+ * @param config - receives the settings
+ */
+void tetris_mcts_default_config(TetrisMctsConfig *config) {
+  config->threads = 2;
+  config->time_limit_ms = SPEED_1 / 1000 / 4.0;
+  config->iterations = 0;
+  config->rollout_pieces = 3;
+  config->greedy_rollouts = true;
+  config->exploration = 0.5;
+  config->seed = 1;
+}
+
+/**
+ * @brief Feeds inputs through get_signal and locks the piece once it lands,
+ * the way tetris_session_step does.
+ */
+static void play_moves(MctsTree *tree, const UserAction *moves, int count) {
+  for (int i = 0; i < count; i++) {
+    get_signal(&tree->tet, tree->game, moves[i]);
+    if (tree->game->pause == STARTED && tree->tet.is_placed) {
+      game_update(&tree->tet, tree->game);
+    }
+  }
+  tree->placements++;
+}
+
+/**
+ * @brief Brings the falling piece of the tree's game to a placement.
+ */
+static void play_placement(MctsTree *tree, const TetrisPlacement *target) {
+  int count = tetris_ai_moves(&tree->player, &tree->tet, target);
+  play_moves(tree, tree->player.moves, count);
+}
+
+/**
+ * @brief Places the pieces after the tree, at random or greedily, while the
+ * game goes on.
+ */
+static void rollout(TetrisMcts *mcts, MctsTree *tree) {
+  for (int piece = 0; piece < mcts->config.rollout_pieces &&
+                      tree->game->pause == STARTED;
+       piece++) {
+    if (mcts->config.greedy_rollouts) {
+      int count = tetris_ai_plan(&tree->player, &tree->tet, tree->game);
+      play_moves(tree, tree->player.moves, count);
+    } else {
+      TetrisPlacement placements[TETRIS_AI_MAX_PLACEMENTS];
+      int count = tetris_ai_placements(
+          tree->game->tetris, tree->tet.type, tree->tet.rotation,
+          tree->tet.coord.x, tree->tet.coord.y, placements);
+      if (count) {
+        play_placement(tree, &placements[rng_below(&tree->rng, count)]);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Adds a child for every placement of the falling piece, as long
+ * as the tree has room, best one-ply score first, so that a short search
+ * tries the placements the autoplayer would pick before the others.
+ */
+static void expand(MctsTree *tree, MctsNode *node) {
+  const TetrisState *state = tree->game->tetris;
+  TetrisPlacement placements[TETRIS_AI_MAX_PLACEMENTS];
+  double scores[TETRIS_AI_MAX_PLACEMENTS];
+  int count = tetris_ai_placements(state, tree->tet.type, tree->tet.rotation,
+                                   tree->tet.coord.x, tree->tet.coord.y,
+                                   placements);
+  if (tree->node_count + count > MCTS_MAX_NODES) count = 0;
+  for (int i = 0; i < count; i++) {
+    TetrisState child = *state;
+    int lines = tetris_ai_place(&tree->player, &child, tree->tet.type,
+                                &placements[i]);
+    double score = tetris_ai_evaluate(&tree->player.weights, &child, lines);
+    TetrisPlacement placement = placements[i];
+    int j = i;
+    for (; j > 0 && scores[j - 1] < score; j--) {
+      scores[j] = scores[j - 1];
+      placements[j] = placements[j - 1];
+    }
+    scores[j] = score;
+    placements[j] = placement;
+  }
+  node->first_child = tree->node_count;
+  node->child_count = count;
+  for (int i = 0; i < count; i++) {
+    tree->nodes[tree->node_count++] =
+        (MctsNode){placements[i], -1, 0, 0, 0, 0};
+  }
+}
+
+/**
+ * @brief Picks the child to go down: every child once in order, then by
+ * UCT with the values scaled to the range the tree has seen and a lost
+ * game counting as 0.
+ */
+static MctsNode *select_child(TetrisMcts *mcts, MctsTree *tree,
+                              const MctsNode *node) {
+  MctsNode *children = &tree->nodes[node->first_child];
+  double range = tree->high > tree->low ? tree->high - tree->low : 1;
+  double log_visits = log((double)node->visits);
+  MctsNode *best = NULL;
+  double best_score = -DBL_MAX;
+  for (int i = 0; i < node->child_count && !(best && !best->visits); i++) {
+    MctsNode *child = &children[i];
+    double score = DBL_MAX;
+    if (child->visits) {
+      int kept = child->visits - child->losses;
+      double mean = (child->value - kept * tree->low) / range / child->visits;
+      score = mean + mcts->config.exploration *
+                         sqrt(log_visits / child->visits);
+    }
+    if (score > best_score) {
+      best_score = score;
+      best = child;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief One iteration: copies the root into the tree's game, deals new
+ * unknown pieces, goes down the tree placing pieces through the engine,
+ * grows it by one level, plays a rollout and adds the result to the path.
+ */
+static void iterate(TetrisMcts *mcts, MctsTree *tree) {
+  tetris_snapshot_restore(tree->game, &tree->tet, &mcts->root);
+  tree->game->tetris->persist_high_score = false;
+  rng_seed(&tree->game->tetris->rng, rng_next(&tree->rng));
+
+  MctsNode *path[TETRIS_MCTS_TREE_DEPTH + 1] = {&tree->nodes[0]};
+  int depth = 0;
+  while (depth < TETRIS_MCTS_TREE_DEPTH && tree->game->pause == STARTED) {
+    MctsNode *node = path[depth];
+    if (node->first_child < 0) expand(tree, node);
+    if (!node->child_count) break;
+    MctsNode *child = select_child(mcts, tree, node);
+    play_placement(tree, &child->placement);
+    path[++depth] = child;
+  }
+  if (tree->game->pause == STARTED) rollout(mcts, tree);
+
+  bool lost = tree->game->pause != STARTED;
+  double value = 0;
+  if (!lost) {
+    const TetrisAiWeights *weights = &tree->player.weights;
+    int lines = tree->game->tetris->lines_cleared - mcts->root_lines;
+    value = weights->lines * lines +
+            tetris_ai_evaluate(weights, tree->game->tetris, 0);
+    if (tree->iterations == 0 || value < tree->low) tree->low = value;
+    if (tree->iterations == 0 || value > tree->high) tree->high = value;
+  }
+  for (int i = 0; i <= depth; i++) {
+    path[i]->visits++;
+    path[i]->losses += lost;
+    path[i]->value += value;
+  }
+  tree->iterations++;
+}
+
+/**
+ * @brief Grows one tree until it has its iterations or the time is up.
+ * Every tree makes at least one iteration.
+ */
+static void grow_tree(TetrisMcts *mcts, MctsTree *tree) {
+  tree->node_count = 1;
+  tree->nodes[0] = (MctsNode){{0, 0, 0}, -1, 0, 0, 0, 0};
+  tree->iterations = 0;
+  tree->placements = 0;
+  tree->low = tree->high = 0;
+  do {
+    iterate(mcts, tree);
+  } while ((!mcts->config.iterations ||
+            tree->iterations < mcts->config.iterations) &&
+           (!mcts->deadline_ns || now_ns() < mcts->deadline_ns));
+}
+
+/**
+ * @brief Body of a started thread: grows its tree for every decision.
+ */
+static void *mcts_thread(void *arg) {
+  MctsThread *slot = arg;
+  TetrisMcts *mcts = slot->mcts;
+  pthread_mutex_lock(&mcts->lock);
+  unsigned seen = 0;
+  while (!mcts->quit) {
+    while (mcts->job_id == seen && !mcts->quit) {
+      pthread_cond_wait(&mcts->wake, &mcts->lock);
+    }
+    if (!mcts->quit) {
+      seen = mcts->job_id;
+      pthread_mutex_unlock(&mcts->lock);
+      grow_tree(mcts, &mcts->trees[slot->index]);
+      pthread_mutex_lock(&mcts->lock);
+      if (--mcts->busy == 0) pthread_cond_signal(&mcts->idle);
+    }
+  }
+  pthread_mutex_unlock(&mcts->lock);
+  return NULL;
+}
+
+/**
+ * @brief Frees a search and everything it allocated so far.
+ */
+static void free_mcts(TetrisMcts *mcts) {
+  if (mcts->trees) {
+    for (int i = 0; i < mcts->config.threads; i++) {
+      free(mcts->trees[i].nodes);
+      free_game(mcts->trees[i].game);
+    }
+  }
+  free(mcts->trees);
+  free(mcts->threads);
+  free(mcts->thread_slots);
+  free(mcts);
+}
+
+/**
+ * @brief Allocates a tree search and starts its threads.
+ *
+ * @param config - trees, limits and rollouts, out of range values are
+ * clamped; without a time limit every tree makes at least 1000 iterations
+ *
+ * @return Pointer to the search, NULL if it cannot be allocated
+ */
+TetrisMcts *tetris_mcts_create(const TetrisMctsConfig *config) {
+  TetrisMcts *mcts = calloc(1, sizeof(TetrisMcts));
+  bool ok = mcts != NULL;
+  if (ok) {
+    mcts->config = *config;
+    if (mcts->config.threads < 1) mcts->config.threads = 1;
+    if (mcts->config.iterations < 0) mcts->config.iterations = 0;
+    if (mcts->config.time_limit_ms <= 0 && !mcts->config.iterations) {
+      mcts->config.iterations = 1000;
+    }
+    if (mcts->config.rollout_pieces < 0) mcts->config.rollout_pieces = 0;
+
+    int threads = mcts->config.threads;
+    mcts->trees =
+        aligned_alloc(_Alignof(MctsTree), threads * sizeof(MctsTree));
+    mcts->threads = calloc(threads, sizeof(pthread_t));
+    mcts->thread_slots = calloc(threads, sizeof(MctsThread));
+    ok = mcts->trees && mcts->threads && mcts->thread_slots;
+    if (mcts->trees) memset(mcts->trees, 0, threads * sizeof(MctsTree));
+    for (int i = 0; ok && i < threads; i++) {
+      MctsTree *tree = &mcts->trees[i];
+      tree->nodes = malloc(MCTS_MAX_NODES * sizeof(MctsNode));
+      tree->game = create_game_info(false);
+      tetris_ai_init(&tree->player);
+      tree->player.lookahead = false;
+      ok = tree->nodes && tree->game;
+    }
+    if (!ok) {
+      free_mcts(mcts);
+      mcts = NULL;
+    }
+  }
+  if (mcts) {
+    pthread_mutex_init(&mcts->lock, NULL);
+    pthread_cond_init(&mcts->wake, NULL);
+    pthread_cond_init(&mcts->idle, NULL);
+    for (int i = 1; i < mcts->config.threads; i++) {
+      MctsThread *slot = &mcts->thread_slots[mcts->thread_count];
+      *slot = (MctsThread){mcts, i};
+      if (!pthread_create(&mcts->threads[mcts->thread_count], NULL,
+                          mcts_thread, slot)) {
+        mcts->thread_count++;
+      }
+    }
+  }
+  return mcts;
+}
+
+/**
+ * @brief Stops the threads of a search and frees it.
+ *
+ * @param mcts - pointer to the search, may be NULL
+ */
+void tetris_mcts_destroy(TetrisMcts *mcts) {
+  if (mcts) {
+    pthread_mutex_lock(&mcts->lock);
+    mcts->quit = true;
+    pthread_cond_broadcast(&mcts->wake);
+    pthread_mutex_unlock(&mcts->lock);
+    for (int i = 0; i < mcts->thread_count; i++) {
+      pthread_join(mcts->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&mcts->lock);
+    pthread_cond_destroy(&mcts->wake);
+    pthread_cond_destroy(&mcts->idle);
+    free_mcts(mcts);
+  }
+}
+
+/**
+ * @brief Finds a placement of the falling tetromino with a Monte Carlo tree
+ * search and the inputs that lead there.
+ *
+ * Every thread grows its own tree from a snapshot of the game, with its own
+ * random pieces after the preview, so the trees only meet at the root. An
+ * iteration plays its placements through get_signal and game_update on a
+ * restored copy of the game, and scores the end position with the weights
+ * of ai after a few rollout pieces. The root placement visited most often
+ * over all trees is played; a tree that cannot use a started thread is
+ * grown by the caller after its own.
+ *
+ * @param mcts - the search
+ * @param ai - weights to score with, receives the moves
+ * @param tet - the falling tetromino
+ * @param game_info - the game it falls in, from create_game_info or a
+ * headless session
+ *
+ * @return Number of moves in ai->moves
+ */
+int tetris_mcts_plan(TetrisMcts *mcts, TetrisAi *ai, const Tetromino *tet,
+                     const GameInfo *game_info) {
+  long long start = now_ns();
+  tetris_snapshot_save(game_info, tet, &mcts->root);
+  mcts->root_lines = game_info->tetris->lines_cleared;
+  mcts->deadline_ns =
+      mcts->config.time_limit_ms > 0
+          ? start + (long long)(mcts->config.time_limit_ms * 1e6)
+          : 0;
+  for (int i = 0; i < mcts->config.threads; i++) {
+    MctsTree *tree = &mcts->trees[i];
+    tree->player.weights = ai->weights;
+    rng_seed(&tree->rng, mix_seed(mix_seed(mcts->config.seed) ^
+                                  (uint64_t)mcts->stats.decisions << 8 ^
+                                  (uint64_t)i));
+  }
+
+  if (mcts->thread_count) {
+    pthread_mutex_lock(&mcts->lock);
+    mcts->job_id++;
+    mcts->busy = mcts->thread_count;
+    pthread_cond_broadcast(&mcts->wake);
+    pthread_mutex_unlock(&mcts->lock);
+  }
+  grow_tree(mcts, &mcts->trees[0]);
+  for (int i = mcts->thread_count + 1; i < mcts->config.threads; i++) {
+    grow_tree(mcts, &mcts->trees[i]);
+  }
+  if (mcts->thread_count) {
+    pthread_mutex_lock(&mcts->lock);
+    while (mcts->busy) pthread_cond_wait(&mcts->idle, &mcts->lock);
+    pthread_mutex_unlock(&mcts->lock);
+  }
+
+  // Every tree lists the root placements in the same order
+  const MctsNode *root = &mcts->trees[0].nodes[0];
+  TetrisPlacement best = {tet->rotation, tet->coord.x, tet->coord.y};
+  long best_visits = -1;
+  for (int c = 0; c < root->child_count; c++) {
+    long visits = 0;
+    for (int i = 0; i < mcts->config.threads; i++) {
+      const MctsNode *other = &mcts->trees[i].nodes[0];
+      if (c < other->child_count) {
+        visits += mcts->trees[i].nodes[other->first_child + c].visits;
+      }
+    }
+    if (visits > best_visits) {
+      best_visits = visits;
+      best = mcts->trees[0].nodes[root->first_child + c].placement;
+    }
+  }
+
+  for (int i = 0; i < mcts->config.threads; i++) {
+    mcts->stats.iterations += mcts->trees[i].iterations;
+    mcts->stats.nodes += mcts->trees[i].node_count;
+    mcts->stats.placements += mcts->trees[i].placements;
+  }
+  double elapsed = (now_ns() - start) / 1e6;
+  mcts->stats.decisions++;
+  mcts->stats.total_ms += elapsed;
+  if (elapsed > mcts->stats.longest_ms) mcts->stats.longest_ms = elapsed;
+  return tetris_ai_moves(ai, tet, &best);
+}
+
+/**
+ * @brief Copies the counters of all decisions made so far.
+ *
+ * @param mcts - the search
+ * @param stats - receives the counters
+ */
+void tetris_mcts_stats(const TetrisMcts *mcts, TetrisMctsStats *stats) {
+  *stats = mcts->stats;
+}
@@ -0,0 +1,154 @@
+#include "../../inc/tetris/movegen.h"
+
+#include <string.h>
+
+/** @file */
+
+/**
+ * @brief Columns of a row of Visited, the narrowest word MOVEGEN_COLUMNS
+ * bits fit in
+ */
+#if MOVEGEN_COLUMNS <= 16
+typedef uint16_t VisitedRow;
+#elif MOVEGEN_COLUMNS <= 32
+typedef uint32_t VisitedRow;
+#elif MOVEGEN_COLUMNS <= 64
+typedef uint64_t VisitedRow;
+#else
+typedef unsigned __int128 VisitedRow;
+#endif
+
+/**
+ * @brief Positions already queued, bit x + MAX_FIGURE_SIZE - 1 of a row
+ */
+typedef VisitedRow Visited[ROTATIONS_COUNT][TETRIS_H];
+
+/**
+ * @brief Queues a position if the figure fits there and it is new.
+ *
+ * The fit test is the one move_tetromino_left, move_tetromino_right,
+ * rotate_tetromino and move_tetromino_down_one_row apply.
+ */
+static void visit(TetrisMoves *moves, Visited visited, const Bitboard *board,
+                  int type, const MoveState *next) {
+  VisitedRow bit = (VisitedRow)1 << (next->x + MAX_FIGURE_SIZE - 1);
+  if (!(visited[(int)next->rotation][(int)next->y] & bit) &&
+      !shape_collides(board, &shape_table[type][(int)next->rotation],
+                      next->x, next->y)) {
+    visited[(int)next->rotation][(int)next->y] |= bit;
+    moves->states[moves->state_count++] = *next;
+  }
+}
+
+/**
+ * @brief Finds every position a figure can reach with the game's moves.
+ *
+ * A breadth first search from (x, y, rotation) over left, right, clockwise
+ * rotation and one row down, the moves get_signal and gravity make. Each
+ * (x, y, rotation) is queued once, so the first path to a position is one of
+ * the shortest. A position the figure cannot fall from is a resting one,
+ * where the tetromino would lock.
+ *
+ * @param moves - receives the positions, the first one is the start
+ * @param board - the field without the figure
+ * @param type - the figure
+ * @param rotation - its rotation, the figure must fit at the start
+ * @param x - field column of the figure box
+ * @param y - field row of the figure box, not negative
+ */
+void tetris_generate_moves(TetrisMoves *moves, const Bitboard *board,
+                           int type, int rotation, int x, int y) {
+  Visited visited;
+  memset(visited, 0, sizeof(visited));
+  moves->state_count = 0;
+  moves->resting_count = 0;
+
+  MoveState start = {(int8_t)x, (int8_t)y, (int8_t)rotation, Start, -1};
+  visit(moves, visited, board, type, &start);
+  for (int i = 0; i < moves->state_count; i++) {
+    const MoveState *state = &moves->states[i];
+    MoveState left = {(int8_t)(state->x - 1), state->y, state->rotation,
+                      Left, (int16_t)i};
+    MoveState right = {(int8_t)(state->x + 1), state->y, state->rotation,
+                       Right, (int16_t)i};
+    MoveState turn = {state->x, state->y,
+                      (int8_t)((state->rotation + 1) % ROTATIONS_COUNT),
+                      Action, (int16_t)i};
+    MoveState down = {state->x, (int8_t)(state->y + 1), state->rotation,
+                      Down, (int16_t)i};
+    visit(moves, visited, board, type, &left);
+    visit(moves, visited, board, type, &right);
+    visit(moves, visited, board, type, &turn);
+    if (shape_collides(board, &shape_table[type][(int)state->rotation],
+                       state->x, state->y + 1)) {
+      moves->resting[moves->resting_count++] = (int16_t)i;
+    } else {
+      visit(moves, visited, board, type, &down);
+    }
+  }
+}
+
+/**
+ * @brief Lists the inputs that take the figure from the start to a state.
+ *
+ * @param moves - the result of tetris_generate_moves
+ * @param state - index into moves->states
+ * @param path - receives the inputs in order
+ * @param capacity - room in path
+ *
+ * @return Number of inputs, -1 if they do not fit into path
+ */
+int tetris_move_path(const TetrisMoves *moves, int state, UserAction *path,
+                     int capacity) {
+  int length = 0;
+  for (int i = state; moves->states[i].parent >= 0;
+       i = moves->states[i].parent) {
+    length++;
+  }
+  if (length > capacity) return -1;
+
+  int position = length;
+  for (int i = state; moves->states[i].parent >= 0;
+       i = moves->states[i].parent) {
+    path[--position] = (UserAction)moves->states[i].action;
+  }
+  return length;
+}
+
+/**
+ * @brief Counts the placement sequences of a fixed piece sequence.
+ *
+ * Every piece spawns where the game spawns it and may lock in any resting
+ * state tetris_generate_moves finds. Full rows are cleared after each lock
+ * and a piece that cannot spawn ends the sequence, as in the game. The last
+ * piece is not placed, its resting states are counted.
+ *
+ * @param board - the field before the first piece
+ * @param pieces - depth figure types, pieces[0] first
+ * @param depth - number of pieces to place
+ *
+ * @return Number of different sequences of depth locked positions
+ */
+uint64_t tetris_perft(const Bitboard *board, const uint8_t *pieces,
+                      int depth) {
+  uint64_t count = 0;
+  if (depth <= 0) return 1;
+  if (shape_spawn_blocked(board, pieces[0])) return 0;
+
+  TetrisMoves moves;
+  tetris_generate_moves(&moves, board, pieces[0], 0, START_POS_FIGURE_X,
+                        START_POS_FIGURE_Y);
+  if (depth == 1) return (uint64_t)moves.resting_count;
+
+  for (int i = 0; i < moves.resting_count; i++) {
+    const MoveState *state = &moves.states[moves.resting[i]];
+    const ShapeOrientation *shape =
+        &shape_table[pieces[0]][(int)state->rotation];
+    Bitboard child = *board;
+    shape_place(&child, shape, state->x, state->y);
+    bitboard_remove_full_rows(&child, state->y + shape->top,
+                              state->y + shape->bottom);
+    count += tetris_perft(&child, pieces + 1, depth - 1);
+  }
+  return count;
+}
@@ -0,0 +1,178 @@
+#include "../../inc/tetris/ttable.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** @file */
+
+#define TTABLE_WAYS 4
+#define TTABLE_VALID (1ull << 56)
+
+/**
+ * @brief One entry. check holds key ^ data, so a slot torn by two threads
+ * writing at once fails the key test instead of returning mixed data.
+ */
+typedef struct {
+  _Atomic uint64_t check;
+  _Atomic uint64_t data;
+} Slot;
+
+/**
+ * @brief The entries one key can live in, one cache line
+ */
+typedef struct {
+  _Alignas(64) Slot slots[TTABLE_WAYS];
+} Bucket;
+
+struct TTable {
+  Bucket *buckets;
+  size_t mask;  // Bucket count - 1, the count is a power of two
+  _Atomic unsigned generation;
+};
+
+/**
+ * @brief Allocates an empty table.
+ *
+ * @param megabytes - memory to use, rounded down to a power of two buckets
+ *
+ * @return Pointer to the table, NULL if it cannot be allocated
+ */
+TTable *ttable_create(size_t megabytes) {
+  size_t count = 1;
+  while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) count *= 2;
+
+  TTable *table = calloc(1, sizeof(TTable));
+  if (table) {
+    table->buckets = aligned_alloc(sizeof(Bucket), count * sizeof(Bucket));
+    if (table->buckets) {
+      memset(table->buckets, 0, count * sizeof(Bucket));
+      table->mask = count - 1;
+      atomic_init(&table->generation, 0);
+    } else {
+      free(table);
+      table = NULL;
+    }
+  }
+  return table;
+}
+
+/**
+ * @brief Frees a table created by ttable_create.
+ *
+ * @param table - pointer to the table, may be NULL
+ */
+void ttable_destroy(TTable *table) {
+  if (table) {
+    free(table->buckets);
+    free(table);
+  }
+}
+
+/**
+ * @brief Starts a new generation. Entries stored in older generations are
+ * replaced first.
+ */
+void ttable_age(TTable *table) {
+  atomic_fetch_add_explicit(&table->generation, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Builds the key of a position.
+ *
+ * @param board_hash - Zobrist hash of the board
+ * @param kind - what the entry holds
+ * @param current - the falling figure, 0 if not part of the position
+ * @param next - the preview figure
+ * @param salt - anything else the value depends on, e.g. the weights
+ *
+ * @return The key for ttable_probe and ttable_store
+ */
+uint64_t ttable_key(uint64_t board_hash, TTableKind kind, int current,
+                    int next, uint64_t salt) {
+  uint64_t value = salt + (uint64_t)((kind * 8 + current) * 8 + next) *
+                              0x9E3779B97F4A7C15ull;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return board_hash ^ value ^ (value >> 31);
+}
+
+static uint64_t pack(const TTableEntry *entry, unsigned generation) {
+  uint32_t score;
+  memcpy(&score, &entry->score, sizeof(score));
+  uint64_t move = (uint64_t)(entry->rotation & 0x3) |
+                  (uint64_t)((entry->x + 8) & 0x7F) << 2 |
+                  (uint64_t)(entry->y & 0x7F) << 9;
+  return score | move << 32 | (uint64_t)(generation & 0xFF) << 48 |
+         TTABLE_VALID;
+}
+
+static void unpack(uint64_t data, TTableEntry *entry) {
+  uint32_t score = (uint32_t)data;
+  memcpy(&entry->score, &score, sizeof(score));
+  entry->rotation = (int8_t)((data >> 32) & 0x3);
+  entry->x = (int8_t)(((data >> 34) & 0x7F) - 8);
+  entry->y = (int8_t)((data >> 41) & 0x7F);
+}
+
+/**
+ * @brief Looks a key up without taking any lock.
+ *
+ * @param table - the table
+ * @param key - from ttable_key
+ * @param entry - receives the value on a hit
+ *
+ * @return true on a hit
+ */
+bool ttable_probe(TTable *table, uint64_t key, TTableEntry *entry) {
+  Bucket *bucket = &table->buckets[key & table->mask];
+  bool hit = false;
+  for (int i = 0; i < TTABLE_WAYS && !hit; i++) {
+    uint64_t data =
+        atomic_load_explicit(&bucket->slots[i].data, memory_order_relaxed);
+    uint64_t check =
+        atomic_load_explicit(&bucket->slots[i].check, memory_order_relaxed);
+    hit = (data & TTABLE_VALID) && (check ^ data) == key;
+    if (hit) unpack(data, entry);
+  }
+  return hit;
+}
+
+/**
+ * @brief Stores a value without taking any lock.
+ *
+ * The slot already holding the key is overwritten, otherwise an empty slot,
+ * otherwise the slot stored the most generations ago.
+ *
+ * @param table - the table
+ * @param key - from ttable_key
+ * @param entry - the value
+ */
+void ttable_store(TTable *table, uint64_t key, const TTableEntry *entry) {
+  Bucket *bucket = &table->buckets[key & table->mask];
+  unsigned generation =
+      atomic_load_explicit(&table->generation, memory_order_relaxed);
+  int victim = 0;
+  unsigned oldest = 0;
+  bool found = false;
+  for (int i = 0; i < TTABLE_WAYS && !found; i++) {
+    uint64_t data =
+        atomic_load_explicit(&bucket->slots[i].data, memory_order_relaxed);
+    uint64_t check =
+        atomic_load_explicit(&bucket->slots[i].check, memory_order_relaxed);
+    unsigned age = (generation - (unsigned)(data >> 48)) & 0xFFu;
+    if (!(data & TTABLE_VALID) || (check ^ data) == key) {
+      victim = i;
+      found = true;
+    } else if (age >= oldest) {
+      victim = i;
+      oldest = age;
+    }
+  }
+
+  uint64_t data = pack(entry, generation);
+  atomic_store_explicit(&bucket->slots[victim].data, data,
+                        memory_order_relaxed);
+  atomic_store_explicit(&bucket->slots[victim].check, key ^ data,
+                        memory_order_relaxed);
+}
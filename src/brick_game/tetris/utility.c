@@ -8,7 +8,8 @@
  *
  * Updates the score of a game based on the number of cleared lines in a single
  * move. If the score is higher than the current high score, the high score will
- * be updated and saved.
+ * be updated and, unless the game is headless, saved. A changed score is
+ * noted in the change journal.
  *
  * @param game_info The game information
  * @param counter The number of cleared lines
@@ -23,10 +24,11 @@ void score_update(GameInfo *game_info, int counter) {
   } else if (counter == 4) {
     game_info->score += 1500;
   }
+  if (counter > 0) game_info->tetris->changes.flags |= CHANGED_SCORE;
 
   if (game_info->score > game_info->high_score) {
     game_info->high_score = game_info->score;
-    save_high_score(game_info);
+    if (game_info->tetris->persist_high_score) save_high_score(game_info);
   }
 }
 
@@ -43,7 +45,11 @@ void score_update(GameInfo *game_info, int counter) {
  */
 void level_speed_update(GameInfo *game_info) {
   if (game_info->level < LEVEL_MAX) {
-    game_info->level = game_info->score / 600;
+    int level = game_info->score / 600;
+    if (level != game_info->level) {
+      game_info->tetris->changes.flags |= CHANGED_LEVEL;
+    }
+    game_info->level = level;
 
     game_info->speed = SPEED_1 - game_info->level * 3000;
   }
@@ -81,11 +87,52 @@ int get_high_score() {
  * @brief Generates a random figure
  *
  * This function returns a random number between 0 and 6, which
- * is used to select a figure type.
+ * is used to select a figure type. It is drawn from the game's own
+ * generator, so games with equal seeds get equal pieces. In bag mode the
+ * seven figures are shuffled and dealt one by one before the next shuffle.
+ *
+ * @param game_info - pointer to GameInfo structure
  *
  * @return A random number between 0 and 6
  */
-int generate_figure() { return rand() % 7; }
+int generate_figure(GameInfo *game_info) {
+  TetrisState *tetris = game_info->tetris;
+  int type = 0;
+
+  if (!tetris->use_bag) {
+    type = (int)rng_below(&tetris->rng, FIGURES_COUNT);
+  } else {
+    if (tetris->bag_left == 0) {
+      for (int i = 0; i < FIGURES_COUNT; i++) tetris->bag[i] = (uint8_t)i;
+      for (int i = FIGURES_COUNT - 1; i > 0; i--) {
+        int j = (int)rng_below(&tetris->rng, (uint32_t)i + 1);
+        uint8_t swap = tetris->bag[i];
+        tetris->bag[i] = tetris->bag[j];
+        tetris->bag[j] = swap;
+      }
+      tetris->bag_left = FIGURES_COUNT;
+    }
+    type = tetris->bag[--tetris->bag_left];
+  }
+  return type;
+}
+
+/**
+ * @brief Restarts the piece sequence of a game from a seed
+ *
+ * Must be called before set_tetromino to affect the first pieces.
+ *
+ * @param game_info - pointer to GameInfo structure
+ * @param seed - any 64-bit value
+ * @param use_bag - TRUE for the 7-bag randomizer, FALSE for uniform pieces
+ */
+void tetris_seed(GameInfo *game_info, uint64_t seed, bool use_bag) {
+  TetrisState *tetris = game_info->tetris;
+  tetris->seed = seed;
+  rng_seed(&tetris->rng, seed);
+  tetris->use_bag = use_bag;
+  tetris->bag_left = 0;
+}
 
 /**
  * @brief Pauses or unpauses the game
@@ -103,12 +150,17 @@ void pause_game(GameInfo *game_info) {
   } else {
     game_info->pause = STARTED;
   }
+  game_info->tetris->changes.flags |= CHANGED_STATE;
 }
 
-void terminate_game(GameInfo *game_info) { game_info->pause = QUIT; }
+void terminate_game(GameInfo *game_info) {
+  game_info->pause = QUIT;
+  game_info->tetris->changes.flags |= CHANGED_STATE;
+}
 
 void start_game(Tetromino *tet, GameInfo *game_info) {
   game_info->pause = STARTED;
+  game_info->tetris->changes.flags |= CHANGED_STATE;
   spawn_new_figure(tet, game_info, figures);
 }
 
@@ -121,7 +173,8 @@ void start_game(Tetromino *tet, GameInfo *game_info) {
  * @param dest The dynamic 2D matrix to copy to.
  * @param src The static 2D matrix to copy from.
  */
-void stat_matrix_to_dyn(int **dest, int src[MAX_FIGURE_SIZE][MAX_FIGURE_SIZE]) {
+void stat_matrix_to_dyn(int **dest,
+                        const int src[MAX_FIGURE_SIZE][MAX_FIGURE_SIZE]) {
   for (int i = 0; i < MAX_FIGURE_SIZE; i++) {
     for (int j = 0; j < MAX_FIGURE_SIZE; j++) {
       dest[i][j] = src[i][j];
@@ -129,42 +182,12 @@ void stat_matrix_to_dyn(int **dest, int src[MAX_FIGURE_SIZE][MAX_FIGURE_SIZE]) {
   }
 }
 
-/**
- * @brief Frees the memory allocated for a Tetromino structure.
- *
- * This function deallocates the memory used by the Tetromino structure,
- * including its figure array and the structure itself.
- *
- * @param tetromino Pointer to the Tetromino to be freed.
- */
-void free_tetromino(Tetromino *tetromino) {
-  if (tetromino == NULL) return;
-  for (int i = 0; i < MAX_FIGURE_SIZE; i++) {
-    free(tetromino->figure[i]);
-  }
-  free(tetromino->figure);
-  free(tetromino);
-}
-
 /**
  * @brief Frees the memory allocated for a Game_Info structure.
  *
- * This function deallocates the memory used by the Game_Info structure,
- * including its field array, next array, and the structure itself.
+ * This function deallocates the block create_game_info made for the
+ * structure, its field array, next array and engine state.
  *
  * @param game_info Pointer to the Game_Info to be freed.
  */
-void free_game(GameInfo *game_info) {
-  if (game_info == NULL) return;
-
-  for (int i = 0; i < MAX_FIGURE_SIZE; i++) {
-    free(game_info->next[i]);
-  }
-  free(game_info->next);
-
-  for (int i = 0; i < FIELD_H; i++) {
-    free(game_info->field[i]);
-  }
-  free(game_info->field);
-  free(game_info);
-}
+void free_game(GameInfo *game_info) { free(game_info); }
@@ -0,0 +1,152 @@
+#include "../../inc/tetris/zobrist.h"
+
+/** @file */
+
+// Seed of the splitmix64 sequence the keys are taken from
+#define ZOBRIST_SEED 0x5A0B2157ull
+
+#if ZOBRIST_KEYS_WRITTEN_OUT
+
+/**
+ * @brief One random key per field cell, [row][column].
+ *
+ * Generated once with splitmix64 from ZOBRIST_SEED, so hashes are the same
+ * in every build and can be stored next to replays.
+ */
+const uint64_t zobrist_keys[TETRIS_H][TETRIS_W] = {
+    {0xA540CD89CD8B4F17ull, 0x8CB6745F23FDE6DDull, 0xB9EF8127DB8E905Cull,
+     0x2BF8219A27E7182Cull, 0xF25BBB3B03A27CECull, 0xF336EF092F72209Dull,
+     0x61E11619F433C62Cull, 0xF346309F9BF97237ull, 0xAA7BC2D5135E9FDFull,
+     0x555F1D03A821877Bull},
+    {0xEA6405D81FE9BDF3ull, 0x5B27A503E69FC79Aull, 0xA1E0CF4FD417B72Full,
+     0x58BB9F1FEDC0C295ull, 0x22CA0CC066BC91B9ull, 0x2BE978D62E5F7E53ull,
+     0x769FEF377C67B958ull, 0xB372A20021BB354Dull, 0x79348BA8F9E4458Dull,
+     0xED0DED8525930130ull},
+    {0xBC6777544DA37A64ull, 0xD3DB354E1A6329A9ull, 0xB347AF8D9D96C8FBull,
+     0x4D26EE5A36F7DF23ull, 0x5F6932CDDA57700Full, 0x4984DC2AC6977500ull,
+     0x5C815E34A1EB5F1Cull, 0xB34899F43358ECF4ull, 0xA1AD6700D89C54A0ull,
+     0xCFE2BDD834B45566ull},
+    {0x5D431650641CFF62ull, 0xFD0208E3E3C92E82ull, 0x0D583F498D148D5Cull,
+     0x121DB3D4F566724Cull, 0x493AEBE4936E7167ull, 0x10A2236310FBC110ull,
+     0xC8CD42D5A92C021Full, 0xE3225DD90D96C99Dull, 0xCF8BE99D228333E3ull,
+     0xB29D3DB8080827DAull},
+    {0xC6455D6F673B1C3Bull, 0xFF9D9AB515D97E9Dull, 0xBDD80BC72B8E56BFull,
+     0x29708AFF3E4E02C8ull, 0x4B6EFDB068399DC7ull, 0x34E1039A324D904Bull,
+     0x0AADAFCDF8BAA31Eull, 0x875252A4FBA6C4ACull, 0xF3DD147E1419F106ull,
+     0xE734EBEB75900263ull},
+    {0x7E5DC9630F075F69ull, 0xAD29223FF3D5C455ull, 0x5C48D1CE2970899Bull,
+     0xD467E277F76546E5ull, 0x7D8C05E21B1A0A02ull, 0x606C9BFAA7A47388ull,
+     0xA190373947F91D0Bull, 0xBE277EA5AA06FFF9ull, 0x28E65E6D2AADAB8Full,
+     0x6F76DB79A699108Cull},
+    {0x13186C34BBD0ACE8ull, 0x1102EB3ADB5A99D8ull, 0x6A6A3C3D06A67782ull,
+     0xD2A04B50CBBDF6C6ull, 0x1BED329E1E9A5787ull, 0x6630F9923F6431EEull,
+     0x8C9295770AC5C324ull, 0xF54BC7BE8E06E883ull, 0x5B36D3FDFB636F76ull,
+     0xB3E74B440383956Bull},
+    {0x14497ADC8FA6A817ull, 0xA55D2EE74495B4FAull, 0xADDD00FAAA640FBCull,
+     0x33CA9EC6CFF90733ull, 0x3A0B589C9A18D112ull, 0xC180FA55B21B4F75ull,
+     0x02B39B3E08BEBCFAull, 0x4220106B3850C4FFull, 0x1D914B9114FE81DBull,
+     0x1A5555A78A98482Dull},
+    {0xC320D631FCFB85FFull, 0xD6A47AAAF5276DFCull, 0x34F611292B0B7CC3ull,
+     0x768AB882BB5F50D5ull, 0x2A2C01C25F577E20ull, 0x71D583CFB2ED3A8Cull,
+     0xAF1D248EE72F89D2ull, 0xCD35507F3AB1CC34ull, 0x8311CC34F12C3F47ull,
+     0x21431E54AB12F9C4ull},
+    {0x86DCCE485BB8D7F0ull, 0x81153EE0F8231D1Bull, 0xFD7CE6A0F648D08Aull,
+     0xA8322C3BB0DAFCE5ull, 0xA290AE48899F0482ull, 0x14DC34789D970A25ull,
+     0x7369B0A8E4C55526ull, 0x17CFB603625F4921ull, 0x302D35806F1B784Cull,
+     0x2C7A320A43F99954ull},
+    {0xA8EDC247D84DC92Bull, 0xABB751FC214B58F9ull, 0xD39D2D1F783C6DB6ull,
+     0x2C825D00997A81DDull, 0xE5F9C0BAAE140C15ull, 0xCD462BAA10318244ull,
+     0x287B911006F4A0B7ull, 0xFEF636DE64689A34ull, 0xE7D23391F6794D0Bull,
+     0xAD874EC1BF0413B0ull},
+    {0x404ADB8026F045A6ull, 0x0FA6EC7963F7B816ull, 0xB8A2EF7227F0D7C7ull,
+     0xF921AAC3647967FCull, 0xECAB6DA8C373D58Bull, 0xA575505BE3ACC413ull,
+     0x1A6A2706ED0BF154ull, 0x3E641AA41B875172ull, 0x69C88396D8035DCBull,
+     0x5448597D904E3162ull},
+    {0x8CB80AC347DAFBAEull, 0x4C9D94A1D4EB0CA8ull, 0xFB5F8EF44FE49319ull,
+     0x1F6B2F092D0BE2DBull, 0x66934A2D1C79BD55ull, 0x96950769FD181EC2ull,
+     0x0BB36839F283B546ull, 0xE969C56A2653D8CCull, 0x6EEB17E50B43ED3Full,
+     0x78EF5B8638376345ull},
+    {0x6623326E5BAA96A4ull, 0xE554A69E5E791C45ull, 0x03DDA6D1C5A881B0ull,
+     0xD5776DAFBF4A4FB7ull, 0x88AF5C2CC80F115Eull, 0x17E25A84BC983947ull,
+     0x6AB765EA2B3958EDull, 0x924F11925DD62E36ull, 0xCA1D3A85F8EDD74Full,
+     0xE1764E11705E9174ull},
+    {0xA2424E9E70282A8Full, 0x7A475B60092C178Eull, 0x42694465B2087217ull,
+     0x2A914794F5B8BD2Cull, 0xC2287603EF63BE67ull, 0xD466BDF37F18024Eull,
+     0x84584BD9B593EBF1ull, 0xE47F25B8BDE0DE06ull, 0x461630A3BD262AA5ull,
+     0x77F49039D26558C7ull},
+    {0xC70EACD2BD0A6B74ull, 0xFAF534BD05BB8362ull, 0xE4349F53FEA9B443ull,
+     0xE871EE8A1681FFD3ull, 0x00FD31A53AE8DB28ull, 0x0832353B4AB9EBAFull,
+     0x72AC0AB05D67CB20ull, 0x211528F6A9AEF9F3ull, 0x86E06A775CA5F422ull,
+     0x2A62309662E33BAEull},
+    {0xD1C7631BD8CEB4C6ull, 0x85A9E21F09A3F6ADull, 0xDE27BA061C4C16E5ull,
+     0xC6CE81D562A5249Aull, 0x7A4B7BCC573FD69Aull, 0xF0E71BEC2FBF7A6Full,
+     0xDEC2744E1D3C21FFull, 0x9A664776FBAEF718ull, 0x4D54460018442D3Dull,
+     0x2B9D5621C570913Eull},
+    {0x975CA86DCF0F69C2ull, 0x8640F76C25ED02F6ull, 0x878E4D5FE9BF7B10ull,
+     0x35C3415966B070D0ull, 0x89A7F3F67C65C84Aull, 0x8ACB55DDF4C79884ull,
+     0xFE77944705011ACEull, 0xEAA1A022C1827CF3ull, 0xD3E777C45F7A5EDCull,
+     0xEF894410DBE37FDEull},
+    {0xB86DA11284C9A782ull, 0xDD42B0EC65D53603ull, 0xAEFC79B861578B91ull,
+     0x754A6524FC578508ull, 0xA518C49FDC82A7D7ull, 0x9F1EFF34FFC83F78ull,
+     0x39BBA50602854D9Cull, 0xE1E37D8F7B6BFADCull, 0x55CF3A739E71DE0Cull,
+     0x93BAE184D080620Eull},
+    {0x1623972934E4A713ull, 0x0D4CBF97B1931537ull, 0xA865E439E4F214B0ull,
+     0x7FC4CB31A0E95E91ull, 0xFE0D80B1C909944Aull, 0x1532C1BC15D3B0BBull,
+     0x7CC482CB3C4F2F3Full, 0x60E234CA5B4D37F0ull, 0xA1BF6813EFBD2123ull,
+     0x293FDC2E12D794C1ull}};
+
+#else
+
+uint64_t zobrist_keys[TETRIS_H][TETRIS_W];
+
+/**
+ * @brief Fills the keys of a board without a written out table before main,
+ * row by row from the same splitmix64 sequence.
+ */
+__attribute__((constructor)) static void generate_keys(void) {
+  uint64_t state = ZOBRIST_SEED;
+  for (int y = 0; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
+      uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      zobrist_keys[y][x] = z ^ (z >> 31);
+    }
+  }
+}
+
+#endif
+
+/**
+ * @brief Hash contribution of one packed row at row index y.
+ *
+ * @param y the row index
+ * @param row the filled cells of the row, bit x is column x
+ *
+ * @return XOR of the keys of the filled cells
+ */
+uint64_t zobrist_row(int y, BoardRow row) {
+  uint64_t hash = 0;
+  for (BoardRow bits = row; bits; bits &= (BoardRow)(bits - 1)) {
+    hash ^= zobrist_keys[y][BOARD_ROW_LOWEST(bits)];
+  }
+  return hash;
+}
+
+/**
+ * @brief Hashes a whole board from scratch.
+ *
+ * Games keep their hash up to date with zobrist_row instead, this is for
+ * boards built elsewhere and for checking the running hash.
+ *
+ * @param board the board to hash
+ *
+ * @return XOR of the keys of all filled cells, 0 for an empty board
+ */
+uint64_t zobrist_board(const Bitboard *board) {
+  uint64_t hash = 0;
+  for (int y = 0; y < TETRIS_H; y++) {
+    if (board->rows[y]) hash ^= zobrist_row(y, board->rows[y]);
+  }
+  return hash;
+}
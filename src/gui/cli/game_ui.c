@@ -0,0 +1,312 @@
+#include "../../inc/game_ui.h"
+
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+
+/**
+ * @brief Prints a rectangle on a given window using ncurses extended characters.
+ *
+ * @param[in] win the window to draw the rectangle on
+ * @param[in] top_y the y-coordinate of the top of the rectangle
+ * @param[in] bottom_y the y-coordinate of the bottom of the rectangle
+ * @param[in] left_x the x-coordinate of the left of the rectangle
+ * @param[in] right_x the x-coordinate of the right of the rectangle
+ */
+void print_rectangle(WINDOW *win, int top_y, int bottom_y, int left_x, int right_x) {
+  mvwaddch(win, top_y, left_x, ACS_ULCORNER);
+
+  int i = left_x + 1;
+  while (i < right_x) {
+    mvwaddch(win, top_y, i++, ACS_HLINE);
+  }
+  mvwaddch(win, top_y, i, ACS_URCORNER);
+
+  for (int i = top_y + 1; i < bottom_y; i++) {
+    mvwaddch(win, i, left_x, ACS_VLINE);
+    mvwaddch(win, i, right_x, ACS_VLINE);
+  }
+
+  mvwaddch(win, bottom_y, left_x, ACS_LLCORNER);
+  i = left_x + 1;
+  while (i < right_x) {
+    mvwaddch(win, bottom_y, i++, ACS_HLINE);
+  }
+  mvwaddch(win, bottom_y, i, ACS_LRCORNER);
+}
+
+/**
+ * @brief Prints the game field border.
+ *
+ * @param[in] win the window to draw the game field on
+ */
+void print_field(WINDOW *win) {
+  print_rectangle(win, 0, FIELD_HEIGHT, 0, FIELD_WIDTH);
+}
+
+/**
+ * @brief Prints one cell of the game field.
+ *
+ * @param[in] win the window to draw the cell on
+ * @param[in] game_info the game information structure
+ * @param[in] x the column of the cell
+ * @param[in] y the row of the cell
+ */
+static void print_play_cell(WINDOW *win, GameInfo *game_info, int x, int y) {
+  switch (game_info->field[y][x]) {
+    case 0: 
+      wattron(win, COLOR_PAIR(1));
+      mvwaddch(win, y+1, x+1, '.');
+      wattroff(win, COLOR_PAIR(1));
+      break;
+    case 1: 
+      mvwaddch(win, y+1, x+1, 'o');
+      break;
+    case 2: 
+      mvwaddch(win, y+1, x+1, '0');
+      break;
+    case 3: 
+      wattron(win, COLOR_PAIR(3));
+      mvwaddch(win, y+1, x+1, '@');
+      wattroff(win, COLOR_PAIR(3));
+      break;
+    default: 
+      break;
+  }
+}
+
+/**
+ * @brief Prints the game field on the given window.
+ *
+ * @param[in] win the window to draw the game field on
+ * @param[in] game_info the game information structure
+ */
+void print_play_field(WINDOW *win, GameInfo *game_info){
+  for (int y = 0; y < FIELD_H; ++y) {
+    for (int x = 0; x < FIELD_W; ++x) {
+      print_play_cell(win, game_info, x, y);
+    }
+  }
+}
+
+/**
+ * @brief Prints only the cells and rows of the game field a change journal
+ * lists, over a window that still shows the field before the changes.
+ * Cells outside the field are skipped.
+ *
+ * @param[in] win the window to draw the cells on
+ * @param[in] game_info the game information structure
+ * @param[in] changes the changes since the field was last drawn
+ */
+void print_changed_cells(WINDOW *win, GameInfo *game_info,
+                         const ChangeJournal *changes) {
+  for (int y = 0; changes->rows >> y && y < FIELD_H; ++y) {
+    if ((changes->rows >> y) & 1u) {
+      for (int x = 0; x < FIELD_W; ++x) print_play_cell(win, game_info, x, y);
+    }
+  }
+  for (int i = 0; i < changes->count; ++i) {
+    int x = changes->cells[i] & 0xff;
+    int y = changes->cells[i] >> 8;
+    if (x < FIELD_W && y < FIELD_H) print_play_cell(win, game_info, x, y);
+  }
+}
+
+/**
+ * @brief Prints the information bar on the game window.
+ *
+ * @param[in] win the window to draw the information bar on
+ * @param[in] game_info the game information structure
+ */
+void print_info_bar(WINDOW *win, GameInfo *game_info) {
+  print_rectangle(win, 0, 4, FIELD_WIDTH + 2, FIELD_WIDTH + 18);
+  mvwprintw(win, 1, 19, "Level:");
+  mvwprintw(win, 3, 21, "%d", game_info->level);
+
+  print_rectangle(win, 5, 9, FIELD_WIDTH + 2, FIELD_WIDTH + 18);
+  mvwprintw(win, 6, 19, "Score:");
+  mvwprintw(win, 8, 16, "%6d", game_info->score);
+
+  print_rectangle(win, 10, 14, FIELD_WIDTH + 2, FIELD_WIDTH + 18);
+  mvwprintw(win, 11, 16, "High Score:");
+  mvwprintw(win, 13, 16, "%6d", game_info->high_score);
+
+  print_rectangle(win, 15, FIELD_HEIGHT, FIELD_WIDTH + 2, FIELD_WIDTH + 18);
+}
+
+/**
+ * @brief Prints additional messages on the game window.
+ *
+ * @param[in] win the window to print the message on
+ * @param[in] pause_state the current pause state of the game
+ */
+void print_other_message(WINDOW *win, int pause_state) {
+  if (pause_state == PAUSED) {
+    mvwprintw(win, 1, 1, "PAUSE");
+  } else if (pause_state == WIN) {
+    mvwprintw(win, 1, 1, "You won!!!");
+  } else if (pause_state == LOSED) {
+    mvwprintw(win, 1, 1, "You lost!");
+  }
+}
+
+/**
+ * @brief Handles user input and returns the corresponding action.
+ *
+ * @param[in] ch the character input from the user
+ * @return the corresponding UserAction
+ */
+UserAction handle_user_input(int ch) {
+  switch (ch) {
+    case KEY_UP:
+      return Up;
+    case KEY_DOWN:
+      return Down;
+    case KEY_LEFT:
+      return Left;
+    case KEY_RIGHT:
+      return Right;
+    case 'p':
+    case 'P':
+      return Pause;
+    case 'q':
+    case 'Q':
+      return Terminate;
+    case '\n':
+      return Start;
+    case ' ':
+      return Action;
+    default:
+      return 333; // Default action
+  }
+}
+
+/**
+ * @brief Reads CLOCK_MONOTONIC, which neither the CPU time of the process
+ * nor changes of the wall clock move.
+ *
+ * @return the time in nanoseconds
+ */
+int64_t monotonic_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * @brief Creates a stopped tick timer.
+ *
+ * @param[out] timer the timer to create
+ */
+void tick_timer_open(TickTimer *timer) {
+  timer->period_us = 0;
+  timer->next_ns = 0;
+#ifdef __linux__
+  timer->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+#else
+  timer->fd = -1;
+#endif
+}
+
+/**
+ * @brief Releases the timerfd of a tick timer.
+ *
+ * @param[in,out] timer the timer to close
+ */
+void tick_timer_close(TickTimer *timer) {
+  if (timer->fd >= 0) close(timer->fd);
+  timer->fd = -1;
+  timer->period_us = 0;
+}
+
+/**
+ * @brief Runs the timer with the given tick length. A stopped timer or a
+ * new length starts a whole tick from now; the same length keeps the
+ * schedule, so calling this every frame does not drift.
+ *
+ * @param[in,out] timer the timer to run
+ * @param[in] period_us the length of a tick in microseconds, above 0
+ */
+void tick_timer_run(TickTimer *timer, int period_us) {
+  if (period_us == timer->period_us) return;
+  timer->period_us = period_us;
+  timer->next_ns = monotonic_ns() + (int64_t)period_us * 1000;
+#ifdef __linux__
+  if (timer->fd >= 0) {
+    struct timespec period = {period_us / 1000000,
+                              (long)(period_us % 1000000) * 1000};
+    struct itimerspec spec = {period, period};
+    timerfd_settime(timer->fd, 0, &spec, NULL);
+  }
+#endif
+}
+
+/**
+ * @brief Stops the timer, so that waiting only wakes up for input. Ticks
+ * missed while stopped are not made up.
+ *
+ * @param[in,out] timer the timer to stop
+ */
+void tick_timer_stop(TickTimer *timer) {
+  if (timer->period_us == 0) return;
+  timer->period_us = 0;
+#ifdef __linux__
+  if (timer->fd >= 0) {
+    struct itimerspec spec = {{0, 0}, {0, 0}};
+    timerfd_settime(timer->fd, 0, &spec, NULL);
+  }
+#endif
+}
+
+/**
+ * @brief Blocks in poll() until the terminal has input or a tick is due,
+ * without spending CPU time in between.
+ *
+ * @param[in,out] timer the frame timer, it may be stopped
+ * @param[out] input set when stdin has a key to read
+ * @return the ticks due since the last wait, at most TICK_TIMER_MAX_CATCH_UP
+ */
+int tick_timer_wait(TickTimer *timer, bool *input) {
+  struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {timer->fd, POLLIN, 0}};
+  int timeout_ms = -1;
+  if (timer->fd < 0 && timer->period_us) {
+    int64_t left_ns = timer->next_ns - monotonic_ns();
+    timeout_ms = left_ns > 0 ? (int)((left_ns + 999999) / 1000000) : 0;
+  }
+  int ready = poll(fds, timer->fd >= 0 ? 2 : 1, timeout_ms);
+  *input = ready > 0 && (fds[0].revents & POLLIN);
+
+  uint64_t ticks = 0;
+  if (timer->fd >= 0) {
+    if (ready > 0 && (fds[1].revents & POLLIN) &&
+        read(timer->fd, &ticks, sizeof(ticks)) != sizeof(ticks)) {
+      ticks = 0;
+    }
+  } else if (timer->period_us) {
+    int64_t now = monotonic_ns();
+    for (; timer->next_ns <= now && ticks <= TICK_TIMER_MAX_CATCH_UP;
+         ticks++) {
+      timer->next_ns += (int64_t)timer->period_us * 1000;
+    }
+    if (timer->next_ns <= now) {
+      timer->next_ns = now + (int64_t)timer->period_us * 1000;
+    }
+  }
+  return ticks > TICK_TIMER_MAX_CATCH_UP ? TICK_TIMER_MAX_CATCH_UP
+                                         : (int)ticks;
+}
+
+/**
+ * @brief Sleeps in poll() until the terminal has input or the timeout runs
+ * out, for loops whose deadline is kept elsewhere.
+ *
+ * @param[in] timeout_ms the longest sleep, -1 to wait for input only
+ * @return true when stdin has a key to read
+ */
+bool wait_for_input(int timeout_ms) {
+  struct pollfd fd = {STDIN_FILENO, POLLIN, 0};
+  return poll(&fd, 1, timeout_ms) > 0 && (fd.revents & POLLIN);
+}
@@ -1,11 +1,23 @@
+#include <string>
+
 #include "../../inc/snake/snake.h"
 #include "../../inc/snake/snake_controller.h"
 #include "../../inc/snake/snake_view.h"
 #include "../../inc/tetris/tetris.h"
+#include "../../inc/tetris/tetris_frontend.h"
 #include "../../inc/game_common.h"
+#include "../../inc/game_ui.h"
 
 /** @file */
 
+namespace {
+const char *record_path = nullptr;
+bool debug = false;
+const int kMenuOptions = 6;
+const char *const kMenuLabels[kMenuOptions] = {
+    "Snake", "Snake MCTS", "Tetris", "Tetris AI", "Tetris MCTS", "Exit"};
+}  // namespace
+
 /**
  * @brief Main function of console Brick Game application.
  *
@@ -16,10 +28,22 @@
  *
  * Program also handles user input errors and invalid game states.
  *
+ * With --record FILE every game is recorded into FILE, see replay.h. With
+ * --debug the games show their timing figures under the field.
+ *
  * @return 0 on success, 1 on error.
  */
-int main() {
+int main(int argc, char **argv) {
   int choosenOption = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--record" && i + 1 < argc) {
+      record_path = argv[++i];
+    } else if (arg == "--debug") {
+      debug = true;
+    }
+  }
+  tetris_record_to(record_path);
   s21::InitNcurses();
 
   while (choosenOption != -1) {
@@ -37,40 +61,21 @@ namespace s21 {
 /**
  * @brief Draws the main menu screen.
  *
- * Creates a window with the options "Snake", "Tetris", and "Exit".
- * The choosen_point parameter selects which option is highlighted.
+ * Creates a window with the options "Snake", "Snake MCTS", "Tetris",
+ * "Tetris AI", "Tetris MCTS" and "Exit". The choosen_point parameter selects
+ * which option is highlighted.
  *
- * @param choosen_point The currently selected option (0, 1, or 2).
+ * @param choosen_point The currently selected option (0 to 5).
  */
 void DrawMenuScreen(int choosen_point) {
   WINDOW *menuwin = newwin(20 * 3 + 1, 20 * 2 + 1, 1, 1);
   print_rectangle(menuwin, 0, FIELD_HEIGHT, 0, FIELD_WIDTH + 18);
-  switch (choosen_point) {
-    case 0:
-      wattron(menuwin, COLOR_PAIR(3));
-      mvwprintw(menuwin, 4, 12, "Snake");
-      wattroff(menuwin, COLOR_PAIR(3));
-      mvwprintw(menuwin, 6, 12, "Tetris");
-      mvwprintw(menuwin, 8, 12, "Exit");
-      wrefresh(menuwin);
-      break;
-    case 1:
-      mvwprintw(menuwin, 4, 12, "Snake");
-      wattron(menuwin, COLOR_PAIR(3));
-      mvwprintw(menuwin, 6, 12, "Tetris");
-      wattroff(menuwin, COLOR_PAIR(3));
-      mvwprintw(menuwin, 8, 12, "Exit");
-      wrefresh(menuwin);
-      break;
-    default:
-      mvwprintw(menuwin, 4, 12, "Snake");
-      mvwprintw(menuwin, 6, 12, "Tetris");
-      wattron(menuwin, COLOR_PAIR(3));
-      mvwprintw(menuwin, 8, 12, "Exit");
-      wattroff(menuwin, COLOR_PAIR(3));
-      wrefresh(menuwin);
-      break;
+  for (int i = 0; i < kMenuOptions; ++i) {
+    if (i == choosen_point) wattron(menuwin, COLOR_PAIR(3));
+    mvwprintw(menuwin, 4 + 2 * i, 12, "%s", kMenuLabels[i]);
+    if (i == choosen_point) wattroff(menuwin, COLOR_PAIR(3));
   }
+  wrefresh(menuwin);
 }
 
 /**
@@ -80,21 +85,23 @@ void DrawMenuScreen(int choosen_point) {
  * The selection is stored in the choosen_point parameter.
  *
  * The user can move the selection with the up/down arrow keys, and select
- * the highlighted option by pressing the enter key.
+ * the highlighted option by pressing the enter key. Between keys it sleeps
+ * in poll() instead of spinning on the non-blocking getch().
  *
- * @param choosen_point The currently selected option (0, 1, or 2).
+ * @param choosen_point The currently selected option (0 to 5).
  */
 void HandleInputMenu(int *choosen_point) {
+  wait_for_input(-1);
   int ch = getch();
   switch (ch) {
     case KEY_UP:
       (*choosen_point)--;
-      *choosen_point < 0 ? *choosen_point = *choosen_point + 3 : 0;
+      *choosen_point < 0 ? *choosen_point = *choosen_point + kMenuOptions : 0;
       break;
 
     case KEY_DOWN:
       (*choosen_point)++;
-      *choosen_point = *choosen_point % 3;
+      *choosen_point = *choosen_point % kMenuOptions;
       break;
 
     case '\n':
@@ -107,19 +114,26 @@ void HandleInputMenu(int *choosen_point) {
  * @brief Starts the game selected by the user.
  *
  * Checks the user's selection and starts either the snake game or the tetris
- * game. If the user selects an invalid option, the value of choosen_option is
- * set to -1.
+ * game, played by the user, by the autoplayer or by the tree search. If the
+ * user selects an invalid option, the value of choosen_option is set to -1.
  *
- * @param choosen_option The user's selection (0 for snake, 1 for tetris, or 2
- * for exit).
+ * @param choosen_option The user's selection (0 for snake, 1 for snake
+ * played by the tree search, 2 for tetris, 3 for tetris played by the
+ * autoplayer, 4 for tetris played by the tree search, or 5 for exit).
  */
 void StartChoosenGame(int *choosen_option) {
-  if (*choosen_option == 0) {
+  if (*choosen_option == 0 || *choosen_option == 1) {
     Snake game;
     SnakeController controller(game);
     SnakeView view(controller);
+    if (record_path) view.RecordTo(record_path);
+    view.UseAutopilot(*choosen_option == 1);
+    view.ShowDebug(debug);
     view.StartSnakeGame();
-  } else if (*choosen_option == 1) {
+  } else if (*choosen_option >= 2 && *choosen_option <= 4) {
+    tetris_autoplay(*choosen_option >= 3);
+    tetris_autoplay_mcts(*choosen_option == 4);
+    tetris_debug(debug);
     start_tetris_game();
   } else {
     *choosen_option = -1;
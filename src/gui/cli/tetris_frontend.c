@@ -1,9 +1,180 @@
 #include "../../inc/tetris/tetris_frontend.h"
 #include "../../inc/tetris/fsm.h"
 #include "../../inc/game_common.h"
+#include "../../inc/game_ui.h"
 
 /** @file */
 
+static const char *record_path = NULL;
+static Replay recording;
+static uint32_t gravity_ticks = 0;
+static bool autoplay = false;
+static TetrisAi ai;
+static TetrisBeam *beam = NULL;
+static bool autoplay_mcts = false;
+static TetrisMcts *mcts = NULL;
+static TickTimer timer;
+static bool debug = false;
+static long latency_keys = 0;  // Keys whose effect reached the screen
+static double latency_total_ms = 0;
+static double latency_max_ms = 0;
+
+/**
+ * @brief Records every following Tetris game into a replay file.
+ *
+ * @param[in] path the file to write when a game ends, NULL to stop recording
+ */
+void tetris_record_to(const char *path) { record_path = path; }
+
+/**
+ * @brief Lets the autoplayer place every piece of the following Tetris
+ * games. The keys still pause and quit.
+ *
+ * @param[in] enabled TRUE for the autoplayer, FALSE for a human player
+ */
+void tetris_autoplay(bool enabled) { autoplay = enabled; }
+
+/**
+ * @brief Lets the autoplayer plan with the Monte Carlo tree search instead
+ * of the beam search. It only plays while tetris_autoplay is on.
+ *
+ * @param[in] enabled TRUE for the tree search, FALSE for the beam search
+ */
+void tetris_autoplay_mcts(bool enabled) { autoplay_mcts = enabled; }
+
+/**
+ * @brief Shows the keypress-to-screen latency of the following Tetris games
+ * under the field.
+ *
+ * @param[in] enabled TRUE to show the line, FALSE to hide it
+ */
+void tetris_debug(bool enabled) { debug = enabled; }
+
+/**
+ * @brief Locks the tetromino if it has landed, as tetris_session_step does
+ * after every input, so that no key moves a piece that is already down.
+ *
+ * @param[in] tet the falling tetromino
+ * @param[in] game_info the current game
+ */
+static void lock_if_placed(Tetromino *tet, GameInfo *game_info) {
+  if (game_info->pause == STARTED && tet->is_placed) {
+    game_update(tet, game_info);
+  }
+}
+
+/**
+ * @brief Hands every key waiting in the terminal to user_input, so that a
+ * burst of keys is played in one frame instead of one frame each. A piece
+ * a key lands is locked before the next key, see lock_if_placed.
+ *
+ * @param[in] tet the falling tetromino
+ * @param[in] game_info the current game
+ * @return the keys read
+ */
+static int drain_keys(Tetromino *tet, GameInfo *game_info) {
+  int keys = 0;
+  for (int key = getch(); key != ERR; key = getch()) {
+    user_input(tet, game_info, key);
+    lock_if_placed(tet, game_info);
+    keys++;
+  }
+  return keys;
+}
+
+/**
+ * @brief Adds the keys of the frame just drawn to the latency figures.
+ *
+ * @param[in] keys the keys the frame shows the effect of
+ * @param[in] input_ns when poll() woke up for them, see monotonic_ns
+ */
+static void record_latency(int keys, int64_t input_ns) {
+  double ms = (monotonic_ns() - input_ns) / 1e6;
+  latency_keys += keys;
+  latency_total_ms += ms * keys;
+  if (ms > latency_max_ms) latency_max_ms = ms;
+}
+
+/**
+ * @brief Prints the mean and the largest keypress-to-screen latency under
+ * the field. A key counts from the wakeup of poll() for it until the
+ * frame showing its effect is on the terminal.
+ *
+ * @param[in] win the game window
+ */
+static void print_debug_line(WINDOW *win) {
+  double mean = latency_keys ? latency_total_ms / latency_keys : 0;
+  mvwprintw(win, FIELD_HEIGHT + 1, 0, "keys %ld latency %.2f/%.2f ms",
+            latency_keys, mean, latency_max_ms);
+}
+
+/**
+ * @brief Draws what the engine changed since the last frame. The window
+ * keeps the last frame, so only the cells in the change journal are drawn
+ * again, then the tetromino over them and the preview and the info bar if
+ * they changed. A change of state or a journal that overflowed redraws
+ * the whole window.
+ *
+ * @param[in] win the game window
+ * @param[in] tet the falling tetromino
+ * @param[in] game_info the current game
+ */
+static void draw_changes(WINDOW *win, Tetromino *tet, GameInfo *game_info) {
+  ChangeJournal *changes = &game_info->tetris->changes;
+  if (changes->flags & (CHANGED_CELLS_ALL | CHANGED_STATE)) {
+    werase(win);
+    if (debug) print_debug_line(win);
+    refresh_game(win, tet, game_info);
+  } else if (!journal_is_empty(changes)) {
+    print_changed_cells(win, game_info, changes);
+    draw_tetromino_on_field(win, tet);
+    if (changes->flags & CHANGED_NEXT) {
+      draw_next_tetromino_in_info(win, game_info);
+    }
+    if (changes->flags & (CHANGED_SCORE | CHANGED_LEVEL)) {
+      print_info_bar(win, game_info);
+    }
+    if (debug) print_debug_line(win);
+    wrefresh(win);
+  }
+  journal_clear(changes);
+}
+
+/**
+ * @brief Feeds the autoplayer's moves for a fresh piece through get_signal,
+ * recording them like keys. The beam search and the tree search plan
+ * within their time limits, so the frame still reads the keys on time.
+ *
+ * @param[in] tet the falling tetromino
+ * @param[in] game_info the current game
+ */
+static void autoplay_piece(Tetromino *tet, GameInfo *game_info) {
+  if (autoplay && game_info->pause == STARTED && !tet->is_placed) {
+    int count = mcts   ? tetris_mcts_plan(mcts, &ai, tet, game_info)
+                : beam ? tetris_beam_plan(beam, &ai, tet, game_info)
+                       : tetris_ai_plan(&ai, tet, game_info);
+    for (int i = 0; i < count; i++) {
+      if (record_path) replay_record(&recording, gravity_ticks, ai.moves[i]);
+      get_signal(tet, game_info, ai.moves[i]);
+      lock_if_placed(tet, game_info);
+    }
+  }
+}
+
+/**
+ * @brief Writes the finished game into the replay file, if recording.
+ *
+ * @param[in] game_info the finished game
+ */
+static void save_recording(GameInfo *game_info) {
+  if (record_path) {
+    replay_finish(&recording, gravity_ticks, game_info->score,
+                  field_hash(game_info->field, TETRIS_H, TETRIS_W));
+    replay_save(&recording, record_path);
+    replay_free(&recording);
+  }
+}
+
 /**
  * @brief Starts the Tetris game.
  *
@@ -25,56 +196,85 @@ void start_tetris_game() {
  * user input, and rendering. It initializes the game window, processes user
  * inputs to control the tetromino, updates the game state, and refreshes the
  * display accordingly. The loop continues until the game is either paused or
- * ended. It also handles the timing for tetromino movement and game speed.
+ * ended. Between frames it blocks until a key arrives or gravity is due;
+ * every waiting key is played as soon as it arrives, whatever the level.
+ * Gravity runs on its own monotonic timer with one tick per
+ * game_info->speed microseconds and catches up the ticks a late frame
+ * missed. The timer is stopped while the game is paused, so an idle game
+ * costs no CPU time. A frame only draws what the change journal of the
+ * engine lists, see draw_changes.
  * Upon game termination, it cleans up allocated resources.
  */
 
 void game_loop() {
-  srand(time(NULL));
-  generate_figure();
-
   GameInfo *game_info = get_game_info();
-  Tetromino *tet = set_tetromino(game_info);
-  int key = 0;
+  Tetromino piece = set_tetromino(game_info);
+  Tetromino *tet = &piece;
+  int input_keys = 0;  // Keys played since the last frame
+  int64_t input_ns = 0;
+
+  gravity_ticks = 0;
+  latency_keys = 0;
+  latency_total_ms = latency_max_ms = 0;
+  tetris_ai_init(&ai);
+  if (autoplay && autoplay_mcts) {
+    TetrisMctsConfig config;
+    tetris_mcts_default_config(&config);
+    config.seed = game_info->tetris->seed;
+    mcts = tetris_mcts_create(&config);
+  } else if (autoplay) {
+    TetrisBeamConfig config;
+    tetris_beam_default_config(&config);
+    beam = tetris_beam_create(&config);
+  }
+  if (record_path) {
+    replay_init(&recording, REPLAY_TETRIS, game_info->tetris->seed,
+                game_info->tetris->use_bag ? REPLAY_FLAG_BAG : 0);
+  }
 
+  tick_timer_open(&timer);
   WINDOW *startwin = newwin(20 * 3 + 1, 20 * 2 + 1, 1, 1);
   start_screen(startwin, tet, game_info);
 
-  clock_t lastTime, currentTime;
-  lastTime = clock();
-
   WINDOW *gamewin = newwin(20 * 3 + 1, 20 * 2 + 1, 1, 1);
   WINDOW *pausewin = newwin(20 * 3 + 1, 20 * 2 + 1, 1, 1);
   while (game_info->pause != QUIT && game_info->pause != LOSED) {
-    werase(gamewin);
+    if (game_info->pause == STARTED) {
+      tick_timer_run(&timer, game_info->speed);
+      draw_changes(gamewin, tet, game_info);
+    } else {
+      tick_timer_stop(&timer);
+      if (game_info->pause == PAUSED) print_pause_sceen(pausewin);
+    }
+    if (input_keys) record_latency(input_keys, input_ns);
 
-    currentTime = clock();
-    key = getch();
+    bool input = false;
+    int ticks = tick_timer_wait(&timer, &input);
+    input_ns = monotonic_ns();
+    input_keys = input ? drain_keys(tet, game_info) : 0;
+    autoplay_piece(tet, game_info);
 
-    user_input(tet, game_info, key);
-
-    refresh_game(gamewin, /*game_info->field,*/ tet, game_info);
     if (game_info->pause == STARTED) {
-      if ((currentTime - lastTime) > (CLOCKS_PER_SEC / 250)) {
+      for (int i = 0; i < ticks && game_info->pause == STARTED; i++) {
         move_tetromino_down_one_row(tet, game_info);
-        lastTime = currentTime;
+        gravity_ticks++;
+        if (tet->is_placed) game_update(tet, game_info);
       }
-      if (tet->is_placed) game_update(tet, game_info);
-
-    } else if (game_info->pause == PAUSED) {
-      print_pause_sceen(pausewin);
-      lastTime = currentTime;
     }
-    usleep(game_info->speed);
   }
+  tick_timer_close(&timer);
+  save_recording(game_info);
+  tetris_beam_destroy(beam);
+  beam = NULL;
+  tetris_mcts_destroy(mcts);
+  mcts = NULL;
   game_over_scree(gamewin, game_info);
-  free_tetromino(tet);
   free_game(game_info);
 }
 
 /**
  * @brief Reads user input and assigns the corresponding action to the given
- * pointer.
+ * pointer. Recognized keys are added to the replay when recording.
  *
  * @param[in] action pointer to a Signals enum variable, which will be set to
  * the corresponding action.
@@ -82,6 +282,7 @@ void game_loop() {
  */
 void user_input(Tetromino *tet, GameInfo *game_info, int sign) {
   UserAction action = handle_user_input(sign);
+  if (record_path) replay_record(&recording, gravity_ticks, action);
   get_signal(tet, game_info, action);
 }
 
@@ -183,7 +384,7 @@ void draw_play_field(WINDOW *win, /*int **play_field,*/ Tetromino *tet,
 /**
  * @brief Draws the active tetromino on the game field.
  *
- * This function iterates through the active tetromino's figure array and draws
+ * This function iterates through the active tetromino's 4x4 box and draws
  * each filled cell on the specified window at the correct position, applying a
  * specific color pair for visual distinction. The tetromino is drawn based on
  * its current coordinates, and only the occupied cells in the figure are
@@ -195,7 +396,7 @@ void draw_play_field(WINDOW *win, /*int **play_field,*/ Tetromino *tet,
 void draw_tetromino_on_field(WINDOW *win, Tetromino *tet) {
   for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
     for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-      if (tet->figure[y][x]) {
+      if (tetromino_cell(tet, x, y)) {
         wattron(win, COLOR_PAIR(3));
         mvwaddch(win, tet->coord.y + 1 + y, tet->coord.x + 1 + x, '#');
         wattroff(win, COLOR_PAIR(3));
@@ -269,6 +470,7 @@ void print_start_sceen(WINDOW *win) {
   mvwprintw(win, 12, 6, "-> Right");
   mvwprintw(win, 13, 6, "<- Left");
   mvwprintw(win, 14, 6, "Space - Rotate");
+  mvwprintw(win, 15, 6, "Up - Hard drop");
   mvwprintw(win, 16, 6, "P - Pause");
   mvwprintw(win, 17, 6, "Q - Quit");
   wrefresh(win);
@@ -313,19 +515,20 @@ void print_game_over_screen(WINDOW *win, GameInfo *game_info) {
  * @brief Displays the start screen of the game.
  *
  * Creates a new window and calls print_start_sceen() on it. The window is
- * then refreshed with wrefresh(). The function waits until the user presses
- * the Enter key and then deletes the window and clears the screen.
+ * then refreshed with wrefresh(). The function sleeps in poll() until the
+ * user presses the Enter key and then deletes the window and clears the
+ * screen.
  */
 
 void start_screen(WINDOW *startwin, Tetromino *tet, GameInfo *game_info) {
-  int key = 0;
+  bool input = false;
 
   while (game_info->pause == NOT_STARTED) {
-    key = getch();
     print_rectangle(startwin, 0, FIELD_HEIGHT, 0, FIELD_WIDTH + 18);
     print_start_sceen(startwin);
-    user_input(tet, game_info, key);
     wrefresh(startwin);
+    tick_timer_wait(&timer, &input);
+    if (input) user_input(tet, game_info, getch());
   }
   endwin();
 }
@@ -17,10 +17,24 @@ SOURCES += \
     desktop_main.cpp \
     ../../../brick_game/snake/snake.cpp \
     ../../../brick_game/snake/snake_controller.cpp \
+    ../../../brick_game/snake/snake_mcts.cpp \
     ../../../brick_game/tetris/field.c \
     ../../../brick_game/tetris/figure.c \
     ../../../brick_game/tetris/fsm.c \
     ../../../brick_game/tetris/utility.c \
+    ../../../brick_game/tetris/bitboard.c \
+    ../../../brick_game/tetris/figures.c \
+    ../../../brick_game/tetris/zobrist.c \
+    ../../../brick_game/tetris/ai.c \
+    ../../../brick_game/tetris/features.c \
+    ../../../brick_game/tetris/features_avx2.c \
+    ../../../brick_game/tetris/movegen.c \
+    ../../../brick_game/tetris/ttable.c \
+    ../../../brick_game/tetris/mcts.c \
+    ../../../brick_game/common/board.cpp \
+    ../../../brick_game/common/game_common.c \
+    ../../../brick_game/common/rng.c \
+    ../../../brick_game/common/replay.c \
 
 
 HEADERS += \
@@ -29,9 +43,24 @@ HEADERS += \
     desktop_main.h \
     ../../../inc/snake/snake.h \
     ../../../inc/snake/snake_controller.h \
+    ../../../inc/snake/snake_mcts.h \
+    ../../../inc/board.h \
+    ../../../inc/fixed_deque.h \
     ../../../inc/defines.h \
+    ../../../inc/game_common.h \
+    ../../../inc/rng.h \
+    ../../../inc/replay.h \
     ../../../inc/tetris/figures.h \
     ../../../inc/tetris/fsm.h \
+    ../../../inc/tetris/bitboard.h \
+    ../../../inc/tetris/zobrist.h \
+    ../../../inc/tetris/ai.h \
+    ../../../inc/tetris/features.h \
+    ../../../inc/tetris/movegen.h \
+    ../../../inc/tetris/ttable.h \
+    ../../../inc/tetris/mcts.h \
+
+LIBS += -pthread
 
 FORMS += \
     mainwindow.ui \
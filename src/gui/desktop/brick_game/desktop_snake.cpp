@@ -4,12 +4,18 @@
 
 namespace s21 {
 
+// Where a cell of the field is on the widget
+static QRect CellRect(int x, int y){
+    return QRect(x * CELL_SIZE, y * CELL_SIZE - SHIFT_Y, CELL_SIZE, CELL_SIZE);
+}
+
 SnakeQT::SnakeQT(SnakeController &controller, QWidget *parent) : QWidget(parent), controller(controller), gametimer(nullptr){
     setFixedSize(400,420);
 
     gametimer = new QTimer(this);
+    gametimer->setSingleShot(true);
+    gametimer->setTimerType(Qt::PreciseTimer);
     connect(gametimer, &QTimer::timeout, this, &SnakeQT::UpdateGame);
-    gametimer->start(1);
 }
 
 SnakeQT::~SnakeQT(){
@@ -127,10 +133,14 @@ void SnakeQT::keyPressEvent(QKeyEvent *event){
     case Qt::Key_Space:
         controller.UserInput(Action, 1);
         break;
+    case Qt::Key_M:
+        ToggleAutopilot();
+        break;
     default:
         QWidget::keyPressEvent(event);
 
     }
+    UpdateGame();
 }
 
 void SnakeQT::PrintMasseges(QPainter &painter){
@@ -150,16 +160,69 @@ void SnakeQT::PrintMasseges(QPainter &painter){
     }
 }
 
+// M hands the snake to the tree search and back; the search keeps to its
+// time limit, well below the length of a tick
+void SnakeQT::ToggleAutopilot(){
+    if(autopilot){
+        autopilot.reset();
+    }else{
+        auto config = SnakeMcts::DefaultConfig();
+        config.seed = controller.snake_.GetSeed();
+        autopilot = std::make_unique<SnakeMcts>(config);
+    }
+}
+
+void SnakeQT::PlayAutopilot(){
+    const Snake &snake = controller.snake_;
+    if(autopilot && snake.GetPauseState() == STARTED && snake.GetMoveFlag() &&
+       controller.GetTicks() != planned_tick){
+        planned_tick = controller.GetTicks();
+        controller.UserInput(autopilot->Plan(snake), 0);
+    }
+}
+
+// Moves the snake if its deadline has come; the autopilot plans right
+// after a move, long before the next one
 void SnakeQT::UpdateGame(){
     controller.UpdateCurrentState();
+    PlayAutopilot();
+    FinishFrame();
+}
+
+// Arms the single shot timer at the deadline of the next move, which the
+// controller keeps on the monotonic clock so that late timeouts do not
+// drift, or stops it while the snake does not move. Repaints only the
+// cells the change journal of the snake lists, which after a move are the
+// old head, the new head and the tail, and the info boxes when the score
+// or the level changed. A new state repaints everything; a game just over
+// is reset later.
+void SnakeQT::FinishFrame(){
+    int wait = controller.MillisecondsToNextTick();
+    if(wait < 0){
+        gametimer->stop();
+    }else{
+        gametimer->start(wait);
+    }
 
-    if(controller.snake_.GetPauseState() == LOSED || controller.snake_.GetPauseState() == WIN){
+    const ChangeJournal &changes = controller.snake_.GetChanges();
+    if(journal_is_empty(&changes)){
+        return;
+    }
+    int pause = controller.snake_.GetPauseState();
+    if((changes.flags & CHANGED_STATE) && (pause == LOSED || pause == WIN)){
         QTimer::singleShot(2000, this, &SnakeQT::ResetGame);
+    }
+    if(changes.flags & (CHANGED_CELLS_ALL | CHANGED_STATE)){
         update();
     }else{
-        update();
+        for(int i = 0; i < changes.count; i++){
+            update(CellRect(changes.cells[i] & 0xff, changes.cells[i] >> 8));
+        }
+        if(changes.flags & (CHANGED_SCORE | CHANGED_LEVEL)){
+            update(QRect(230, 10, 101, 291));
+        }
     }
-
+    controller.snake_.ClearChanges();
 }
 
 void SnakeQT::CloseEvent(QCloseEvent *event){
@@ -169,7 +232,7 @@ void SnakeQT::CloseEvent(QCloseEvent *event){
 
 void SnakeQT::ResetGame(){
     controller.ResetController();
-    update();
+    FinishFrame();
 }
 
 }//namespace s21
@@ -9,9 +9,13 @@
 #include <QBrush>
 #include <QTimer>
 
+#include <cstdint>
+#include <memory>
+
 
 #include "../../../inc/snake/snake.h"
 #include "../../../inc/snake/snake_controller.h"
+#include "../../../inc/snake/snake_mcts.h"
 #include "../../../inc/defines.h"
 
 
@@ -48,10 +52,15 @@ protected:
     void keyPressEvent(QKeyEvent *event) override;
     void CloseEvent(QCloseEvent *event);
     void ResetGame();
+    void ToggleAutopilot();
+    void PlayAutopilot();
+    void FinishFrame();
 
 private:
     SnakeController &controller;
-    QTimer *gametimer;
+    QTimer *gametimer;  // Single shot, armed for the next move of the snake
+    std::unique_ptr<SnakeMcts> autopilot;  // Tree search, empty for a human
+    std::uint32_t planned_tick = UINT32_MAX;
 
 };
 
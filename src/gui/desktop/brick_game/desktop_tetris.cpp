@@ -2,15 +2,31 @@
 
 
 namespace s21 {
-TetrisQT::TetrisQT(QWidget *parent) : QWidget(parent), gametimer(nullptr){
+// Gravity ticks a late timer makes up at most; after a longer stall the
+// rest are dropped instead of dropping the piece at once
+static const int kMaxCatchUpTicks = 4;
+
+// Where a cell of the field is on the widget
+static QRect CellRect(int x, int y){
+    return QRect(x*CELL_SIZE + SHIFT_X, y*CELL_SIZE + SHIFT_Y, CELL_SIZE, CELL_SIZE);
+}
+
+TetrisQT::TetrisQT(QWidget *parent) : QWidget(parent), gametimer(nullptr), next_tick_ms(0), period_ms(0), mcts(nullptr){
 
     game_tetris = get_game_info();
     tetromino = set_tetromino(game_tetris);
+    tetris_ai_init(&ai);
 
     setFixedSize(400, 420);
+    tick_clock.start();
     gametimer = new QTimer(this);
+    gametimer->setSingleShot(true);
+    gametimer->setTimerType(Qt::PreciseTimer);
     connect(gametimer, &QTimer::timeout, this, &TetrisQT::UpdateGameTetris);
-    gametimer->start(300);
+}
+
+TetrisQT::~TetrisQT(){
+    tetris_mcts_destroy(mcts);
 }
 
 void TetrisQT::paintEvent(QPaintEvent *event){
@@ -22,8 +38,8 @@ void TetrisQT::paintEvent(QPaintEvent *event){
     DrawFieldBorder(painter);
     if(game_tetris->pause == STARTED){
     DrawNextTetromino(painter, game_tetris, 245, 315);
-    DrawPlayField(painter, game_tetris);
-    DrawTetromino(painter, tetromino);}
+    DrawPlayField(painter, game_tetris, event->rect());
+    DrawTetromino(painter, &tetromino);}
     PrintMasseges(painter);
 
 }
@@ -45,16 +61,22 @@ void TetrisQT::DrawInfoBar(QPainter &painter, const GameInfo *game_info) {
     painter.drawText(275, 270, QString::number(game_info->high_score));
 }
 
-void TetrisQT::DrawPlayField(QPainter &painter, const GameInfo *game_info){
+// Only the cells under the dirty rectangle are looked at, which after a
+// move are the few cells FinishFrame asked to repaint
+void TetrisQT::DrawPlayField(QPainter &painter, const GameInfo *game_info, const QRect &dirty){
     painter.save();
 
     painter.setBrush(QBrush(Qt::red));
     painter.setPen(Qt::NoPen);
 
-    for(int y = 0; y < FIELD_H; y++){
-        for(int x = 0; x < FIELD_W; x++){
+    int top = qMax(0, (dirty.top() - SHIFT_Y) / CELL_SIZE);
+    int bottom = qMin(TETRIS_H - 1, (dirty.bottom() - SHIFT_Y) / CELL_SIZE);
+    int left = qMax(0, (dirty.left() - SHIFT_X) / CELL_SIZE);
+    int right = qMin(TETRIS_W - 1, (dirty.right() - SHIFT_X) / CELL_SIZE);
+    for(int y = top; y <= bottom; y++){
+        for(int x = left; x <= right; x++){
             if(game_info->field[y][x]){
-                painter.drawRect(x*CELL_SIZE + SHIFT_X, y*CELL_SIZE + SHIFT_Y, CELL_SIZE, CELL_SIZE);
+                painter.drawRect(CellRect(x, y));
             }
         }
     }
@@ -64,7 +86,7 @@ void TetrisQT::DrawPlayField(QPainter &painter, const GameInfo *game_info){
 void TetrisQT::DrawFieldBorder(QPainter &painter) {
     QPen pen(Qt::black);
     painter.setPen(pen);
-    painter.drawRect(SHIFT_X, SHIFT_Y, FIELD_W * CELL_SIZE, FIELD_H * CELL_SIZE);
+    painter.drawRect(SHIFT_X, SHIFT_Y, TETRIS_W * CELL_SIZE, TETRIS_H * CELL_SIZE);
 }
 
 void TetrisQT::DrawTetromino(QPainter &painter, const Tetromino *tet){
@@ -73,7 +95,7 @@ void TetrisQT::DrawTetromino(QPainter &painter, const Tetromino *tet){
 
     for (int y = 0; y < MAX_FIGURE_SIZE; ++y) {
         for (int x = 0; x < MAX_FIGURE_SIZE; ++x) {
-            if (tet->figure[y][x]) {
+            if (tetromino_cell(tet, x, y)) {
                 int drawX = (tet->coord.x + x) * CELL_SIZE;
                 int drawY = (tet->coord.y + y) * CELL_SIZE;
                 painter.drawRect(drawX + SHIFT_X, drawY + SHIFT_Y, CELL_SIZE, CELL_SIZE);
@@ -102,45 +124,140 @@ void TetrisQT::DrawNextTetromino(QPainter &painter, const GameInfo *game_info, i
 void TetrisQT::keyPressEvent(QKeyEvent *event){
     switch (event->key()) {
     case Qt::Key_Return:
-        get_signal(tetromino, game_tetris, Start);
+        get_signal(&tetromino, game_tetris, Start);
         break;
     case Qt::Key_Left:
-        get_signal(tetromino, game_tetris, Left);
+        get_signal(&tetromino, game_tetris, Left);
         break;
     case Qt::Key_Right:
-        get_signal(tetromino, game_tetris, Right);
+        get_signal(&tetromino, game_tetris, Right);
         break;
     case Qt::Key_Down:
-        get_signal(tetromino, game_tetris, Down);
+        get_signal(&tetromino, game_tetris, Down);
+        break;
+    case Qt::Key_Up:
+        get_signal(&tetromino, game_tetris, Up);
         break;
     case Qt::Key_Space:
-        get_signal(tetromino, game_tetris, Action);
+        get_signal(&tetromino, game_tetris, Action);
         break;
     case Qt::Key_Escape:
-        get_signal(tetromino, game_tetris, Terminate);
+        get_signal(&tetromino, game_tetris, Terminate);
         gameClosed();
         close();
         break;
     case Qt::Key_P:
-        get_signal(tetromino, game_tetris, Pause);
+        get_signal(&tetromino, game_tetris, Pause);
+        break;
+    case Qt::Key_M:
+        ToggleAutopilot();
         break;
     default:
         break;
     }
+    LockPlacedPiece();
+    PlayAutopilot();
+    FinishFrame();
+}
+
+// M hands the game to the tree search and back; the search keeps to its
+// time limit, well below one tick of the timer
+void TetrisQT::ToggleAutopilot(){
+    if(mcts){
+        tetris_mcts_destroy(mcts);
+        mcts = nullptr;
+    }else{
+        TetrisMctsConfig config;
+        tetris_mcts_default_config(&config);
+        config.seed = game_tetris->tetris->seed;
+        mcts = tetris_mcts_create(&config);
+    }
+}
+
+void TetrisQT::PlayAutopilot(){
+    if(mcts && game_tetris->pause == STARTED && !tetromino.is_placed){
+        int count = tetris_mcts_plan(mcts, &ai, &tetromino, game_tetris);
+        for(int i = 0; i < count; i++){
+            get_signal(&tetromino, game_tetris, ai.moves[i]);
+        }
+        LockPlacedPiece();
+    }
 }
 
+// Locks a piece the keys or the autopilot have landed, before gravity
+void TetrisQT::LockPlacedPiece(){
+    if(game_tetris->pause == STARTED && tetromino.is_placed){
+        game_update(&tetromino, game_tetris);
+    }
+}
+
+// Runs the gravity ticks that are due and arms the timer for the next one
 void TetrisQT::UpdateGameTetris(){
+    qint64 now = tick_clock.elapsed();
+    for(int ticks = 0; game_tetris->pause == STARTED && period_ms &&
+                       next_tick_ms <= now && ticks < kMaxCatchUpTicks; ticks++){
+        move_tetromino_down_one_row(&tetromino, game_tetris);
+        LockPlacedPiece();
+        next_tick_ms += period_ms;
+    }
+    if(next_tick_ms <= now){
+        next_tick_ms = now + period_ms;
+    }
+    PlayAutopilot();
+    FinishFrame();
+}
 
-    if(game_tetris->pause == STARTED){
-    move_tetromino_down_one_row(tetromino, game_tetris);
-    if(tetromino->is_placed){
-        game_update(tetromino, game_tetris);
+// Arms the single shot timer at the deadline of the next gravity tick. The
+// deadlines follow each other by game_info->speed on the monotonic clock,
+// so a late timeout does not shift the ones after it; a new level starts
+// its speed a whole tick from now. Gravity stops unless the game runs.
+void TetrisQT::ScheduleGravity(){
+    if(game_tetris->pause != STARTED){
+        gametimer->stop();
+        period_ms = 0;
+        return;
+    }
+    int period = game_tetris->speed / 1000;
+    if(period != period_ms){
+        period_ms = period;
+        next_tick_ms = tick_clock.elapsed() + period_ms;
     }
-    update();
-    } else if(game_tetris->pause == LOSED){
+    gametimer->start(static_cast<int>(qMax<qint64>(0, next_tick_ms - tick_clock.elapsed())));
+}
+
+// Arms gravity for the new state of the game and repaints what the change
+// journal of the engine lists: the cells the piece left and entered, the
+// rows a line clear moved and the info boxes whose numbers changed. A new
+// state repaints everything; a game just lost is reset later.
+void TetrisQT::FinishFrame(){
+    ScheduleGravity();
+    ChangeJournal *changes = &game_tetris->tetris->changes;
+    if(journal_is_empty(changes)){
+        return;
+    }
+    if((changes->flags & CHANGED_STATE) && game_tetris->pause == LOSED){
         QTimer::singleShot(2000, this, &TetrisQT::ResetGame);
+    }
+    if(changes->flags & (CHANGED_CELLS_ALL | CHANGED_STATE)){
         update();
+    }else{
+        // Rows past the journal's come with CHANGED_CELLS_ALL instead
+        for(int y = 0; y < qMin(TETRIS_H, CHANGE_JOURNAL_ROWS); y++){
+            if((changes->rows >> y) & 1u){
+                update(QRect(SHIFT_X, y*CELL_SIZE + SHIFT_Y, TETRIS_W*CELL_SIZE, CELL_SIZE));
+            }
+        }
+        for(int i = 0; i < changes->count; i++){
+            update(CellRect(changes->cells[i] & 0xff, changes->cells[i] >> 8));
+        }
+        if(changes->flags & CHANGED_NEXT){
+            update(QRect(230, 310, 101, 101));
+        }
+        if(changes->flags & (CHANGED_SCORE | CHANGED_LEVEL)){
+            update(QRect(230, 10, 101, 291));
+        }
     }
+    journal_clear(changes);
 }
 
 void TetrisQT::PrintMasseges(QPainter &painter){
@@ -164,12 +281,11 @@ void TetrisQT::CloseEvent(QCloseEvent *event){
 }
 
 void TetrisQT::ResetGame(){
-    free_tetromino(tetromino);
     free_game(game_tetris);
 
     game_tetris = get_game_info();
     tetromino = set_tetromino(game_tetris);
-    update();
+    FinishFrame();
 }
 
 
@@ -8,13 +8,17 @@
 #include <QPainter>
 #include <QBrush>
 #include <QTimer>
+#include <QElapsedTimer>
 
+#include <cstdint>
 
 
 #include "../../../inc/tetris/tetris.h"
 #include "../../../inc/tetris/figures.h"
 #include "../../../inc/defines.h"
 #include "../../../inc/tetris/fsm.h"
+#include "../../../inc/tetris/ai.h"
+#include "../../../inc/tetris/mcts.h"
 
 
 namespace s21 {
@@ -22,6 +26,7 @@ class TetrisQT : public QWidget{
     Q_OBJECT
 
 public: explicit TetrisQT(QWidget *parent = nullptr);
+    ~TetrisQT();
 
 signals:
     void gameClosed();
@@ -31,7 +36,7 @@ protected:
 
     void DrawInfoBar(QPainter &painter, const GameInfo *game_info);
     void DrawFieldBorder(QPainter &painter);
-    void DrawPlayField(QPainter &painter, const GameInfo *game_info);
+    void DrawPlayField(QPainter &painter, const GameInfo *game_info, const QRect &dirty);
 
     void DrawTetromino(QPainter &painter, const Tetromino *tet);
     void DrawNextTetromino(QPainter &painter, const GameInfo *game_info, int infoX, int infoY);
@@ -41,11 +46,21 @@ protected:
     void CloseEvent(QCloseEvent *event);
     void PrintMasseges(QPainter &painter);
     void ResetGame();
+    void ToggleAutopilot();
+    void PlayAutopilot();
+    void LockPlacedPiece();
+    void ScheduleGravity();
+    void FinishFrame();
 
 private:
     GameInfo *game_tetris;
-    Tetromino *tetromino;
-    QTimer *gametimer;
+    Tetromino tetromino;
+    QTimer *gametimer;           // Single shot, armed for the next gravity tick
+    QElapsedTimer tick_clock;    // Monotonic time the ticks are scheduled on
+    qint64 next_tick_ms;         // Deadline of the next gravity tick
+    int period_ms;               // Length of a tick, 0 while gravity is stopped
+    TetrisAi ai;
+    TetrisMcts *mcts;  // Tree search autopilot, nullptr while a human plays
 };
 
 }
@@ -0,0 +1,68 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_BOARD_H_
+#define CPP3_S21_BrickGame2_SRC_INC_BOARD_H_
+
+#include <array>
+
+#include "defines.h"
+
+namespace s21 {
+
+/**
+ * @brief A playing field whose size is fixed at compile time
+ *
+ * The cells are one contiguous block, so the compiler knows every bound and
+ * stride, and the row pointers let the board stand in for the int **field
+ * of GameInfo. A board points into itself and can not be copied.
+ *
+ * @tparam W columns
+ * @tparam H rows
+ */
+template <int W, int H>
+class Board {
+ public:
+  static_assert(W > 0 && H > 0, "a board needs at least one cell");
+
+  static constexpr int kWidth = W;
+  static constexpr int kHeight = H;
+  static constexpr int kCells = W * H;
+
+  using Cells = std::array<int, kCells>;
+
+  Board() {
+    for (int y = 0; y < H; ++y) rows_[y] = &cells_[y * W];
+  }
+  Board(const Board &) = delete;
+  Board &operator=(const Board &) = delete;
+
+  static constexpr bool Contains(int x, int y) {
+    return x >= 0 && x < W && y >= 0 && y < H;
+  }
+
+  int &At(int x, int y) { return cells_[y * W + x]; }
+  int At(int x, int y) const { return cells_[y * W + x]; }
+
+  void Clear() { cells_.fill(0); }
+
+  const Cells &GetCells() const { return cells_; }
+  void SetCells(const Cells &cells) { cells_ = cells; }
+
+  /**
+   * @brief Rows in the layout of GameInfo::field, field[y][x]
+   */
+  int **Rows() { return rows_.data(); }
+
+ private:
+  Cells cells_{};
+  std::array<int *, H> rows_;
+};
+
+// The board of the shipped games
+using StandardBoard = Board<FIELD_W, FIELD_H>;
+
+extern template class Board<FIELD_W, FIELD_H>;
+
+}  // namespace s21
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_BOARD_H_
@@ -3,9 +3,25 @@
 #ifndef CPP3_S21_BrickGame2_SRC_INC_DEFINES_H
 #define CPP3_S21_BrickGame2_SRC_INC_DEFINES_H
 
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
 #define FIELD_H 20
 #define FIELD_W 10
 
+// Tetris board, FIELD_W x FIELD_H unless a build picks another one, see
+// TETRIS_BOARD in the Makefile
+#ifndef TETRIS_W
+#define TETRIS_W FIELD_W
+#endif
+#ifndef TETRIS_H
+#define TETRIS_H FIELD_H
+#endif
+
 #define NOT_STARTED 0
 #define STARTED 1
 #define PAUSED 2
@@ -26,7 +42,7 @@
 #define HIGH_SCORE_PATH "build/high_score.txt"
 #define HIGH_SCORE_PATH_SNAKE "build/high_score_snake.txt"
 
-#define START_POS_FIGURE_X 4
+#define START_POS_FIGURE_X (TETRIS_W / 2 - 1)
 #define START_POS_FIGURE_Y 0
 
 #define MAX_FIGURE_SIZE 4
@@ -0,0 +1,71 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_FIXED_DEQUE_H_
+#define CPP3_S21_BrickGame2_SRC_INC_FIXED_DEQUE_H_
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+
+namespace s21 {
+
+/**
+ * @brief A double ended queue of at most N elements in a ring inside the
+ * object
+ *
+ * It never allocates, and for plain T it is plain data itself, so copying
+ * it is one memcpy. Pushing into a full queue is not checked.
+ */
+template <typename T, std::size_t N>
+class FixedDeque {
+ public:
+  FixedDeque() = default;
+  FixedDeque(std::initializer_list<T> items) { *this = items; }
+
+  FixedDeque &operator=(std::initializer_list<T> items) {
+    clear();
+    for (const T &item : items) push_back(item);
+    return *this;
+  }
+
+  static constexpr std::size_t capacity() { return N; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  void clear() { first_ = size_ = 0; }
+
+  T &operator[](std::size_t i) { return items_[Slot(i)]; }
+  const T &operator[](std::size_t i) const { return items_[Slot(i)]; }
+  T &front() { return items_[first_]; }
+  const T &front() const { return items_[first_]; }
+  T &back() { return items_[Slot(size_ - 1)]; }
+  const T &back() const { return items_[Slot(size_ - 1)]; }
+
+  void push_front(const T &item) {
+    first_ = first_ == 0 ? N - 1 : first_ - 1;
+    items_[first_] = item;
+    ++size_;
+  }
+  void push_back(const T &item) {
+    items_[Slot(size_)] = item;
+    ++size_;
+  }
+  void pop_front() {
+    first_ = first_ + 1 == N ? 0 : first_ + 1;
+    --size_;
+  }
+  void pop_back() { --size_; }
+
+ private:
+  std::size_t Slot(std::size_t i) const {
+    std::size_t slot = first_ + i;
+    return slot >= N ? slot - N : slot;
+  }
+
+  std::array<T, N> items_;
+  std::size_t first_ = 0;
+  std::size_t size_ = 0;
+};
+
+}  // namespace s21
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_FIXED_DEQUE_H_
@@ -3,13 +3,17 @@
 #ifndef CPP3_S21_BrickGame2_SRC_INC_GAME_COMMON_H_
 #define CPP3_S21_BrickGame2_SRC_INC_GAME_COMMON_H_
 
-#include <ncurses.h>
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "defines.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct TetrisState;
+
 /**
  * @brief Common game information structure for both Snake and Tetris
  */
@@ -21,6 +25,7 @@ typedef struct {
   int level;          // Current level
   int speed;          // Game speed
   int pause;          // Game state (NOT_STARTED, STARTED, PAUSED, etc.)
+  struct TetrisState* tetris;  // Packed Tetris engine state (NULL for Snake)
 } GameInfo;
 
 /**
@@ -45,20 +50,43 @@ typedef struct {
   int y;
 } Coordinates;
 
-// Common UI functions
-void print_rectangle(WINDOW *win, int top_y, int bottom_y, int left_x, int right_x);
-void print_field(WINDOW *win);
-void print_info_bar(WINDOW *win, GameInfo *game_info);
-void print_other_message(WINDOW *win, int pause_state);
-void print_play_field(WINDOW *win, GameInfo *game_info);
+// Cells a ChangeJournal lists before it gives up and asks for a full redraw
+#define CHANGE_JOURNAL_CELLS 64
+// Rows a ChangeJournal can mark, changes below them ask for a full redraw
+#define CHANGE_JOURNAL_ROWS 32
+
+// What changed besides the listed cells and rows
+#define CHANGED_CELLS_ALL 1  // Too many cells to list, redraw the field
+#define CHANGED_SCORE 2      // Score or high score
+#define CHANGED_LEVEL 4      // Level or speed
+#define CHANGED_NEXT 8       // Preview piece or apple
+#define CHANGED_STATE 16     // Pause state, the frame around the field
+#define CHANGED_EVERYTHING 31
+
+/**
+ * @brief Cells of the field an engine changed since a renderer last cleared
+ * the journal, so that the renderer draws only those
+ *
+ * A cell may be listed more than once. A cleared line shifts every row
+ * above it, so line clears mark whole rows instead of their cells.
+ */
+typedef struct {
+  uint16_t cells[CHANGE_JOURNAL_CELLS];  // y << 8 | x
+  uint16_t count;
+  uint16_t flags;  // CHANGED_* bits
+  uint32_t rows;   // Bit y set when the whole row y changed,
+                   // y < CHANGE_JOURNAL_ROWS
+} ChangeJournal;
 
 // Common game utility functions
 int get_high_score_from_file(const char* filename);
 void save_high_score_to_file(const char* filename, int score);
 void update_level_speed(GameInfo *game_info, int speed_step);
 
-// Common input handling
-UserAction handle_user_input(int ch);
+void journal_cell(ChangeJournal *journal, int x, int y);
+void journal_rows(ChangeJournal *journal, int top, int bottom);
+void journal_clear(ChangeJournal *journal);
+bool journal_is_empty(const ChangeJournal *journal);
 
 #ifdef __cplusplus
 }
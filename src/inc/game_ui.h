@@ -0,0 +1,55 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_GAME_UI_H_
+#define CPP3_S21_BrickGame2_SRC_INC_GAME_UI_H_
+
+#include <ncurses.h>
+#include <stdint.h>
+
+#include "defines.h"
+#include "game_common.h"
+
+// Ticks a late frame catches up at most; a longer stall, like a suspended
+// terminal, drops the rest instead of replaying them all at once
+#define TICK_TIMER_MAX_CATCH_UP 4
+
+/**
+ * @brief Fixed-timestep clock of a console game. On Linux it is a timerfd
+ * on CLOCK_MONOTONIC, elsewhere a monotonic deadline the poll times out on.
+ */
+typedef struct {
+  int fd;           // timerfd, -1 where the deadline is polled instead
+  int period_us;    // Length of a tick, 0 while stopped
+  int64_t next_ns;  // Monotonic time of the next tick, without a timerfd
+} TickTimer;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Common UI functions
+void print_rectangle(WINDOW *win, int top_y, int bottom_y, int left_x, int right_x);
+void print_field(WINDOW *win);
+void print_info_bar(WINDOW *win, GameInfo *game_info);
+void print_other_message(WINDOW *win, int pause_state);
+void print_play_field(WINDOW *win, GameInfo *game_info);
+void print_changed_cells(WINDOW *win, GameInfo *game_info,
+                         const ChangeJournal *changes);
+
+// Common input handling
+UserAction handle_user_input(int ch);
+
+// Common frame timing
+int64_t monotonic_ns(void);
+void tick_timer_open(TickTimer *timer);
+void tick_timer_close(TickTimer *timer);
+void tick_timer_run(TickTimer *timer, int period_us);
+void tick_timer_stop(TickTimer *timer);
+int tick_timer_wait(TickTimer *timer, bool *input);
+bool wait_for_input(int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_GAME_UI_H_
@@ -0,0 +1,74 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_REPLAY_H_
+#define CPP3_S21_BrickGame2_SRC_INC_REPLAY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game_common.h"
+
+#define REPLAY_MAGIC "BGRP"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 40
+
+#define REPLAY_TETRIS 0
+#define REPLAY_SNAKE 1
+
+#define REPLAY_FLAG_BAG 1  // Tetris pieces were dealt from 7-bags
+
+/**
+ * @brief A recorded session: seed, inputs and the expected outcome.
+ *
+ * Inputs are stored as varints of (tick delta << 3 | action), where tick is
+ * the number of game ticks (gravity steps or snake moves) run before the
+ * input. A typical input costs one byte.
+ */
+typedef struct {
+  uint8_t game;         // REPLAY_TETRIS or REPLAY_SNAKE
+  uint8_t flags;        // REPLAY_FLAG_* bits
+  uint64_t seed;        // Seed of the game's generator
+  uint32_t ticks;       // Ticks run by the whole session
+  int32_t score;        // Score at the end of the session
+  uint64_t board_hash;  // field_hash of the final field
+  uint32_t events;      // Number of recorded inputs
+  uint32_t last_tick;   // Tick of the last recorded input
+  uint8_t *data;        // Encoded inputs
+  size_t size;
+  size_t capacity;
+} Replay;
+
+/**
+ * @brief Read position in the inputs of a replay
+ */
+typedef struct {
+  const Replay *replay;
+  size_t offset;
+  uint32_t tick;
+  uint32_t events;
+} ReplayCursor;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void replay_init(Replay *replay, uint8_t game, uint64_t seed, uint8_t flags);
+void replay_free(Replay *replay);
+bool replay_record(Replay *replay, uint32_t tick, UserAction action);
+void replay_finish(Replay *replay, uint32_t ticks, int score,
+                   uint64_t board_hash);
+bool replay_save(const Replay *replay, const char *path);
+bool replay_load(Replay *replay, const char *path);
+
+void replay_cursor_init(ReplayCursor *cursor, const Replay *replay);
+bool replay_cursor_next(ReplayCursor *cursor, uint32_t *tick,
+                        UserAction *action);
+
+uint64_t field_hash(int **field, int rows, int cols);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_REPLAY_H_
@@ -0,0 +1,27 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_RNG_H_
+#define CPP3_S21_BrickGame2_SRC_INC_RNG_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief xoshiro256** generator state, one per game
+ */
+typedef struct {
+  uint64_t s[4];
+} Rng;
+
+void rng_seed(Rng *rng, uint64_t seed);
+uint64_t rng_next(Rng *rng);
+uint32_t rng_below(Rng *rng, uint32_t bound);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_RNG_H_
@@ -0,0 +1,72 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_SIM_PARSE_NUMBER_H_
+#define CPP3_S21_BrickGame2_SRC_INC_SIM_PARSE_NUMBER_H_
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+namespace s21 {
+
+// Largest thread count a command line option accepts
+constexpr long long kMaxOptionThreads = 1024;
+
+/**
+ * @brief Parses a whole decimal integer of a command line option.
+ *
+ * @param text the option value
+ * @param low smallest accepted value
+ * @param high largest accepted value
+ * @param number receives the value on success
+ *
+ * @return false if text is not a number in [low, high] or has trailing
+ * characters
+ */
+inline bool ParseInteger(const char *text, long long low, long long high,
+                         long long *number) {
+  char *end = nullptr;
+  errno = 0;
+  long long value = std::strtoll(text, &end, 10);
+  bool valid = end != text && *end == '\0' && errno != ERANGE &&
+               value >= low && value <= high;
+  if (valid) *number = value;
+  return valid;
+}
+
+/**
+ * @brief Parses a whole decimal integer that may use all 64 bits, e.g. a
+ * seed. A leading minus sign is rejected instead of wrapping around.
+ *
+ * @return false if text is not such a number
+ */
+inline bool ParseUnsigned(const char *text, std::uint64_t *number) {
+  char *end = nullptr;
+  errno = 0;
+  unsigned long long value = std::strtoull(text, &end, 10);
+  bool valid = *text >= '0' && *text <= '9' && *end == '\0' &&
+               errno != ERANGE;
+  if (valid) *number = value;
+  return valid;
+}
+
+/**
+ * @brief Parses a whole finite number of a command line option.
+ *
+ * @return false if text is not a number in [low, high] or has trailing
+ * characters
+ */
+inline bool ParseReal(const char *text, double low, double high,
+                      double *number) {
+  char *end = nullptr;
+  double value = std::strtod(text, &end);
+  bool valid = end != text && *end == '\0' && std::isfinite(value) &&
+               value >= low && value <= high;
+  if (valid) *number = value;
+  return valid;
+}
+
+}  // namespace s21
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_SIM_PARSE_NUMBER_H_
@@ -0,0 +1,111 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_SIM_WORK_STEALING_H_
+#define CPP3_S21_BrickGame2_SRC_INC_SIM_WORK_STEALING_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace s21 {
+
+constexpr std::size_t kCacheLineSize = 64;
+
+/**
+ * @brief Value padded to its own cache line so that per-thread counters do
+ * not share lines with their neighbours.
+ */
+template <typename T>
+struct alignas(kCacheLineSize) CacheAligned {
+  T value{};
+};
+
+/**
+ * @brief Runs indexed tasks on a fixed number of threads with work stealing.
+ *
+ * Task indices are dealt to per-worker deques in contiguous blocks. A worker
+ * pops from the back of its own deque and, once it is empty, moves half of
+ * the oldest tasks of another worker into its own deque. Tasks that take
+ * orders of magnitude longer than others therefore do not leave threads idle.
+ */
+class WorkStealingScheduler {
+ public:
+  explicit WorkStealingScheduler(unsigned threads)
+      : threads_(std::max(1u, threads)) {}
+
+  unsigned Threads() const { return threads_; }
+
+  /**
+   * @brief Calls task(worker, index) once for every index in [0, count).
+   *
+   * Returns when every task has finished. worker is in [0, Threads()).
+   */
+  template <typename Task>
+  void Run(std::size_t count, Task task) {
+    std::vector<Queue> queues(threads_);
+    for (unsigned w = 0; w < threads_; ++w) {
+      std::size_t begin = count * w / threads_;
+      std::size_t end = count * (w + 1) / threads_;
+      for (std::size_t i = begin; i < end; ++i) queues[w].items.push_back(i);
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads_);
+    for (unsigned w = 0; w < threads_; ++w) {
+      workers.emplace_back([this, w, &queues, &task] {
+        std::size_t index = 0;
+        while (Pop(queues, w, &index) || Steal(queues, w, &index)) {
+          task(w, index);
+        }
+      });
+    }
+    for (auto &worker : workers) worker.join();
+  }
+
+ private:
+  struct alignas(kCacheLineSize) Queue {
+    std::mutex mutex;
+    std::deque<std::size_t> items;
+  };
+
+  static bool Pop(std::vector<Queue> &queues, unsigned w, std::size_t *index) {
+    std::lock_guard<std::mutex> lock(queues[w].mutex);
+    if (queues[w].items.empty()) return false;
+    *index = queues[w].items.back();
+    queues[w].items.pop_back();
+    return true;
+  }
+
+  bool Steal(std::vector<Queue> &queues, unsigned w, std::size_t *index) {
+    for (unsigned step = 1; step < threads_; ++step) {
+      Queue &victim = queues[(w + step) % threads_];
+      std::deque<std::size_t> stolen;
+      {
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        std::size_t take = (victim.items.size() + 1) / 2;
+        for (std::size_t i = 0; i < take; ++i) {
+          stolen.push_back(victim.items.front());
+          victim.items.pop_front();
+        }
+      }
+      if (!stolen.empty()) {
+        *index = stolen.front();
+        stolen.pop_front();
+        std::lock_guard<std::mutex> lock(queues[w].mutex);
+        queues[w].items.insert(queues[w].items.end(), stolen.begin(),
+                               stolen.end());
+        return true;
+      }
+    }
+    return false;
+  }
+
+  unsigned threads_;
+};
+
+}  // namespace s21
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_SIM_WORK_STEALING_H_
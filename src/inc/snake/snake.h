@@ -3,29 +3,58 @@
 #ifndef CPP3_S21_BrickGame2_SRC_INC_SNAKE_SNAKE_H_
 #define CPP3_S21_BrickGame2_SRC_INC_SNAKE_SNAKE_H_
 
-#include <ncurses.h>
-
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
-#include <deque>
 #include <iostream>
 
+#include <cstdint>
+
+#include "../board.h"
+#include "../fixed_deque.h"
 #include "../defines.h"
 #include "../../inc/game_common.h"
+#include "../rng.h"
 
 namespace s21 {
 // Using common GameInfo and UserAction from game_common.h
 
-class Snake {
+/**
+ * @brief Snake on a W x H board
+ *
+ * The members are defined in snake.cpp and compiled for the boards listed at
+ * the end of this header; use Snake for the shipped 10 x 20 game.
+ */
+template <int W, int H>
+class BasicSnake {
  public:
+  using GameBoard = Board<W, H>;
+
   struct SnakeElements {
     int x;
     int y;
   };
 
-  Snake();
-  ~Snake();
+  // Room for a snake on every cell and the head it grows next
+  using Body = FixedDeque<SnakeElements, W * H + 1>;
+
+  /**
+   * @brief A whole game as plain data, see Clone and Restore
+   */
+  struct Snapshot {
+    typename GameBoard::Cells cells;
+    Body body;
+    GameInfo game_info;  // The pointers are not restored
+    int apple[2];
+    UserAction direction;
+    bool move_flag;
+    Rng rng;
+  };
+
+  BasicSnake();
+  explicit BasicSnake(bool persist_high_score);
+  BasicSnake(bool persist_high_score, std::uint64_t seed);
+  ~BasicSnake();
 
   void StartGame();
   void GenerateApple();
@@ -53,6 +82,9 @@ class Snake {
   void UpdateLevelSpeed();
   void ResetSnake();
 
+  void Clone(Snapshot &snapshot) const;
+  void Restore(const Snapshot &snapshot);
+
   // Access to apple coordinates (stored in next field of GameInfo)
 
   const GameInfo& GetGameInfo() const { return game_info_; };
@@ -86,15 +118,35 @@ class Snake {
   void SetPauseState(int pause) { game_info_.pause = pause; };
 
   int GetMoveFlag() const { return move_flag_; };
+  std::uint64_t GetSeed() const { return seed_; };
 
-  clock_t last_time_;
-  std::deque<SnakeElements> snake_coordinates_;
+  // Cells and fields changed since the renderer last called ClearChanges
+  const ChangeJournal &GetChanges() const { return changes_; };
+  void ClearChanges() { journal_clear(&changes_); };
+
+  Body snake_coordinates_;
 
  private:
+  void ResetApple();
+
   UserAction direction_;
   GameInfo game_info_;
+  GameBoard board_;
+  int apple_[2];        // x and y of the apple, -1 before the first one
+  int *apple_rows_[1];  // apple_ in the layout of GameInfo::next
   bool move_flag_;
+  bool persist_high_score_;
+  std::uint64_t seed_;
+  Rng rng_;
+  ChangeJournal changes_;  // Not part of a Snapshot, Restore redraws all
 };
+
+using Snake = BasicSnake<FIELD_W, FIELD_H>;
+
+extern template class BasicSnake<FIELD_W, FIELD_H>;
+extern template class BasicSnake<16, 40>;
+extern template class BasicSnake<64, 64>;
+
 }  // namespace s21
 
 #endif  // CPP3_S21_BrickGame2_SRC_INC_SNAKE_SNAKE_H_
\ No newline at end of file
@@ -3,20 +3,56 @@
 #ifndef CPP3_S21_BrickGame2_SRC_INC_SNAKE_CONTROLLER_H_
 #define CPP3_S21_BrickGame2_SRC_INC_SNAKE_CONTROLLER_H_
 
+#include <chrono>
+#include <cstdint>
+
 #include "snake.h"
 
 namespace s21 {
-class SnakeController {
+/**
+ * @brief Drives a BasicSnake of the same board
+ */
+template <int W, int H>
+class BasicSnakeController {
  public:
-  explicit SnakeController(Snake &snake);
-  ~SnakeController();
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief How late the timed ticks of UpdateCurrentState ran
+   */
+  struct TickStats {
+    long ticks;              // Ticks run on their deadline
+    long skipped;            // Deadlines dropped after a stall of a tick
+    double total_jitter_ms;  // Time past the deadlines, summed
+    double max_jitter_ms;
+  };
+
+  explicit BasicSnakeController(BasicSnake<W, H> &snake);
+  ~BasicSnakeController();
 
   void UserInput(UserAction action, bool hold);
   GameInfo UpdateCurrentState();
+  void Tick();
   void ResetController();
+  int MillisecondsToNextTick() const;
+  std::uint32_t GetTicks() const { return ticks_; }
+  const TickStats &GetTickStats() const { return tick_stats_; }
+
+  BasicSnake<W, H> &snake_;
 
-  Snake &snake_;
+ private:
+  std::uint32_t ticks_ = 0;
+  bool scheduled_ = false;  // next_tick_ is set, the snake is moving
+  Clock::time_point next_tick_;
+  TickStats tick_stats_{};
 };
+
+using SnakeController = BasicSnakeController<FIELD_W, FIELD_H>;
+
+extern template class BasicSnakeController<FIELD_W, FIELD_H>;
+extern template class BasicSnakeController<16, 40>;
+extern template class BasicSnakeController<64, 64>;
+
 }  // namespace s21
 
 #endif  // CPP3_S21_BrickGame2_SRC_INC_SNAKE_CONTROLLER_H_
\ No newline at end of file
@@ -0,0 +1,131 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_SNAKE_SNAKE_MCTS_H_
+#define CPP3_S21_BrickGame2_SRC_INC_SNAKE_SNAKE_MCTS_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "snake.h"
+#include "snake_controller.h"
+
+namespace s21 {
+
+/**
+ * @brief Monte Carlo tree search autopilot for a BasicSnake of the same
+ * board
+ *
+ * Every thread grows its own tree over the moves of the next ticks and the
+ * trees are only summed at the root. Each tree deals its own apples after
+ * the one on the board, so a tree sees one possible future and the sum over
+ * trees averages them; with a single apple sequence per tree the moves are
+ * compared on equal terms instead of drowning in the luck of the apples.
+ * The members are defined in snake_mcts.cpp and compiled for the boards of
+ * snake.h.
+ */
+template <int W, int H>
+class BasicSnakeMcts {
+ public:
+  using GameSnake = BasicSnake<W, H>;
+
+  /**
+   * @brief How the search plays and how long it may think
+   */
+  struct Config {
+    int threads;           // Trees grown side by side, one per thread
+    double time_limit_ms;  // Wall time of one decision, 0 for no limit
+    int iterations;        // Iterations per tree, 0 for no limit
+    int rollout_ticks;     // Ticks a rollout plays below the tree
+    bool greedy_rollouts;  // Rollouts head for the apple, not at random
+    double exploration;    // UCT constant, rewards are between 0 and 1
+    std::uint64_t seed;    // Seed of the apples and rollout moves
+  };
+
+  /**
+   * @brief What the decisions cost
+   */
+  struct Stats {
+    long decisions;
+    long iterations;  // Iterations of all trees
+    long nodes;       // Tree nodes created
+    long ticks;       // Ticks the engine played for the search
+    double total_ms;  // Wall time of all decisions
+    double longest_ms;
+  };
+
+  static Config DefaultConfig();
+
+  BasicSnakeMcts();
+  explicit BasicSnakeMcts(const Config &config);
+  BasicSnakeMcts(const BasicSnakeMcts &) = delete;
+  BasicSnakeMcts &operator=(const BasicSnakeMcts &) = delete;
+  ~BasicSnakeMcts();
+
+  UserAction Plan(const GameSnake &snake);
+  const Stats &GetStats() const { return stats_; }
+
+ private:
+  struct Node {
+    UserAction action;  // Move of the tick that led here
+    int first_child;    // Index of the first child, -1 if unexpanded
+    int child_count;
+    int visits;
+    double reward;  // Sum of the rewards of the iterations through here
+  };
+
+  /**
+   * @brief One tree, grown by one thread, with its own game to play in
+   */
+  struct alignas(64) Tree {
+    std::vector<Node> nodes;
+    int node_count = 0;
+    typename GameSnake::Snapshot root;
+    std::unique_ptr<GameSnake> snake;
+    std::unique_ptr<BasicSnakeController<W, H>> controller;
+    Rng rng;
+    int score = 0;        // Score of the game after the last tick
+    double apples = 0;    // Apples of this iteration, discounted
+    double discount = 1;  // Worth of an apple eaten in the last tick
+    long iterations = 0;
+    long ticks = 0;
+  };
+
+  void Worker(int index);
+  void GrowTree(Tree &tree);
+  void Iterate(Tree &tree);
+  void Expand(Tree &tree, int node, UserAction direction);
+  int SelectChild(const Tree &tree, int node) const;
+  bool IsSafe(const Tree &tree, UserAction move) const;
+  void Step(Tree &tree, UserAction move);
+  UserAction RolloutMove(Tree &tree);
+  double Reward(Tree &tree);
+
+  Config config_;
+  Stats stats_{};
+  std::vector<std::unique_ptr<Tree>> trees_;  // One per thread, caller first
+  bool has_deadline_ = false;
+  std::chrono::steady_clock::time_point deadline_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;  // A decision is posted or threads quit
+  std::condition_variable idle_;  // The last thread finished its tree
+  std::vector<std::thread> threads_;
+  unsigned job_id_ = 0;
+  int busy_ = 0;
+  bool quit_ = false;
+};
+
+using SnakeMcts = BasicSnakeMcts<FIELD_W, FIELD_H>;
+
+extern template class BasicSnakeMcts<FIELD_W, FIELD_H>;
+extern template class BasicSnakeMcts<16, 40>;
+extern template class BasicSnakeMcts<64, 64>;
+
+}  // namespace s21
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_SNAKE_SNAKE_MCTS_H_
@@ -3,14 +3,28 @@
 #ifndef CPP3_S21_BrickGame2_SRC_INC_SNAKE_VIEW_H_
 #define CPP3_S21_BrickGame2_SRC_INC_SNAKE_VIEW_H_
 
+#include <ncurses.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
 #include "snake_controller.h"
+#include "snake_mcts.h"
 #include "../game_common.h"
+#include "../game_ui.h"
+#include "../replay.h"
 
 namespace s21 {
 
 class SnakeView {
  public:
   explicit SnakeView(SnakeController &controller);
+  ~SnakeView();
+
+  void RecordTo(const std::string &path);
+  void UseAutopilot(bool enabled);
+  void ShowDebug(bool enabled) { debug_ = enabled; }
 
   void HandelInput();
   void StartSnakeGame();
@@ -20,8 +34,20 @@ class SnakeView {
   void PrintInfoBar(WINDOW *win);
   void DrawGameField(WINDOW *win/*, const GameInfo &game_info*/);
   void PrintOtherMessage(WINDOW *win);
+  void PrintDebugLine(WINDOW *win);
+  void DrawChanges(WINDOW *win);
 
   SnakeController &controller_;
+
+ private:
+  void SaveRecording();
+  void PlayAutopilot();
+
+  std::string record_path_;
+  Replay replay_{};
+  std::unique_ptr<SnakeMcts> autopilot_;
+  std::uint32_t planned_tick_ = UINT32_MAX;  // Tick the autopilot turned for
+  bool debug_ = false;  // Show the tick jitter under the field
 };
 
 // void PrintRectangle(WINDOW *win, int top_y, int bottom_y, int left_x,
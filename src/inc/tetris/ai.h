@@ -0,0 +1,74 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_AI_H_
+#define CPP3_S21_BrickGame2_SRC_INC_TETRIS_AI_H_
+
+#include "../defines.h"
+#include "../game_common.h"
+#include "features.h"
+#include "tetris.h"
+#include "ttable.h"
+
+// Rotations, then shifts across the whole field, then the hard drop
+#define TETRIS_AI_MAX_MOVES (ROTATIONS_COUNT + TETRIS_W + 1)
+
+// At most one placement per column for each rotation
+#define TETRIS_AI_MAX_PLACEMENTS (ROTATIONS_COUNT * TETRIS_W)
+
+/**
+ * @brief Where a piece ends up: its rotation and the field cell of its box
+ */
+typedef struct {
+  int rotation;
+  int x;
+  int y;
+} TetrisPlacement;
+
+/**
+ * @brief Weights of the board features a placement is scored by
+ */
+typedef struct {
+  double lines;      // Lines cleared by the placement
+  double height;     // Sum of the column heights
+  double holes;      // Empty cells with a filled cell above them
+  double bumpiness;  // Sum of height differences of neighbouring columns
+  double row_transitions;     // Filled/empty changes along the rows
+  double column_transitions;  // Filled/empty changes down the columns
+  double wells;               // Open cells between two filled neighbours
+} TetrisAiWeights;
+
+/**
+ * @brief Autoplayer state, the moves of the last plan and its counters
+ */
+typedef struct {
+  TetrisAiWeights weights;
+  bool lookahead;   // Also place the preview piece before scoring
+  TTable *table;    // Shared cache of scores and plans, may be NULL
+  long evaluated;   // Placements scored since tetris_ai_init
+  long table_hits;  // Lookups answered by the table
+  long table_misses;
+  UserAction moves[TETRIS_AI_MAX_MOVES];
+  int move_count;
+} TetrisAi;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void tetris_ai_init(TetrisAi *ai);
+int tetris_ai_plan(TetrisAi *ai, const Tetromino *tet,
+                   const GameInfo *game_info);
+double tetris_ai_evaluate(const TetrisAiWeights *weights,
+                          const TetrisState *state, int lines);
+int tetris_ai_placements(const TetrisState *state, int type, int rotation,
+                         int x, int y, TetrisPlacement *out);
+int tetris_ai_place(const TetrisAi *ai, TetrisState *state, int type,
+                    const TetrisPlacement *placement);
+int tetris_ai_moves(TetrisAi *ai, const Tetromino *tet,
+                    const TetrisPlacement *target);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_AI_H_
@@ -0,0 +1,56 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_BEAM_H_
+#define CPP3_S21_BrickGame2_SRC_INC_TETRIS_BEAM_H_
+
+#include "../defines.h"
+#include "ai.h"
+
+// The falling piece, the preview piece and one piece nobody has seen yet
+#define TETRIS_BEAM_MAX_DEPTH 3
+
+// Frame of game_loop in milliseconds, the speed it sleeps at level 0
+#define TETRIS_BEAM_TICK_MS (SPEED_1 / 1000)
+
+/**
+ * @brief How far and how wide a beam search looks and how long it may take
+ */
+typedef struct {
+  int depth;             // 1 the falling piece, 2 with the preview, 3 with
+                         // the piece after it averaged over all figures
+  int width;             // Positions kept after every level
+  int threads;           // Threads expanding a level, the caller included
+  double time_limit_ms;  // Wall time of one plan, 0 for no limit
+} TetrisBeamConfig;
+
+/**
+ * @brief What the plans of a beam search cost
+ */
+typedef struct {
+  long plans;
+  long levels;      // Levels finished over all plans
+  long timeouts;    // Plans that stopped a level early for the time limit
+  long overruns;    // Plans that still took longer than the time limit
+  long nodes;       // Positions expanded
+  double total_ms;  // Wall time of all plans
+  double longest_ms;
+} TetrisBeamStats;
+
+typedef struct TetrisBeam TetrisBeam;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void tetris_beam_default_config(TetrisBeamConfig *config);
+TetrisBeam *tetris_beam_create(const TetrisBeamConfig *config);
+void tetris_beam_destroy(TetrisBeam *beam);
+int tetris_beam_plan(TetrisBeam *beam, TetrisAi *ai, const Tetromino *tet,
+                     const GameInfo *game_info);
+void tetris_beam_stats(const TetrisBeam *beam, TetrisBeamStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_BEAM_H_
@@ -0,0 +1,79 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_BITBOARD_H_
+#define CPP3_S21_BrickGame2_SRC_INC_TETRIS_BITBOARD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../defines.h"
+
+#if TETRIS_W < MAX_FIGURE_SIZE || TETRIS_W > 64 || \
+    TETRIS_H < MAX_FIGURE_SIZE || TETRIS_H > 64
+#error "A Tetris board has 4 to 64 columns and 4 to 64 rows"
+#endif
+
+/**
+ * @brief One field row packed into bits, bit x is column x, in the
+ * narrowest word TETRIS_W columns fit in
+ */
+#if TETRIS_W <= 16
+typedef uint16_t BoardRow;
+#elif TETRIS_W <= 32
+typedef uint32_t BoardRow;
+#else
+typedef uint64_t BoardRow;
+#endif
+
+/**
+ * @brief A set of field rows, bit y is row y
+ */
+typedef uint64_t BoardRows;
+
+#define BOARD_ROW_BITS ((int)(8 * sizeof(BoardRow)))
+#define BOARD_BIT(x) ((BoardRow)((BoardRow)1 << (x)))
+#define BOARD_FULL_ROW \
+  ((BoardRow)((BoardRow)~(BoardRow)0 >> (BOARD_ROW_BITS - TETRIS_W)))
+
+// Filled cells of a row and the lowest filled column, row not 0
+#if TETRIS_W <= 32
+#define BOARD_ROW_COUNT(row) __builtin_popcount(row)
+#define BOARD_ROW_LOWEST(row) __builtin_ctz(row)
+#else
+#define BOARD_ROW_COUNT(row) __builtin_popcountll(row)
+#define BOARD_ROW_LOWEST(row) __builtin_ctzll(row)
+#endif
+
+/**
+ * @brief Packed Tetris field, one mask per row
+ */
+typedef struct {
+  BoardRow rows[TETRIS_H];
+} Bitboard;
+
+/**
+ * @brief Figure rows packed the same way as the field, bit x is box column x
+ */
+typedef struct {
+  BoardRow rows[MAX_FIGURE_SIZE];
+} PieceMask;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void bitboard_clear(Bitboard *board);
+void bitboard_load_field(Bitboard *board, int **field);
+
+bool bitboard_collides(const Bitboard *board, const PieceMask *mask, int x,
+                       int y);
+void bitboard_place(Bitboard *board, const PieceMask *mask, int x, int y);
+bool bitboard_row_is_full(const Bitboard *board, int y);
+int bitboard_remove_full_rows(Bitboard *board, int top, int bottom);
+void bitboard_column_heights(const Bitboard *board, int8_t *heights);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_BITBOARD_H_
@@ -0,0 +1,62 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_FEATURES_H_
+#define CPP3_S21_BrickGame2_SRC_INC_TETRIS_FEATURES_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../defines.h"
+#include "bitboard.h"
+
+// Boards measured together by board_features_batch
+#define BOARD_BATCH_SIZE 16
+
+// The AVX2 kernels hold a row and its two walls in a 16-bit lane and a
+// board in 20 lanes, other boards are measured by the scalar kernels
+#define BOARD_FEATURES_AVX2 (TETRIS_W <= 14 && TETRIS_H == 20)
+
+/**
+ * @brief What the autoplayer's heuristics read from a board
+ */
+typedef struct {
+  int8_t heights[TETRIS_W];     // Filled height of every column, 0 if empty
+  int16_t aggregate_height;    // Sum of the heights
+  int16_t bumpiness;           // Sum of neighbouring height differences
+  int16_t holes;               // Empty cells below a filled cell
+  int16_t row_transitions;     // Filled/empty changes along rows, walls full
+  int16_t column_transitions;  // Filled/empty changes down columns, floor full
+  int16_t wells;               // Open cells between two filled neighbours
+} BoardFeatures;
+
+/**
+ * @brief Boards stored row by row, rows[y][i] is row y of board i, so one
+ * vector holds the same row of every board
+ */
+typedef struct {
+  BoardRow rows[TETRIS_H][BOARD_BATCH_SIZE] __attribute__((aligned(32)));
+} BoardBatch;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void board_features(const Bitboard *board, BoardFeatures *features);
+void board_features_batch(const BoardBatch *batch, int count,
+                          BoardFeatures *features);
+void board_batch_set(BoardBatch *batch, int index, const Bitboard *board);
+
+bool board_features_avx2_supported(void);
+void board_features_scalar(const Bitboard *board, BoardFeatures *features);
+void board_features_batch_scalar(const BoardBatch *batch, int count,
+                                 BoardFeatures *features);
+void board_features_avx2(const Bitboard *board, BoardFeatures *features);
+void board_features_batch_avx2(const BoardBatch *batch, int count,
+                               BoardFeatures *features);
+void board_features_reference(int **field, BoardFeatures *features);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_FEATURES_H_
@@ -3,15 +3,37 @@
 #ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_FIGURES_H_
 #define CPP3_S21_BrickGame2_SRC_INC_TETRIS_FIGURES_H_
 
+#include <stdint.h>
+
 #include "../defines.h"
+#include "bitboard.h"
+
+#define ROTATIONS_COUNT 4
+
+/**
+ * @brief One precomputed orientation of a figure
+ */
+typedef struct {
+  PieceMask mask;                       // Packed rows of the 4x4 box
+  int8_t row_offset[MAX_FIGURE_SIZE];   // First filled column, -1 if empty
+  int8_t column_bottom[MAX_FIGURE_SIZE];  // Lowest filled row, -1 if empty
+  int8_t left, right, top, bottom;      // Bounding box inside the 4x4 box
+} ShapeOrientation;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const int figures[FIGURES_COUNT][MAX_FIGURE_SIZE][MAX_FIGURE_SIZE];
+extern const ShapeOrientation shape_table[FIGURES_COUNT][ROTATIONS_COUNT];
+
+bool shape_collides(const Bitboard *board, const ShapeOrientation *shape,
+                    int x, int y);
+void shape_place(Bitboard *board, const ShapeOrientation *shape, int x, int y);
+bool shape_spawn_blocked(const Bitboard *board, int type);
 
-static int figures[FIGURES_COUNT][MAX_FIGURE_SIZE][MAX_FIGURE_SIZE] = {
-    {{0, 0, 0, 0}, {0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {1, 1, 1, 1}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {1, 1, 0, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {0, 1, 1, 0}, {1, 1, 0, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {1, 1, 1, 0}, {1, 0, 0, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {1, 1, 1, 0}, {0, 0, 1, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {1, 1, 1, 0}, {0, 1, 0, 0}, {0, 0, 0, 0}}};
+#ifdef __cplusplus
+}
+#endif
 
-#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_FIGURES_H_
\ No newline at end of file
+#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_FIGURES_H_
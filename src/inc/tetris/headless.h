@@ -0,0 +1,64 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_HEADLESS_H_
+#define CPP3_S21_BrickGame2_SRC_INC_TETRIS_HEADLESS_H_
+
+#include "../defines.h"
+#include "../game_common.h"
+#include "tetris.h"
+
+/**
+ * @brief A Tetris game driven without a terminal or a clock
+ */
+typedef struct TetrisSession TetrisSession;
+
+/**
+ * @brief Storage for many sessions that is reused without allocating
+ */
+typedef struct TetrisArena TetrisArena;
+
+/**
+ * @brief State of a session after a step
+ */
+typedef struct {
+  int score;
+  int level;
+  int speed;
+  int state;   // NOT_STARTED, STARTED, PAUSED, LOSED or QUIT
+  int ticks;   // Gravity ticks run by this step
+  int pieces;  // Pieces locked by this step
+  int lines;   // Lines cleared by this step
+} TetrisStepResult;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TetrisSession *tetris_session_create();
+TetrisSession *tetris_session_create_seeded(uint64_t seed, bool use_bag);
+void tetris_session_destroy(TetrisSession *session);
+void tetris_session_reset(TetrisSession *session, uint64_t seed,
+                          bool use_bag);
+void tetris_session_clone(const TetrisSession *session,
+                          TetrisSnapshot *snapshot);
+void tetris_session_restore(TetrisSession *session,
+                            const TetrisSnapshot *snapshot);
+
+TetrisArena *tetris_arena_create(int capacity);
+void tetris_arena_destroy(TetrisArena *arena);
+TetrisSession *tetris_arena_session(TetrisArena *arena, uint64_t seed,
+                                    bool use_bag);
+void tetris_arena_reset(TetrisArena *arena);
+
+TetrisStepResult tetris_session_step(TetrisSession *session,
+                                     const UserAction *actions, int count,
+                                     int ticks);
+
+const GameInfo *tetris_session_info(const TetrisSession *session);
+const Tetromino *tetris_session_tetromino(const TetrisSession *session);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_HEADLESS_H_
@@ -0,0 +1,55 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_MCTS_H_
+#define CPP3_S21_BrickGame2_SRC_INC_TETRIS_MCTS_H_
+
+#include "../defines.h"
+#include "ai.h"
+
+// The tree holds the falling piece and the preview piece, whose types are
+// known; the pieces after them are left to the rollouts
+#define TETRIS_MCTS_TREE_DEPTH 2
+
+/**
+ * @brief How a Monte Carlo tree search plays and how long it may think
+ */
+typedef struct {
+  int threads;           // Trees grown side by side, one per thread
+  double time_limit_ms;  // Wall time of one decision, 0 for no limit
+  int iterations;        // Iterations per tree, 0 for no limit
+  int rollout_pieces;    // Pieces a rollout places below the tree
+  bool greedy_rollouts;  // Rollouts place like the autoplayer, not at random
+  double exploration;    // UCT constant, rewards are between 0 and 1
+  uint64_t seed;         // Seed of the rollout pieces and placements
+} TetrisMctsConfig;
+
+/**
+ * @brief What the decisions of a tree search cost
+ */
+typedef struct {
+  long decisions;
+  long iterations;  // Iterations of all trees
+  long nodes;       // Tree nodes created
+  long placements;  // Pieces the engine placed for the search
+  double total_ms;  // Wall time of all decisions
+  double longest_ms;
+} TetrisMctsStats;
+
+typedef struct TetrisMcts TetrisMcts;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void tetris_mcts_default_config(TetrisMctsConfig *config);
+TetrisMcts *tetris_mcts_create(const TetrisMctsConfig *config);
+void tetris_mcts_destroy(TetrisMcts *mcts);
+int tetris_mcts_plan(TetrisMcts *mcts, TetrisAi *ai, const Tetromino *tet,
+                     const GameInfo *game_info);
+void tetris_mcts_stats(const TetrisMcts *mcts, TetrisMctsStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_MCTS_H_
@@ -0,0 +1,51 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_MOVEGEN_H_
+#define CPP3_S21_BrickGame2_SRC_INC_TETRIS_MOVEGEN_H_
+
+#include <stdint.h>
+
+#include "../defines.h"
+#include "../game_common.h"
+#include "bitboard.h"
+#include "figures.h"
+
+// Columns a figure box can take, its left edge may be left of the field
+#define MOVEGEN_COLUMNS (TETRIS_W + MAX_FIGURE_SIZE - 1)
+#define MOVEGEN_MAX_STATES (ROTATIONS_COUNT * TETRIS_H * MOVEGEN_COLUMNS)
+
+/**
+ * @brief A position of the falling figure and the input that reached it
+ */
+typedef struct {
+  int8_t x, y, rotation;
+  uint8_t action;  // UserAction from the parent, Start for the first state
+  int16_t parent;  // Index of the previous state, -1 for the first state
+} MoveState;
+
+/**
+ * @brief Every position a figure can reach and the resting ones among them
+ */
+typedef struct {
+  MoveState states[MOVEGEN_MAX_STATES];
+  int state_count;
+  int16_t resting[MOVEGEN_MAX_STATES];  // Indices of states that cannot fall
+  int resting_count;
+} TetrisMoves;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void tetris_generate_moves(TetrisMoves *moves, const Bitboard *board,
+                           int type, int rotation, int x, int y);
+int tetris_move_path(const TetrisMoves *moves, int state, UserAction *path,
+                     int capacity);
+uint64_t tetris_perft(const Bitboard *board, const uint8_t *pieces,
+                      int depth);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_MOVEGEN_H_
@@ -3,26 +3,86 @@
 #ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_TETRIS_H_
 #define CPP3_S21_BrickGame2_SRC_INC_TETRIS_TETRIS_H_
 
-#include <ncurses.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
-#include <unistd.h>
 
 #include "../defines.h"
 #include "../game_common.h"
+#include "../rng.h"
+#include "bitboard.h"
+#include "figures.h"
+#include "zobrist.h"
 
 // Using common GameInfo and Coordinates from game_common.h
 
+#define TETRIS_DEFAULT_SEED 0x7E7215ull
+
+/**
+ * @brief Engine state behind the GameInfo view. The board is the source of
+ * truth, GameInfo::field mirrors it for renderers.
+ */
+typedef struct TetrisState {
+  Bitboard board;
+  int8_t heights[TETRIS_W];  // Filled height of every column, 0 if empty
+  int8_t placed_top;        // Rows the last placed figure covers, -1 when
+  int8_t placed_bottom;     // cleared by clear_placed_lines
+  uint64_t hash;            // Zobrist hash of the board, see zobrist.h
+  int lines_cleared;        // Lines cleared since the game was created
+  bool persist_high_score;  // Read and write HIGH_SCORE_PATH
+  uint64_t seed;            // Seed given to tetris_seed
+  Rng rng;                  // Piece generator of this game only
+  bool use_bag;             // Deal pieces from shuffled bags of all seven
+  int bag_left;             // Pieces not dealt yet from the current bag
+  uint8_t bag[FIGURES_COUNT];
+  ChangeJournal changes;  // What renderers have not drawn yet
+} TetrisState;
+
+/**
+ * @brief The falling piece. Its cells come from shape_table, so it is plain
+ * data that copies in a few bytes.
+ */
 typedef struct {
   int type;
   int next_type;
-  int **figure;
+  int rotation;  // Index into shape_table[type]
   Coordinates coord;
   bool can_spawn;
   bool is_placed;
 } Tetromino;
 
+// Tetris blocks are allocated on cache line boundaries
+#define TETRIS_BLOCK_ALIGN 64
+
+/**
+ * @brief Everything a Tetris game holds apart from the row views into it
+ */
+typedef struct {
+  GameInfo info;  // Its pointers lead into the enclosing TetrisGameBlock
+  TetrisState tetris;
+  int field[TETRIS_H][TETRIS_W];
+  int next[MAX_FIGURE_SIZE][MAX_FIGURE_SIZE];
+} TetrisGame;
+
+/**
+ * @brief A GameInfo together with everything it points to, so that a game
+ * is one allocation. The pointers of info lead into the block itself.
+ */
+typedef struct {
+  TetrisGame game;  // First member, the block is freed through game.info
+  int *field_rows[TETRIS_H];
+  int *next_rows[MAX_FIGURE_SIZE];
+} TetrisGameBlock;
+
+/**
+ * @brief A copy of a whole game and its falling piece, plain data that
+ * tetris_snapshot_restore can put back into any game
+ */
+typedef struct {
+  TetrisGame game;
+  Tetromino tetromino;
+} TetrisSnapshot;
+
 // Using common UserAction from game_common.h instead of Signals
 
 #ifdef __cplusplus
@@ -34,36 +94,52 @@ void start_game(Tetromino *tet, GameInfo *game_info);
 void start_tetris_game();
 void game_update(Tetromino *tetromino, GameInfo *game_info);
 void game_loop();
-void free_tetromino(Tetromino *tetromino);
 void free_game(GameInfo *game_info);
 
-Tetromino *set_tetromino(GameInfo *game_info);
+Tetromino set_tetromino(GameInfo *game_info);
 
 void set_start_position_for_tetromino(Tetromino *tetromino);
 void generate_next_tetromino(Tetromino *tetromino, GameInfo *game_info,
-                             int figures[7][4][4]);
+                             const int figures[7][4][4]);
 void spawn_new_figure(Tetromino *tetromino, GameInfo *game_info,
-                      int figures[7][4][4]);
+                      const int figures[7][4][4]);
+const ShapeOrientation *get_tetromino_shape(const Tetromino *tetromino);
+int tetromino_cell(const Tetromino *tetromino, int x, int y);
 void move_tetromino_down_one_row(Tetromino *tet, GameInfo *game_info);
 void drop_tetromino(Tetromino *tet, GameInfo *game_info);
+void hard_drop_tetromino(Tetromino *tet, GameInfo *game_info);
+int shape_landing_row(const TetrisState *tetris, const ShapeOrientation *shape,
+                      int x, int y);
+int tetromino_landing_row(const Tetromino *tet, const GameInfo *game_info);
 void move_tetromino_left(Tetromino *tet, GameInfo *game_info);
 void move_tetromino_right(Tetromino *tet, GameInfo *game_info);
 void rotate_tetromino(Tetromino *tet, GameInfo *game_info);
 void terminate_game(GameInfo *game_info);
 
 GameInfo *get_game_info();
+GameInfo *create_game_info(bool persist_high_score);
+GameInfo *init_game_info(TetrisGameBlock *block, bool persist_high_score);
+void tetris_snapshot_save(const GameInfo *game_info, const Tetromino *tet,
+                          TetrisSnapshot *snapshot);
+void tetris_snapshot_restore(GameInfo *game_info, Tetromino *tet,
+                             const TetrisSnapshot *snapshot);
 void place_tetromino_on_field(Tetromino *tetromino, GameInfo *game_info);
 int clear_line(GameInfo *game_info);
+int clear_placed_lines(GameInfo *game_info);
 void line_dropper(GameInfo *game_info);
 void check_game_over(Tetromino *tetromino, GameInfo *game_info);
+void sync_board_with_field(GameInfo *game_info);
+uint64_t tetris_board_hash(const GameInfo *game_info);
 
 void score_update(GameInfo *game_info, int counter);
 void level_speed_update(GameInfo *game_info);
 void save_high_score(GameInfo *game_info);
 int get_high_score();
-int generate_figure();
+int generate_figure(GameInfo *game_info);
+void tetris_seed(GameInfo *game_info, uint64_t seed, bool use_bag);
 void pause_game(GameInfo *game_info);
-void stat_matrix_to_dyn(int **dest, int src[MAX_FIGURE_SIZE][MAX_FIGURE_SIZE]);
+void stat_matrix_to_dyn(int **dest,
+                        const int src[MAX_FIGURE_SIZE][MAX_FIGURE_SIZE]);
 
 #ifdef __cplusplus
 }
@@ -4,10 +4,16 @@
 #define CPP3_S21_BrickGame2_SRC_INC_TETRIS_TETRIS_FRONTEND_H_
 
 #include <ncurses.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "../defines.h"
 #include "../game_common.h"
+#include "../game_ui.h"
+#include "../replay.h"
+#include "ai.h"
+#include "beam.h"
+#include "mcts.h"
 #include "tetris.h"
 
 #ifdef __cplusplus
@@ -35,6 +41,10 @@ void start_screen(WINDOW *startwin, Tetromino *tet, GameInfo *game_info);
 void game_over_scree(WINDOW *win, GameInfo *game_info);
 
 void user_input(Tetromino *tet, GameInfo *game_info, int sign);
+void tetris_record_to(const char *path);
+void tetris_autoplay(bool enabled);
+void tetris_autoplay_mcts(bool enabled);
+void tetris_debug(bool enabled);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,47 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_TTABLE_H_
+#define CPP3_S21_BrickGame2_SRC_INC_TETRIS_TTABLE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Fixed size transposition table shared by search threads
+ */
+typedef struct TTable TTable;
+
+/**
+ * @brief What an entry holds, part of its key
+ */
+typedef enum {
+  TTABLE_PREVIEW = 1,  // Best score of the preview piece on a board
+  TTABLE_PLAN = 2,     // Best placement of the falling piece from spawn
+} TTableKind;
+
+/**
+ * @brief The value of an entry
+ */
+typedef struct {
+  float score;
+  int8_t rotation, x, y;  // Placement, only for TTABLE_PLAN
+} TTableEntry;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TTable *ttable_create(size_t megabytes);
+void ttable_destroy(TTable *table);
+void ttable_age(TTable *table);
+uint64_t ttable_key(uint64_t board_hash, TTableKind kind, int current,
+                    int next, uint64_t salt);
+bool ttable_probe(TTable *table, uint64_t key, TTableEntry *entry);
+void ttable_store(TTable *table, uint64_t key, const TTableEntry *entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_TTABLE_H_
@@ -0,0 +1,32 @@
+/** @file */
+
+#ifndef CPP3_S21_BrickGame2_SRC_INC_TETRIS_ZOBRIST_H_
+#define CPP3_S21_BrickGame2_SRC_INC_TETRIS_ZOBRIST_H_
+
+#include <stdint.h>
+
+#include "../defines.h"
+#include "bitboard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The keys of the 10x20 board are written out, other boards generate
+// theirs when the program starts
+#define ZOBRIST_KEYS_WRITTEN_OUT (TETRIS_W == 10 && TETRIS_H == 20)
+
+#if ZOBRIST_KEYS_WRITTEN_OUT
+extern const uint64_t zobrist_keys[TETRIS_H][TETRIS_W];
+#else
+extern uint64_t zobrist_keys[TETRIS_H][TETRIS_W];
+#endif
+
+uint64_t zobrist_row(int y, BoardRow row);
+uint64_t zobrist_board(const Bitboard *board);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CPP3_S21_BrickGame2_SRC_INC_TETRIS_ZOBRIST_H_
@@ -1,6 +1,13 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <vector>
+
 #include "../inc/snake/snake.h"
+#include "../inc/snake/snake_controller.h"
+#include "../inc/snake/snake_mcts.h"
 using namespace s21;
 
 TEST(SnakeModel, Constuctor) {
@@ -274,4 +281,170 @@ TEST(SnakeModel, Restart) {
   EXPECT_EQ(snake.GetScore(), NOT_STARTED);
 
   EXPECT_EQ(snake.GetDirection(), Up);
-}
\ No newline at end of file
+}
+
+TEST(SnakeController, TickMovesWithoutHighScoreFile) {
+  Snake snake(false);
+  SnakeController controller(snake);
+
+  controller.UserInput(Start, false);
+  auto initialHead = snake.snake_coordinates_.front();
+  controller.Tick();
+
+  EXPECT_EQ(snake.GetGameInfo().high_score, 0);
+  EXPECT_EQ(snake.snake_coordinates_.front().y, initialHead.y - 1);
+  EXPECT_EQ(snake.snake_coordinates_.size(), 4);
+}
+
+TEST(SnakeController, MovesOnMonotonicDeadlines) {
+  Snake snake(false);
+  SnakeController controller(snake);
+  EXPECT_EQ(controller.MillisecondsToNextTick(), -1);
+
+  snake.SetSpeed(20);
+  controller.UserInput(Start, false);
+  controller.UpdateCurrentState();
+  EXPECT_EQ(controller.GetTicks(), 0);
+  int wait = controller.MillisecondsToNextTick();
+  EXPECT_GT(wait, 0);
+  EXPECT_LE(wait, 20);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+  controller.UpdateCurrentState();
+  EXPECT_EQ(controller.GetTicks(), 1);
+  EXPECT_EQ(controller.GetTickStats().ticks, 1);
+  EXPECT_GE(controller.GetTickStats().max_jitter_ms, 0);
+  EXPECT_LE(controller.MillisecondsToNextTick(), 20);
+
+  controller.UserInput(Pause, false);
+  controller.UpdateCurrentState();
+  EXPECT_EQ(controller.MillisecondsToNextTick(), -1);
+  EXPECT_EQ(controller.GetTicks(), 1);
+}
+
+TEST(SnakeModel, SeededApplesRepeat) {
+  Snake first(false, 1234);
+  Snake second(false, 1234);
+
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(first.GetApple()[0][0], second.GetApple()[0][0]);
+    EXPECT_EQ(first.GetApple()[0][1], second.GetApple()[0][1]);
+    first.GenerateApple();
+    second.GenerateApple();
+  }
+}
+
+TEST(SnakeModel, JournalsTheCellsOfAMove) {
+  Snake snake(false, 7);
+  EXPECT_EQ(snake.GetChanges().flags, CHANGED_EVERYTHING);
+  snake.StartGame();
+  snake.ClearChanges();
+
+  auto neck = snake.snake_coordinates_.front();
+  auto tail = snake.snake_coordinates_.back();
+  snake.MoveSnake(Up);
+  auto head = snake.snake_coordinates_.front();
+  const ChangeJournal &changes = snake.GetChanges();
+  ASSERT_EQ(changes.count, 3);
+  EXPECT_EQ(changes.flags, 0);
+  EXPECT_EQ(changes.rows, 0u);
+  EXPECT_EQ(changes.cells[0], tail.y << 8 | tail.x);
+  EXPECT_EQ(changes.cells[1], neck.y << 8 | neck.x);
+  EXPECT_EQ(changes.cells[2], head.y << 8 | head.x);
+  EXPECT_EQ(snake.GetField()[tail.y][tail.x], 0);
+  EXPECT_EQ(snake.GetField()[neck.y][neck.x], 1);
+  EXPECT_EQ(snake.GetField()[head.y][head.x], 2);
+
+  snake.PauseGame();
+  EXPECT_TRUE(snake.GetChanges().flags & CHANGED_STATE);
+  Snake::Snapshot snapshot;
+  snake.Clone(snapshot);
+  snake.ClearChanges();
+  snake.Restore(snapshot);
+  EXPECT_EQ(snake.GetChanges().flags, CHANGED_EVERYTHING);
+}
+
+TEST(SnakeModel, LargerBoards) {
+  BasicSnake<16, 40> tall(false, 7);
+  BasicSnakeController<16, 40> controller(tall);
+  EXPECT_EQ(tall.snake_coordinates_.front().x, 8);
+  EXPECT_EQ(tall.snake_coordinates_.front().y, 19);
+
+  controller.UserInput(Start, false);
+  int ticks = 0;
+  while (tall.GetPauseState() == STARTED && ticks < 100) {
+    controller.Tick();
+    ++ticks;
+  }
+  EXPECT_EQ(tall.GetPauseState(), LOSED);
+  EXPECT_EQ(ticks, 20);
+
+  BasicSnake<64, 64> square(false, 7);
+  for (int i = 0; i < 100; ++i) {
+    square.GenerateApple();
+    const int *apple = square.GetApple()[0];
+    EXPECT_TRUE((Board<64, 64>::Contains(apple[0], apple[1])));
+  }
+}
+
+TEST(SnakeModel, CloneRestore) {
+  Snake snake(false, 11);
+  SnakeController controller(snake);
+  controller.UserInput(Start, false);
+  controller.UserInput(Left, false);
+  controller.Tick();
+
+  Snake::Snapshot saved;
+  snake.Clone(saved);
+  std::vector<int> apples;
+  for (int i = 0; i < 3; ++i) {
+    snake.GenerateApple();
+    apples.push_back(snake.GetApple()[0][0] * FIELD_H +
+                     snake.GetApple()[0][1]);
+  }
+  controller.Tick();
+
+  Snake other(false, 99);
+  other.Restore(saved);
+  snake.Restore(saved);
+  for (Snake *copy : {&snake, &other}) {
+    EXPECT_EQ(copy->snake_coordinates_.size(), 4);
+    EXPECT_EQ(copy->snake_coordinates_.front().x, FIELD_W / 2 - 1);
+    EXPECT_EQ(copy->GetDirection(), Left);
+    EXPECT_EQ(copy->GetField()[FIELD_H / 2 - 1][FIELD_W / 2 - 1], 2);
+    for (int i = 0; i < 3; ++i) {
+      copy->GenerateApple();
+      EXPECT_EQ(copy->GetApple()[0][0] * FIELD_H + copy->GetApple()[0][1],
+                apples[i]);
+    }
+  }
+  EXPECT_NE(other.GetField(), snake.GetField());
+}
+
+TEST(SnakeMcts, PlaysTheSameGameTwice) {
+  SnakeMcts::Config config = SnakeMcts::DefaultConfig();
+  config.threads = 2;
+  config.time_limit_ms = 0;
+  config.iterations = 100;
+  std::vector<int> scores;
+  for (int run = 0; run < 2; ++run) {
+    Snake snake(false, 17);
+    SnakeController controller(snake);
+    SnakeMcts mcts(config);
+    controller.UserInput(Start, false);
+    for (int tick = 0; tick < 300 && snake.GetPauseState() == STARTED;
+         ++tick) {
+      controller.UserInput(mcts.Plan(snake), false);
+      controller.Tick();
+    }
+    EXPECT_EQ(snake.GetPauseState(), STARTED);
+    EXPECT_EQ(mcts.GetStats().iterations,
+              mcts.GetStats().decisions * 2 * 100);
+    scores.push_back(snake.GetScore());
+    scores.push_back(snake.snake_coordinates_.front().x * FIELD_H +
+                     snake.snake_coordinates_.front().y);
+  }
+  EXPECT_GT(scores[0], 5);
+  EXPECT_EQ(scores[0], scores[2]);
+  EXPECT_EQ(scores[1], scores[3]);
+}
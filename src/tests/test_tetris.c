@@ -1,21 +1,21 @@
 #include <check.h>
+#include <pthread.h>
+#include <string.h>
 
 #include "../inc/defines.h"
+#include "../inc/tetris/ai.h"
+#include "../inc/tetris/beam.h"
+#include "../inc/tetris/features.h"
 #include "../inc/tetris/fsm.h"
-
-static int figures[FIGURES_COUNT][MAX_FIGURE_SIZE][MAX_FIGURE_SIZE] = {
-    {{0, 0, 0, 0}, {0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {1, 1, 1, 1}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {1, 1, 0, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {0, 1, 1, 0}, {1, 1, 0, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {1, 1, 1, 0}, {1, 0, 0, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {1, 1, 1, 0}, {0, 0, 1, 0}, {0, 0, 0, 0}},
-    {{0, 0, 0, 0}, {1, 1, 1, 0}, {0, 1, 0, 0}, {0, 0, 0, 0}}};
+#include "../inc/replay.h"
+#include "../inc/tetris/headless.h"
+#include "../inc/tetris/mcts.h"
+#include "../inc/tetris/movegen.h"
 
 START_TEST(test_1) {
-  Game_Info *game_info = get_game_info();
-  for (int y = 0; y < FIELD_H; y++) {
-    for (int x = 0; x < FIELD_W; x++) {
+  GameInfo *game_info = get_game_info();
+  for (int y = 0; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
       ck_assert_int_eq(game_info->field[y][x], 0);
     }
   }
@@ -27,41 +27,43 @@ START_TEST(test_1) {
   ck_assert_int_eq(game_info->pause, 1);
   pause_game(game_info);
 
-  for (int y = 16; y < FIELD_H; y++) {
-    for (int x = 0; x < FIELD_W; x++) {
+  for (int y = 16; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
       game_info->field[y][x] = 1;
     }
   }
 
-  game_info->field[16][FIELD_W - 1] = 0;
+  game_info->field[16][TETRIS_W - 1] = 0;
+  sync_board_with_field(game_info);
 
   clear_line(game_info);
   line_dropper(game_info);
 
-  int result_field[FIELD_H][FIELD_W];
+  int result_field[TETRIS_H][TETRIS_W];
 
-  for (int y = 0; y < FIELD_H; y++) {
-    for (int x = 0; x < FIELD_W; x++) {
+  for (int y = 0; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
       result_field[y][x] = 0;
     }
   }
 
-  for (int j = 0; j < FIELD_W - 1; j++) {
-    result_field[FIELD_H - 1][j] = 1;
+  for (int j = 0; j < TETRIS_W - 1; j++) {
+    result_field[TETRIS_H - 1][j] = 1;
   }
 
-  for (int y = 0; y < FIELD_H; y++) {
-    for (int x = 0; x < FIELD_W; x++) {
+  for (int y = 0; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
       ck_assert_int_eq(result_field[y][x], game_info->field[y][x]);
     }
   }
 
-  Tetromino *tetromino = set_tetromino(game_info);
+  Tetromino piece = set_tetromino(game_info);
+  Tetromino *tetromino = &piece;
   tetromino->is_placed = TRUE;
   place_tetromino_on_field(tetromino, game_info);
   for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
     for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-      if (tetromino->figure[y][x]) {
+      if (tetromino_cell(tetromino, x, y)) {
         int y_block = tetromino->coord.y + y;
         int x_block = tetromino->coord.x + x;
         result_field[y_block][x_block] = 1;
@@ -69,24 +71,24 @@ START_TEST(test_1) {
     }
   }
 
-  for (int y = 0; y < FIELD_H; y++) {
-    for (int x = 0; x < FIELD_W; x++) {
+  for (int y = 0; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
       ck_assert_int_eq(game_info->field[y][x], result_field[y][x]);
     }
   }
   free_game(game_info);
-  free_tetromino(tetromino);
 }
 END_TEST
 
 START_TEST(test_2) {
-  Game_Info *game_info = get_game_info();
-  for (int y = 0; y < FIELD_H; y++) {
-    for (int x = 0; x < FIELD_W; x++) {
+  GameInfo *game_info = get_game_info();
+  for (int y = 0; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
       game_info->field[y][x] = 0;
     }
   }
-  Tetromino *tetromino = set_tetromino(game_info);
+  Tetromino piece = set_tetromino(game_info);
+  Tetromino *tetromino = &piece;
 
   get_signal(tetromino, game_info, Start);
   ck_assert_int_eq(tetromino->can_spawn, 1);
@@ -104,14 +106,15 @@ START_TEST(test_2) {
   get_signal(tetromino, game_info, Down);
   ck_assert_int_eq(tetromino->coord.y, START_POS_FIGURE_Y + 1);
 
-  tetromino->coord.x = FIELD_W / 2;
-  tetromino->coord.y = FIELD_H / 2;
+  tetromino->coord.x = TETRIS_W / 2;
+  tetromino->coord.y = TETRIS_H / 2;
 
   int result_figure[MAX_FIGURE_SIZE][MAX_FIGURE_SIZE];
 
   for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
     for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-      result_figure[y][x] = tetromino->figure[MAX_FIGURE_SIZE - x - 1][y];
+      result_figure[y][x] =
+          tetromino_cell(tetromino, y, MAX_FIGURE_SIZE - x - 1);
     }
   }
 
@@ -119,17 +122,16 @@ START_TEST(test_2) {
 
   for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
     for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
-      ck_assert_int_eq(tetromino->figure[y][x], result_figure[y][x]);
+      ck_assert_int_eq(tetromino_cell(tetromino, x, y), result_figure[y][x]);
     }
   }
 
   free_game(game_info);
-  free_tetromino(tetromino);
 }
 END_TEST
 
 START_TEST(test_3) {
-  Game_Info *game_info = get_game_info();
+  GameInfo *game_info = get_game_info();
   score_update(game_info, 1);
   ck_assert_int_eq(game_info->score, 100);
   score_update(game_info, 2);
@@ -145,7 +147,7 @@ START_TEST(test_3) {
 END_TEST
 
 START_TEST(test_4) {
-  Game_Info *game_info = get_game_info();
+  GameInfo *game_info = get_game_info();
   game_info->high_score = 1000;
   save_high_score(game_info);
 
@@ -164,16 +166,948 @@ START_TEST(test_4) {
 END_TEST
 
 START_TEST(test_5) {
-  Game_Info *game_info = get_game_info();
-  Tetromino *tetromino = set_tetromino(game_info);
+  GameInfo *game_info = get_game_info();
+  Tetromino piece = set_tetromino(game_info);
+  Tetromino *tetromino = &piece;
   spawn_new_figure(tetromino, game_info, figures);
   ck_assert_int_eq(tetromino->can_spawn, 1);
 
-  free_tetromino(tetromino);
   free_game(game_info);
 }
 END_TEST
 
+// Packs a 4x4 int figure into row masks, bit x is box column x
+static void mask_from_figure(PieceMask *mask, int **figure) {
+  for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
+    BoardRow row = 0;
+    for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
+      if (figure[y][x]) row |= (BoardRow)1 << x;
+    }
+    mask->rows[y] = row;
+  }
+}
+
+// Rotates a packed figure clockwise inside its box, as the int tables do:
+// rotated[y][x] = figure[3 - x][y]
+static void mask_rotate(PieceMask *rotated, const PieceMask *mask) {
+  for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
+    BoardRow row = 0;
+    for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
+      BoardRow source = mask->rows[MAX_FIGURE_SIZE - x - 1];
+      row |= (BoardRow)(((source >> y) & 1u) << x);
+    }
+    rotated->rows[y] = row;
+  }
+}
+
+START_TEST(test_6) {
+  Bitboard board;
+  bitboard_clear(&board);
+
+  int rows[MAX_FIGURE_SIZE][MAX_FIGURE_SIZE] = {
+      {0, 0, 0, 0}, {1, 1, 1, 1}, {0, 0, 0, 0}, {0, 0, 0, 0}};
+  int *figure[MAX_FIGURE_SIZE] = {rows[0], rows[1], rows[2], rows[3]};
+  PieceMask mask;
+  mask_from_figure(&mask, figure);
+  ck_assert_int_eq(mask.rows[1], 0xF);
+
+  ck_assert(!bitboard_collides(&board, &mask, 0, 0));
+  ck_assert(!bitboard_collides(&board, &mask, TETRIS_W - 4, TETRIS_H - 2));
+  ck_assert(bitboard_collides(&board, &mask, -1, 0));
+  ck_assert(bitboard_collides(&board, &mask, TETRIS_W - 3, 0));
+  ck_assert(bitboard_collides(&board, &mask, 0, TETRIS_H - 1));
+
+  for (int x = 0; x < TETRIS_W; x += MAX_FIGURE_SIZE) {
+    if (x + MAX_FIGURE_SIZE <= TETRIS_W) {
+      bitboard_place(&board, &mask, x, TETRIS_H - 2);
+    }
+  }
+  ck_assert(!bitboard_row_is_full(&board, TETRIS_H - 1));
+  ck_assert(bitboard_collides(&board, &mask, 2, TETRIS_H - 2));
+
+  PieceMask rotated;
+  mask_rotate(&rotated, &mask);
+  for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
+    ck_assert_int_eq(rotated.rows[y], 1u << 2);
+  }
+  ck_assert(!bitboard_collides(&board, &rotated, TETRIS_W - 3, TETRIS_H - 4));
+  bitboard_place(&board, &rotated, TETRIS_W - 3, TETRIS_H - 4);
+  bitboard_place(&board, &rotated, TETRIS_W - 4, TETRIS_H - 4);
+  ck_assert(bitboard_row_is_full(&board, TETRIS_H - 1));
+}
+END_TEST
+
+START_TEST(test_7) {
+  GameInfo *game_info = get_game_info();
+  Tetromino piece = set_tetromino(game_info);
+  Tetromino *tetromino = &piece;
+  get_signal(tetromino, game_info, Start);
+
+  for (int step = 0; step < 2000 && game_info->pause == STARTED; step++) {
+    get_signal(tetromino, game_info, step % 3 ? Left : Right);
+    if (step % 7 == 0) get_signal(tetromino, game_info, Action);
+    move_tetromino_down_one_row(tetromino, game_info);
+    if (tetromino->is_placed) game_update(tetromino, game_info);
+
+    for (int y = 0; y < TETRIS_H; y++) {
+      for (int x = 0; x < TETRIS_W; x++) {
+        ck_assert_int_eq(game_info->field[y][x],
+                         (game_info->tetris->board.rows[y] >> x) & 1u);
+      }
+    }
+  }
+
+  free_game(game_info);
+}
+END_TEST
+
+START_TEST(test_8) {
+  for (int type = 0; type < FIGURES_COUNT; type++) {
+    int cells[MAX_FIGURE_SIZE][MAX_FIGURE_SIZE];
+    int *figure[MAX_FIGURE_SIZE] = {cells[0], cells[1], cells[2], cells[3]};
+    stat_matrix_to_dyn(figure, figures[type]);
+
+    PieceMask mask;
+    mask_from_figure(&mask, figure);
+    for (int rotation = 0; rotation < ROTATIONS_COUNT; rotation++) {
+      const ShapeOrientation *shape = &shape_table[type][rotation];
+      int left = MAX_FIGURE_SIZE, right = -1;
+      int top = MAX_FIGURE_SIZE, bottom = -1;
+      int column_bottom[MAX_FIGURE_SIZE] = {-1, -1, -1, -1};
+      for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
+        ck_assert_int_eq(shape->mask.rows[y], mask.rows[y]);
+        for (int x = MAX_FIGURE_SIZE - 1; x >= 0; x--) {
+          if ((mask.rows[y] >> x) & 1u) {
+            if (x < left) left = x;
+            if (x > right) right = x;
+            if (y < top) top = y;
+            if (y > bottom) bottom = y;
+            column_bottom[x] = y;
+          }
+        }
+      }
+      for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
+        ck_assert_int_eq(shape->column_bottom[x], column_bottom[x]);
+      }
+      ck_assert_int_eq(shape->left, left);
+      ck_assert_int_eq(shape->right, right);
+      ck_assert_int_eq(shape->top, top);
+      ck_assert_int_eq(shape->bottom, bottom);
+
+      PieceMask rotated;
+      mask_rotate(&rotated, &mask);
+      mask = rotated;
+    }
+  }
+
+  GameInfo *game_info = get_game_info();
+  Tetromino piece = set_tetromino(game_info);
+  Tetromino *tetromino = &piece;
+  get_signal(tetromino, game_info, Start);
+  tetromino->coord.x = TETRIS_W / 2;
+  tetromino->coord.y = TETRIS_H / 2;
+  for (int turn = 0; turn < ROTATIONS_COUNT; turn++) {
+    get_signal(tetromino, game_info, Action);
+    ck_assert_int_eq(tetromino->rotation, (turn + 1) % ROTATIONS_COUNT);
+  }
+  for (int y = 0; y < MAX_FIGURE_SIZE; y++) {
+    for (int x = 0; x < MAX_FIGURE_SIZE; x++) {
+      ck_assert_int_eq(tetromino_cell(tetromino, x, y),
+                       figures[tetromino->type][y][x]);
+    }
+  }
+  free_game(game_info);
+}
+END_TEST
+
+START_TEST(test_9) {
+  TetrisSession *session = tetris_session_create();
+  ck_assert_int_eq(tetris_session_info(session)->pause, NOT_STARTED);
+  ck_assert_int_eq(tetris_session_info(session)->high_score, 0);
+
+  TetrisStepResult result = tetris_session_step(session, NULL, 0, 10);
+  ck_assert_int_eq(result.ticks, 0);
+
+  UserAction start = Start;
+  result = tetris_session_step(session, &start, 1, 3);
+  ck_assert_int_eq(result.state, STARTED);
+  ck_assert_int_eq(result.ticks, 3);
+  ck_assert_int_eq(tetris_session_tetromino(session)->coord.y,
+                   START_POS_FIGURE_Y + 3);
+
+  UserAction moves[] = {Left, Left, Action, Down};
+  int pieces = 0;
+  while (result.state == STARTED) {
+    result = tetris_session_step(session, moves, 4, 100);
+    pieces += result.pieces;
+  }
+  ck_assert_int_eq(result.state, LOSED);
+  ck_assert_int_gt(pieces, 0);
+  ck_assert_int_eq(tetris_session_info(session)->score, result.score);
+
+  tetris_session_destroy(session);
+}
+END_TEST
+
+START_TEST(test_10) {
+  GameInfo *first = create_game_info(FALSE);
+  GameInfo *second = create_game_info(FALSE);
+  tetris_seed(first, 42, TRUE);
+  tetris_seed(second, 42, TRUE);
+
+  for (int bag = 0; bag < 3; bag++) {
+    int seen[FIGURES_COUNT] = {0};
+    for (int i = 0; i < FIGURES_COUNT; i++) {
+      int type = generate_figure(first);
+      ck_assert_int_eq(type, generate_figure(second));
+      ck_assert_int_ge(type, 0);
+      ck_assert_int_lt(type, FIGURES_COUNT);
+      seen[type]++;
+    }
+    for (int type = 0; type < FIGURES_COUNT; type++) {
+      ck_assert_int_eq(seen[type], 1);
+    }
+  }
+  free_game(first);
+  free_game(second);
+
+  UserAction start = Start;
+  UserAction moves[] = {Right, Action, Right, Down};
+  TetrisSession *a = tetris_session_create_seeded(7, FALSE);
+  TetrisSession *b = tetris_session_create_seeded(7, FALSE);
+  TetrisStepResult result_a = tetris_session_step(a, &start, 1, 0);
+  TetrisStepResult result_b = tetris_session_step(b, &start, 1, 0);
+  while (result_a.state == STARTED) {
+    result_a = tetris_session_step(a, moves, 4, 30);
+    result_b = tetris_session_step(b, moves, 4, 30);
+    ck_assert_int_eq(result_a.pieces, result_b.pieces);
+    ck_assert_int_eq(tetris_session_tetromino(a)->next_type,
+                     tetris_session_tetromino(b)->next_type);
+  }
+  ck_assert_int_eq(result_b.state, LOSED);
+  ck_assert_int_eq(result_a.score, result_b.score);
+  for (int y = 0; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
+      ck_assert_int_eq(tetris_session_info(a)->field[y][x],
+                       tetris_session_info(b)->field[y][x]);
+    }
+  }
+  tetris_session_destroy(a);
+  tetris_session_destroy(b);
+}
+END_TEST
+
+START_TEST(test_11) {
+  Replay replay;
+  replay_init(&replay, REPLAY_TETRIS, 99, REPLAY_FLAG_BAG);
+  uint32_t ticks[] = {0, 0, 5, 300, 70000};
+  UserAction actions[] = {Start, Left, Action, Down, Terminate};
+  for (int i = 0; i < 5; i++) replay_record(&replay, ticks[i], actions[i]);
+  ck_assert(!replay_record(&replay, 70001, (UserAction)333));
+  ck_assert_int_eq(replay.events, 5);
+  ck_assert_int_lt(replay.size, 12);
+
+  int **field = calloc(TETRIS_H, sizeof(int *));
+  for (int y = 0; y < TETRIS_H; y++) field[y] = calloc(TETRIS_W, sizeof(int));
+  uint64_t empty_hash = field_hash(field, TETRIS_H, TETRIS_W);
+  field[TETRIS_H - 1][3] = 1;
+  ck_assert(field_hash(field, TETRIS_H, TETRIS_W) != empty_hash);
+  replay_finish(&replay, 70010, 1500, field_hash(field, TETRIS_H, TETRIS_W));
+
+  const char *path = "test_replay.bgr";
+  ck_assert(replay_save(&replay, path));
+  Replay loaded;
+  ck_assert(replay_load(&loaded, path));
+  FILE *file = fopen(path, "r+b");
+  fseek(file, 36, SEEK_SET);
+  fputc(replay.size + 1, file);
+  fclose(file);
+  Replay damaged;
+  ck_assert(!replay_load(&damaged, path));
+  ck_assert_ptr_null(damaged.data);
+  remove(path);
+  ck_assert_int_eq(loaded.game, REPLAY_TETRIS);
+  ck_assert_int_eq(loaded.flags, REPLAY_FLAG_BAG);
+  ck_assert(loaded.seed == 99);
+  ck_assert_int_eq(loaded.ticks, 70010);
+  ck_assert_int_eq(loaded.score, 1500);
+  ck_assert(loaded.board_hash == replay.board_hash);
+
+  ReplayCursor cursor;
+  replay_cursor_init(&cursor, &loaded);
+  uint32_t tick = 0;
+  UserAction action = Start;
+  for (int i = 0; i < 5; i++) {
+    ck_assert(replay_cursor_next(&cursor, &tick, &action));
+    ck_assert_int_eq(tick, ticks[i]);
+    ck_assert_int_eq(action, actions[i]);
+  }
+  ck_assert(!replay_cursor_next(&cursor, &tick, &action));
+
+  for (int y = 0; y < TETRIS_H; y++) free(field[y]);
+  free(field);
+  replay_free(&replay);
+  replay_free(&loaded);
+}
+END_TEST
+
+START_TEST(test_12) {
+  GameInfo *game_info = create_game_info(FALSE);
+  tetris_seed(game_info, 2024, FALSE);
+  Tetromino piece = set_tetromino(game_info);
+  Tetromino *tetromino = &piece;
+  get_signal(tetromino, game_info, Start);
+
+  UserAction moves[] = {Left, Right, Action};
+  for (int piece = 0; piece < 200 && game_info->pause == STARTED; piece++) {
+    for (int i = 0; i < piece % 7; i++) {
+      get_signal(tetromino, game_info, moves[(piece + i) % 3]);
+    }
+    int landing = tetromino->coord.y;
+    while (!shape_collides(&game_info->tetris->board,
+                           get_tetromino_shape(tetromino), tetromino->coord.x,
+                           landing + 1)) {
+      landing++;
+    }
+    ck_assert_int_eq(tetromino_landing_row(tetromino, game_info), landing);
+
+    get_signal(tetromino, game_info, Up);
+    ck_assert_int_eq(tetromino->coord.y, landing);
+    ck_assert(tetromino->is_placed);
+    game_update(tetromino, game_info);
+
+    int8_t heights[TETRIS_W];
+    bitboard_column_heights(&game_info->tetris->board, heights);
+    for (int x = 0; x < TETRIS_W; x++) {
+      ck_assert_int_eq(game_info->tetris->heights[x], heights[x]);
+    }
+  }
+  ck_assert_int_eq(game_info->pause, LOSED);
+
+  for (int y = 0; y < TETRIS_H; y++) {
+    memset(game_info->field[y], 0, TETRIS_W * sizeof(int));
+  }
+  game_info->field[10][3] = 1;
+  sync_board_with_field(game_info);
+  ck_assert_int_eq(game_info->tetris->heights[3], TETRIS_H - 10);
+  const ShapeOrientation *square = &shape_table[0][0];
+  ck_assert_int_eq(shape_landing_row(game_info->tetris, square, 2, 11),
+                   TETRIS_H - 3);
+  ck_assert_int_eq(shape_landing_row(game_info->tetris, square, 2, 0), 7);
+
+  free_game(game_info);
+}
+END_TEST
+
+START_TEST(test_13) {
+  GameInfo *game_info = create_game_info(FALSE);
+  int *rows[TETRIS_H];
+  for (int y = 0; y < TETRIS_H; y++) rows[y] = game_info->field[y];
+  for (int x = 0; x < TETRIS_W; x++) {
+    game_info->field[TETRIS_H - 1][x] = 1;
+    game_info->field[TETRIS_H - 3][x] = 1;
+  }
+  game_info->field[TETRIS_H - 2][0] = 1;
+  game_info->field[TETRIS_H - 4][5] = 1;
+  game_info->field[TETRIS_H - 5][5] = 1;
+  sync_board_with_field(game_info);
+
+  game_info->tetris->placed_top = TETRIS_H - 3;
+  game_info->tetris->placed_bottom = TETRIS_H - 1;
+  ck_assert_int_eq(clear_placed_lines(game_info), 2);
+  ck_assert_int_eq(game_info->tetris->placed_top, -1);
+  ck_assert_int_eq(clear_placed_lines(game_info), 0);
+
+  ck_assert_int_eq(game_info->field[TETRIS_H - 1][0], 1);
+  ck_assert_int_eq(game_info->field[TETRIS_H - 2][5], 1);
+  ck_assert_int_eq(game_info->field[TETRIS_H - 3][5], 1);
+  ck_assert_int_eq(game_info->tetris->heights[0], 1);
+  ck_assert_int_eq(game_info->tetris->heights[5], 3);
+  ck_assert_int_eq(game_info->tetris->heights[9], 0);
+
+  int cells = 0;
+  int8_t heights[TETRIS_W];
+  bitboard_column_heights(&game_info->tetris->board, heights);
+  for (int y = 0; y < TETRIS_H; y++) {
+    int found = 0;
+    for (int k = 0; k < TETRIS_H; k++) found += game_info->field[y] == rows[k];
+    ck_assert_int_eq(found, 1);
+    for (int x = 0; x < TETRIS_W; x++) {
+      cells += game_info->field[y][x];
+      ck_assert_int_eq((game_info->tetris->board.rows[y] >> x) & 1,
+                       game_info->field[y][x]);
+    }
+  }
+  ck_assert_int_eq(cells, 3);
+  for (int x = 0; x < TETRIS_W; x++) {
+    ck_assert_int_eq(game_info->tetris->heights[x], heights[x]);
+  }
+
+  for (int x = 0; x < TETRIS_W; x++) game_info->field[TETRIS_H - 2][x] = 1;
+  game_info->field[TETRIS_H - 4][2] = 1;
+  sync_board_with_field(game_info);
+  ck_assert_int_eq(clear_line(game_info), 1);
+  ck_assert_int_eq(game_info->field[TETRIS_H - 3][2], 1);
+  ck_assert_int_eq(game_info->tetris->heights[2], 3);
+  ck_assert_int_eq(game_info->tetris->heights[5], 2);
+
+  free_game(game_info);
+}
+END_TEST
+
+START_TEST(test_14) {
+  GameInfo *game_info = create_game_info(FALSE);
+  for (int y = TETRIS_H - 4; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W - 1; x++) game_info->field[y][x] = 1;
+  }
+  sync_board_with_field(game_info);
+  Tetromino piece = set_tetromino(game_info);
+  Tetromino *tetromino = &piece;
+  tetromino->type = 1;
+  tetromino->next_type = 0;
+  get_signal(tetromino, game_info, Start);
+
+  TetrisAi ai;
+  tetris_ai_init(&ai);
+  int count = tetris_ai_plan(&ai, tetromino, game_info);
+  ck_assert_int_eq(ai.moves[count - 1], Up);
+  ck_assert(ai.evaluated > 0);
+  for (int i = 0; i < count; i++) get_signal(tetromino, game_info, ai.moves[i]);
+  game_update(tetromino, game_info);
+  ck_assert_int_eq(game_info->tetris->lines_cleared, 4);
+  free_game(game_info);
+
+  TetrisSession *session = tetris_session_create_seeded(99, FALSE);
+  UserAction start = Start;
+  TetrisStepResult step = tetris_session_step(session, &start, 1, 0);
+  int lines = 0;
+  for (int piece = 0; piece < 300; piece++) {
+    count = tetris_ai_plan(&ai, tetris_session_tetromino(session),
+                           tetris_session_info(session));
+    step = tetris_session_step(session, ai.moves, count, 0);
+    ck_assert_int_eq(step.pieces, 1);
+    lines += step.lines;
+  }
+  ck_assert_int_eq(step.state, STARTED);
+  ck_assert(lines >= 100);
+  tetris_session_destroy(session);
+}
+END_TEST
+
+START_TEST(test_15) {
+  GameInfo *game_info = create_game_info(FALSE);
+  for (int x = 3; x < TETRIS_W; x++) game_info->field[TETRIS_H - 3][x] = 1;
+  game_info->field[TETRIS_H - 1][0] = 1;
+  sync_board_with_field(game_info);
+  Tetromino piece = set_tetromino(game_info);
+  Tetromino *tetromino = &piece;
+  get_signal(tetromino, game_info, Start);
+
+  static TetrisMoves moves;
+  UserAction path[MOVEGEN_MAX_STATES];
+  for (int type = 0; type < FIGURES_COUNT; type++) {
+    tetris_generate_moves(&moves, &game_info->tetris->board, type, 0,
+                          START_POS_FIGURE_X, START_POS_FIGURE_Y);
+    bool tucked = false;
+    for (int i = 0; i < moves.resting_count; i++) {
+      const MoveState *state = &moves.states[moves.resting[i]];
+      tetromino->type = type;
+      tetromino->rotation = 0;
+      set_start_position_for_tetromino(tetromino);
+      int length = tetris_move_path(&moves, moves.resting[i], path,
+                                    MOVEGEN_MAX_STATES);
+      for (int k = 0; k < length; k++) {
+        get_signal(tetromino, game_info, path[k]);
+      }
+      ck_assert_int_eq(tetromino->coord.x, state->x);
+      ck_assert_int_eq(tetromino->coord.y, state->y);
+      ck_assert_int_eq(tetromino->rotation, state->rotation);
+      ck_assert(shape_collides(&game_info->tetris->board,
+                               get_tetromino_shape(tetromino), state->x,
+                               state->y + 1));
+      const ShapeOrientation *shape = get_tetromino_shape(tetromino);
+      tucked = tucked || (state->y + shape->bottom == TETRIS_H - 1 &&
+                          state->x + shape->right >= 3);
+    }
+    ck_assert(tucked);
+  }
+
+  Bitboard empty;
+  bitboard_clear(&empty);
+  uint8_t pieces[] = {6, 1, 0};
+  ck_assert_int_eq(tetris_perft(&empty, pieces, 0), 1);
+  ck_assert_int_eq(tetris_perft(&empty, pieces, 1), 34);
+  ck_assert_int_eq(tetris_perft(&empty, pieces, 2), 1192);
+
+  free_game(game_info);
+}
+END_TEST
+
+START_TEST(test_16) {
+  TetrisSession *session = tetris_session_create_seeded(7, TRUE);
+  const GameInfo *info = tetris_session_info(session);
+  ck_assert(tetris_board_hash(info) == 0);
+  TetrisAi ai;
+  tetris_ai_init(&ai);
+  ai.lookahead = false;
+  UserAction start = Start;
+  tetris_session_step(session, &start, 1, 0);
+  int lines = 0;
+  for (int piece = 0; piece < 200; piece++) {
+    int count = tetris_ai_plan(&ai, tetris_session_tetromino(session), info);
+    lines += tetris_session_step(session, ai.moves, count, 0).lines;
+    ck_assert(tetris_board_hash(info) ==
+              zobrist_board(&info->tetris->board));
+  }
+  ck_assert(lines > 0);
+  tetris_session_destroy(session);
+
+  GameInfo *game_info = create_game_info(FALSE);
+  for (int x = 0; x < TETRIS_W; x++) game_info->field[TETRIS_H - 2][x] = 1;
+  game_info->field[TETRIS_H - 4][1] = 1;
+  game_info->field[TETRIS_H - 1][4] = 1;
+  sync_board_with_field(game_info);
+  ck_assert(tetris_board_hash(game_info) ==
+            (zobrist_row(TETRIS_H - 2, BOARD_FULL_ROW) ^
+             zobrist_keys[TETRIS_H - 4][1] ^ zobrist_keys[TETRIS_H - 1][4]));
+  ck_assert_int_eq(clear_line(game_info), 1);
+  ck_assert(tetris_board_hash(game_info) ==
+            (zobrist_keys[TETRIS_H - 3][1] ^ zobrist_keys[TETRIS_H - 1][4]));
+  line_dropper(game_info);
+  ck_assert(tetris_board_hash(game_info) ==
+            (zobrist_keys[TETRIS_H - 2][1] ^ zobrist_keys[TETRIS_H - 1][4]));
+  free_game(game_info);
+}
+END_TEST
+
+static void *ttable_worker(void *arg) {
+  TTable *table = arg;
+  for (uint64_t i = 1; i <= 20000; i++) {
+    uint64_t key = ttable_key(i * 0x9E3779B97F4A7C15ull, TTABLE_PREVIEW, 0,
+                              (int)(i % 7), 0);
+    TTableEntry entry = {(float)(i % 1000), 0, 0, 0};
+    ttable_store(table, key, &entry);
+    TTableEntry found;
+    if (ttable_probe(table, key, &found)) {
+      ck_assert(found.score == (float)(i % 1000));
+    }
+  }
+  return NULL;
+}
+
+START_TEST(test_17) {
+  TTable *table = ttable_create(1);
+  TTableEntry entry = {-2.5f, 3, -2, 17}, found;
+  uint64_t key = ttable_key(12345, TTABLE_PLAN, 4, 6, 0);
+  ck_assert(key != ttable_key(12345, TTABLE_PLAN, 4, 5, 0));
+  ck_assert(key != ttable_key(12345, TTABLE_PREVIEW, 4, 6, 0));
+  ck_assert(key != ttable_key(12345, TTABLE_PLAN, 4, 6, 1));
+  ck_assert(!ttable_probe(table, key, &found));
+  ttable_store(table, key, &entry);
+  ck_assert(ttable_probe(table, key, &found));
+  ck_assert(found.score == -2.5f);
+  ck_assert_int_eq(found.rotation, 3);
+  ck_assert_int_eq(found.x, -2);
+  ck_assert_int_eq(found.y, 17);
+
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++) {
+    pthread_create(&threads[i], NULL, ttable_worker, table);
+  }
+  for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+
+  TetrisSession *plain = tetris_session_create_seeded(11, FALSE);
+  TetrisSession *cached = tetris_session_create_seeded(11, FALSE);
+  TetrisAi ai_plain, ai_cached;
+  tetris_ai_init(&ai_plain);
+  tetris_ai_init(&ai_cached);
+  ai_cached.table = table;
+  UserAction start = Start;
+  tetris_session_step(plain, &start, 1, 0);
+  tetris_session_step(cached, &start, 1, 0);
+  for (int piece = 0; piece < 100; piece++) {
+    int count = tetris_ai_plan(&ai_plain, tetris_session_tetromino(plain),
+                               tetris_session_info(plain));
+    ck_assert_int_eq(tetris_ai_plan(&ai_cached,
+                                    tetris_session_tetromino(cached),
+                                    tetris_session_info(cached)),
+                     count);
+    ck_assert(!memcmp(ai_plain.moves, ai_cached.moves,
+                      count * sizeof(UserAction)));
+    ck_assert_int_eq(tetris_ai_plan(&ai_cached,
+                                    tetris_session_tetromino(cached),
+                                    tetris_session_info(cached)),
+                     count);
+    tetris_session_step(plain, ai_plain.moves, count, 0);
+    tetris_session_step(cached, ai_cached.moves, count, 0);
+  }
+  ck_assert(tetris_board_hash(tetris_session_info(plain)) ==
+            tetris_board_hash(tetris_session_info(cached)));
+  ck_assert(ai_cached.table_hits >= 100);
+  ck_assert(ai_cached.table_misses > 0);
+  ck_assert_int_eq(ai_plain.table_hits + ai_plain.table_misses, 0);
+
+  tetris_session_destroy(plain);
+  tetris_session_destroy(cached);
+  ttable_destroy(table);
+}
+END_TEST
+
+static void assert_same_features(const BoardFeatures *a,
+                                 const BoardFeatures *b) {
+  for (int x = 0; x < TETRIS_W; x++) {
+    ck_assert_int_eq(a->heights[x], b->heights[x]);
+  }
+  ck_assert_int_eq(a->aggregate_height, b->aggregate_height);
+  ck_assert_int_eq(a->bumpiness, b->bumpiness);
+  ck_assert_int_eq(a->holes, b->holes);
+  ck_assert_int_eq(a->row_transitions, b->row_transitions);
+  ck_assert_int_eq(a->column_transitions, b->column_transitions);
+  ck_assert_int_eq(a->wells, b->wells);
+}
+
+START_TEST(test_18) {
+  int cells[TETRIS_H][TETRIS_W] = {0};
+  int *field[TETRIS_H];
+  for (int y = 0; y < TETRIS_H; y++) field[y] = cells[y];
+  cells[TETRIS_H - 1][0] = cells[TETRIS_H - 1][2] = 1;
+  cells[TETRIS_H - 2][2] = 1;
+
+  Bitboard board;
+  BoardFeatures expected, found;
+  bitboard_load_field(&board, field);
+  board_features_reference(field, &expected);
+  ck_assert_int_eq(expected.heights[0], 1);
+  ck_assert_int_eq(expected.heights[2], 2);
+  ck_assert_int_eq(expected.aggregate_height, 3);
+  ck_assert_int_eq(expected.bumpiness, 5);
+  ck_assert_int_eq(expected.holes, 0);
+  ck_assert_int_eq(expected.wells, 1);
+  ck_assert_int_eq(expected.row_transitions, 44);
+  ck_assert_int_eq(expected.column_transitions, 10);
+  board_features_scalar(&board, &found);
+  assert_same_features(&expected, &found);
+
+  BoardBatch batch;
+  BoardFeatures batched[BOARD_BATCH_SIZE], references[BOARD_BATCH_SIZE];
+  uint32_t seed = 7;
+  for (int round = 0; round < 64; round++) {
+    for (int i = 0; i < BOARD_BATCH_SIZE; i++) {
+      int top = (round + i) % (TETRIS_H + 1);
+      for (int y = 0; y < TETRIS_H; y++) {
+        for (int x = 0; x < TETRIS_W; x++) {
+          seed = seed * 1103515245u + 12345u;
+          cells[y][x] = y >= top && (seed >> 16) % 8 < (unsigned)(i % 8);
+        }
+      }
+      bitboard_load_field(&board, field);
+      board_features_reference(field, &references[i]);
+      board_features_scalar(&board, &found);
+      assert_same_features(&references[i], &found);
+      board_features_avx2(&board, &found);
+      assert_same_features(&references[i], &found);
+      board_features(&board, &found);
+      assert_same_features(&references[i], &found);
+      board_batch_set(&batch, i, &board);
+    }
+    int count = BOARD_BATCH_SIZE - round % 4;
+    board_features_batch_scalar(&batch, count, batched);
+    for (int i = 0; i < count; i++) {
+      assert_same_features(&references[i], &batched[i]);
+    }
+    board_features_batch_avx2(&batch, count, batched);
+    for (int i = 0; i < count; i++) {
+      assert_same_features(&references[i], &batched[i]);
+    }
+  }
+}
+END_TEST
+
+START_TEST(test_19) {
+  TetrisBeamConfig serial_config = {3, 8, 1, 0}, parallel_config = {3, 8, 3, 0};
+  TetrisBeam *serial = tetris_beam_create(&serial_config);
+  TetrisBeam *parallel = tetris_beam_create(&parallel_config);
+  TetrisSession *first = tetris_session_create_seeded(23, FALSE);
+  TetrisSession *second = tetris_session_create_seeded(23, FALSE);
+  TetrisAi ai_serial, ai_parallel;
+  tetris_ai_init(&ai_serial);
+  tetris_ai_init(&ai_parallel);
+  UserAction start = Start;
+  tetris_session_step(first, &start, 1, 0);
+  tetris_session_step(second, &start, 1, 0);
+  int lines = 0;
+  for (int piece = 0; piece < 60; piece++) {
+    int count = tetris_beam_plan(serial, &ai_serial,
+                                 tetris_session_tetromino(first),
+                                 tetris_session_info(first));
+    ck_assert_int_eq(tetris_beam_plan(parallel, &ai_parallel,
+                                      tetris_session_tetromino(second),
+                                      tetris_session_info(second)),
+                     count);
+    ck_assert(!memcmp(ai_serial.moves, ai_parallel.moves,
+                      count * sizeof(UserAction)));
+    TetrisStepResult step =
+        tetris_session_step(first, ai_serial.moves, count, 0);
+    tetris_session_step(second, ai_parallel.moves, count, 0);
+    ck_assert_int_eq(step.state, STARTED);
+    lines += step.lines;
+  }
+  ck_assert_int_gt(lines, 15);
+  ck_assert(ai_serial.evaluated == ai_parallel.evaluated);
+
+  TetrisBeamStats stats;
+  tetris_beam_stats(parallel, &stats);
+  ck_assert_int_eq(stats.plans, 60);
+  ck_assert_int_eq(stats.levels, 3 * 60);
+  ck_assert_int_eq(stats.timeouts, 0);
+
+  TetrisBeamConfig hurried_config = {3, 8, 2, 1e-6};
+  TetrisBeam *hurried = tetris_beam_create(&hurried_config);
+  int count = tetris_beam_plan(hurried, &ai_serial,
+                               tetris_session_tetromino(first),
+                               tetris_session_info(first));
+  ck_assert_int_gt(count, 0);
+  ck_assert(ai_serial.moves[count - 1] == Up);
+  tetris_beam_stats(hurried, &stats);
+  ck_assert_int_eq(stats.plans, 1);
+  ck_assert_int_eq(stats.levels, 0);
+  ck_assert_int_eq(stats.timeouts, 1);
+
+  tetris_beam_destroy(hurried);
+  tetris_beam_destroy(serial);
+  tetris_beam_destroy(parallel);
+  tetris_session_destroy(first);
+  tetris_session_destroy(second);
+}
+END_TEST
+
+START_TEST(test_20) {
+  TetrisArena *arena = tetris_arena_create(2);
+  TetrisSession *fresh = tetris_session_create_seeded(31, TRUE);
+  TetrisSession *reused = tetris_arena_session(arena, 5, FALSE);
+  TetrisSession *second = tetris_arena_session(arena, 6, FALSE);
+  ck_assert_ptr_nonnull(second);
+  ck_assert_int_eq(
+      (uintptr_t)tetris_session_info(second) % TETRIS_BLOCK_ALIGN, 0);
+  ck_assert_ptr_null(tetris_arena_session(arena, 7, FALSE));
+  UserAction moves[] = {Start, Left, Action, Right, Right, Down};
+  tetris_session_step(reused, moves, 6, 40);
+
+  tetris_arena_reset(arena);
+  ck_assert_ptr_eq(tetris_arena_session(arena, 31, TRUE), reused);
+  const GameInfo *info = tetris_session_info(reused);
+  ck_assert_int_eq((uintptr_t)info % TETRIS_BLOCK_ALIGN, 0);
+  ck_assert_ptr_eq(info->field[TETRIS_H - 1], info->field[0] +
+                                                 (TETRIS_H - 1) * TETRIS_W);
+  for (int game = 0; game < 2; game++) {
+    for (int i = 0; i < 50; i++) {
+      TetrisStepResult a = tetris_session_step(fresh, moves, 6, 3);
+      TetrisStepResult b = tetris_session_step(reused, moves, 6, 3);
+      ck_assert(!memcmp(&a, &b, sizeof(a)));
+    }
+    ck_assert(tetris_board_hash(tetris_session_info(fresh)) ==
+              tetris_board_hash(info));
+    tetris_session_reset(fresh, 9, FALSE);
+    tetris_session_reset(reused, 9, FALSE);
+    ck_assert_int_eq(info->score, 0);
+  }
+
+  tetris_session_destroy(fresh);
+  tetris_arena_destroy(arena);
+}
+END_TEST
+
+START_TEST(test_21) {
+  TetrisSession *session = tetris_session_create_seeded(41, FALSE);
+  TetrisSession *other = tetris_session_create_seeded(42, TRUE);
+  UserAction moves[] = {Start, Left, Left, Action, Down};
+  tetris_session_step(session, moves, 5, 30);
+
+  TetrisSnapshot saved;
+  tetris_session_clone(session, &saved);
+  TetrisStepResult ahead = tetris_session_step(session, moves + 1, 4, 200);
+  uint64_t hash = tetris_board_hash(tetris_session_info(session));
+
+  tetris_session_restore(session, &saved);
+  tetris_session_restore(other, &saved);
+  const GameInfo *info = tetris_session_info(other);
+  ck_assert_ptr_ne(info->field, tetris_session_info(session)->field);
+  ck_assert_ptr_ne(info->tetris, tetris_session_info(session)->tetris);
+  for (int i = 0; i < 2; i++) {
+    TetrisSession *copy = i ? other : session;
+    TetrisStepResult step = tetris_session_step(copy, moves + 1, 4, 200);
+    ck_assert(!memcmp(&step, &ahead, sizeof(step)));
+    ck_assert(tetris_board_hash(tetris_session_info(copy)) == hash);
+  }
+
+  GameInfo *game_info = create_game_info(FALSE);
+  Tetromino tetromino = set_tetromino(game_info);
+  tetris_snapshot_restore(game_info, &tetromino, &saved);
+  ck_assert_int_eq(tetromino.type, saved.tetromino.type);
+  ck_assert_int_eq(game_info->field[TETRIS_H - 1][0],
+                   saved.game.field[TETRIS_H - 1][0]);
+  ck_assert_ptr_eq(game_info->field[1], game_info->field[0] + TETRIS_W);
+  free_game(game_info);
+
+  tetris_session_destroy(session);
+  tetris_session_destroy(other);
+}
+END_TEST
+
+START_TEST(test_22) {
+  TetrisMctsConfig config;
+  tetris_mcts_default_config(&config);
+  config.threads = 2;
+  config.time_limit_ms = 0;
+  config.iterations = 40;
+  config.seed = 5;
+  TetrisMcts *first_mcts = tetris_mcts_create(&config);
+  TetrisMcts *second_mcts = tetris_mcts_create(&config);
+  TetrisSession *first = tetris_session_create_seeded(29, FALSE);
+  TetrisSession *second = tetris_session_create_seeded(29, FALSE);
+  TetrisAi ai_first, ai_second;
+  tetris_ai_init(&ai_first);
+  tetris_ai_init(&ai_second);
+  UserAction start = Start;
+  tetris_session_step(first, &start, 1, 0);
+  tetris_session_step(second, &start, 1, 0);
+  for (int piece = 0; piece < 30; piece++) {
+    int count = tetris_mcts_plan(first_mcts, &ai_first,
+                                 tetris_session_tetromino(first),
+                                 tetris_session_info(first));
+    ck_assert_int_gt(count, 0);
+    ck_assert_int_eq(tetris_mcts_plan(second_mcts, &ai_second,
+                                      tetris_session_tetromino(second),
+                                      tetris_session_info(second)),
+                     count);
+    ck_assert(!memcmp(ai_first.moves, ai_second.moves,
+                      count * sizeof(UserAction)));
+    TetrisStepResult step =
+        tetris_session_step(first, ai_first.moves, count, 0);
+    tetris_session_step(second, ai_second.moves, count, 0);
+    ck_assert_int_eq(step.state, STARTED);
+    ck_assert_int_eq(step.pieces, 1);
+  }
+  ck_assert(tetris_board_hash(tetris_session_info(first)) ==
+            tetris_board_hash(tetris_session_info(second)));
+
+  TetrisMctsStats stats;
+  tetris_mcts_stats(first_mcts, &stats);
+  ck_assert_int_eq(stats.decisions, 30);
+  ck_assert_int_eq(stats.iterations, 30 * 2 * 40);
+  ck_assert_int_gt(stats.placements, stats.iterations);
+
+  tetris_mcts_destroy(first_mcts);
+  tetris_mcts_destroy(second_mcts);
+  tetris_session_destroy(first);
+  tetris_session_destroy(second);
+}
+END_TEST
+
+START_TEST(test_23) {
+  GameInfo *game_info = create_game_info(FALSE);
+  ChangeJournal *changes = &game_info->tetris->changes;
+  ck_assert_int_eq(changes->flags, CHANGED_EVERYTHING);
+  Tetromino tetromino = set_tetromino(game_info);
+  start_game(&tetromino, game_info);
+  ck_assert(changes->flags & CHANGED_STATE);
+  journal_clear(changes);
+  ck_assert(journal_is_empty(changes));
+
+  move_tetromino_left(&tetromino, game_info);
+  ck_assert_int_eq(changes->count, 8);
+  ck_assert_int_eq(changes->flags, 0);
+  for (int i = 0; i < changes->count; i++) {
+    int x = (changes->cells[i] & 0xff) - tetromino.coord.x;
+    int y = (changes->cells[i] >> 8) - tetromino.coord.y;
+    // The first four cells are the ones the tetromino left, a column right
+    if (i < 4) x--;
+    ck_assert(x >= 0 && x < MAX_FIGURE_SIZE);
+    ck_assert(tetromino_cell(&tetromino, x, y));
+  }
+
+  journal_clear(changes);
+  hard_drop_tetromino(&tetromino, game_info);
+  game_update(&tetromino, game_info);
+  // Left and landed by the drop, locked, then entered by the next piece
+  ck_assert_int_eq(changes->count, 16);
+  ck_assert_int_eq(changes->flags, CHANGED_NEXT);
+  for (int i = 8; i < 12; i++) {
+    ck_assert_int_eq(game_info->field[changes->cells[i] >> 8]
+                                     [changes->cells[i] & 0xff],
+                     1);
+  }
+
+  for (int x = 0; x < TETRIS_W; x++) game_info->field[TETRIS_H - 1][x] = 1;
+  sync_board_with_field(game_info);
+  ck_assert(changes->flags & CHANGED_CELLS_ALL);
+  journal_clear(changes);
+  ck_assert_int_eq(clear_line(game_info), 1);
+  score_update(game_info, 1);
+  ck_assert(changes->rows & (1u << (TETRIS_H - 1)));
+  ck_assert(!(changes->rows & 1u));
+  ck_assert_int_eq(changes->flags, CHANGED_SCORE);
+
+  journal_clear(changes);
+  for (int i = 0; i < 10; i++) {
+    move_tetromino_right(&tetromino, game_info);
+    move_tetromino_left(&tetromino, game_info);
+  }
+  ck_assert_int_eq(changes->count, CHANGE_JOURNAL_CELLS);
+  ck_assert(changes->flags & CHANGED_CELLS_ALL);
+  free_game(game_info);
+}
+END_TEST
+
+static void assert_field_matches_board(const GameInfo *game_info) {
+  for (int y = 0; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
+      ck_assert_int_eq(game_info->field[y][x] != 0,
+                       (game_info->tetris->board.rows[y] >> x) & 1u);
+    }
+  }
+}
+
+START_TEST(test_24) {
+  TetrisSession *session = tetris_session_create_seeded(3, FALSE);
+  TetrisSession *other = tetris_session_create_seeded(4, FALSE);
+  UserAction start = Start;
+  tetris_session_step(session, &start, 1, 0);
+  GameInfo *game_info = (GameInfo *)tetris_session_info(session);
+  // Full odd rows between rows that differ, so the clear moves the rows
+  for (int y = TETRIS_H - 6; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
+      game_info->field[y][x] = y % 2 || x % (y - TETRIS_H + 8) == 0;
+    }
+  }
+  sync_board_with_field(game_info);
+  ck_assert_int_eq(clear_line(game_info), 3);
+  assert_field_matches_board(game_info);
+
+  TetrisSnapshot saved;
+  tetris_session_clone(session, &saved);
+  tetris_session_restore(other, &saved);
+  assert_field_matches_board(tetris_session_info(other));
+  ck_assert(tetris_board_hash(tetris_session_info(other)) ==
+            tetris_board_hash(game_info));
+
+  for (int x = 0; x < TETRIS_W; x++) game_info->field[TETRIS_H - 1][x] = 1;
+  sync_board_with_field(game_info);
+  ck_assert_int_eq(clear_line(game_info), 1);
+  tetris_session_restore(session, &saved);
+  assert_field_matches_board(game_info);
+  for (int y = 0; y < TETRIS_H; y++) {
+    for (int x = 0; x < TETRIS_W; x++) {
+      ck_assert_int_eq(game_info->field[y][x],
+                       tetris_session_info(other)->field[y][x]);
+    }
+  }
+
+  tetris_session_destroy(session);
+  tetris_session_destroy(other);
+}
+END_TEST
+
 Suite *test_backend_core() {
   Suite *s = suite_create("\033[33mstest_backend\033[0m");
   TCase *tc_core = tcase_create("backed_test");
@@ -183,6 +1117,25 @@ Suite *test_backend_core() {
   tcase_add_test(tc_core, test_3);
   tcase_add_test(tc_core, test_4);
   tcase_add_test(tc_core, test_5);
+  tcase_add_test(tc_core, test_6);
+  tcase_add_test(tc_core, test_7);
+  tcase_add_test(tc_core, test_8);
+  tcase_add_test(tc_core, test_9);
+  tcase_add_test(tc_core, test_10);
+  tcase_add_test(tc_core, test_11);
+  tcase_add_test(tc_core, test_12);
+  tcase_add_test(tc_core, test_13);
+  tcase_add_test(tc_core, test_14);
+  tcase_add_test(tc_core, test_15);
+  tcase_add_test(tc_core, test_16);
+  tcase_add_test(tc_core, test_17);
+  tcase_add_test(tc_core, test_18);
+  tcase_add_test(tc_core, test_19);
+  tcase_add_test(tc_core, test_20);
+  tcase_add_test(tc_core, test_21);
+  tcase_add_test(tc_core, test_22);
+  tcase_add_test(tc_core, test_23);
+  tcase_add_test(tc_core, test_24);
 
   suite_add_tcase(s, tc_core);
   return s;
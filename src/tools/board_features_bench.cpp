@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../inc/tetris/features.h"
+
+/** @file */
+
+namespace {
+
+/**
+ * @brief Command line settings of a benchmark run.
+ */
+struct BenchOptions {
+  int boards = 4096;
+  int rounds = 200;
+  std::uint32_t seed = 1;
+};
+
+/**
+ * @brief A board both as the int field the game keeps and packed.
+ */
+struct TestBoard {
+  int cells[TETRIS_H][TETRIS_W];
+  int *field[TETRIS_H];
+  Bitboard board;
+};
+
+double SecondsSince(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       begin)
+      .count();
+}
+
+/**
+ * @brief Fills boards the way a game leaves them: a stack of random height
+ * that gets denser towards the floor.
+ */
+void FillBoards(std::vector<TestBoard> &boards, std::uint32_t seed) {
+  for (TestBoard &test : boards) {
+    seed = seed * 1103515245u + 12345u;
+    int top = TETRIS_H - static_cast<int>((seed >> 16) % (TETRIS_H - 4));
+    for (int y = 0; y < TETRIS_H; y++) {
+      test.field[y] = test.cells[y];
+      for (int x = 0; x < TETRIS_W; x++) {
+        seed = seed * 1103515245u + 12345u;
+        int density = 4 + 4 * (y - top) / TETRIS_H;
+        test.cells[y][x] = y >= top && static_cast<int>((seed >> 16) % 8) <
+                                           density;
+      }
+    }
+    bitboard_load_field(&test.board, test.field);
+  }
+}
+
+bool SameFeatures(const BoardFeatures &a, const BoardFeatures &b) {
+  return !std::memcmp(a.heights, b.heights, sizeof(a.heights)) &&
+         a.aggregate_height == b.aggregate_height &&
+         a.bumpiness == b.bumpiness && a.holes == b.holes &&
+         a.row_transitions == b.row_transitions &&
+         a.column_transitions == b.column_transitions && a.wells == b.wells;
+}
+
+/**
+ * @brief Times one kernel over all boards and compares its results with
+ * the expected ones.
+ *
+ * @return true if every board matched
+ */
+template <typename Kernel>
+bool Measure(const char *name, const BenchOptions &options,
+             const std::vector<BoardFeatures> &expected, double baseline,
+             double *seconds, Kernel kernel) {
+  std::vector<BoardFeatures> found(expected.size());
+  auto begin = std::chrono::steady_clock::now();
+  for (int round = 0; round < options.rounds; round++) kernel(found);
+  *seconds = SecondsSince(begin);
+
+  int mismatches = 0;
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    mismatches += !SameFeatures(expected[i], found[i]);
+  }
+  double boards = static_cast<double>(expected.size()) * options.rounds;
+  std::printf("%-14s %10.3f %14.0f %8.2fx%s\n", name, *seconds,
+              boards / *seconds, baseline > 0 ? baseline / *seconds : 1.0,
+              mismatches ? "  MISMATCH" : "");
+  return mismatches == 0;
+}
+
+void PrintUsage(const char *program) {
+  std::printf(
+      "Usage: %s [options]\n"
+      "  --boards N  random boards to measure (4096)\n"
+      "  --rounds N  passes over the boards per kernel (200)\n"
+      "  --seed N    seed of the boards (1)\n",
+      program);
+}
+
+bool ParseOptions(int argc, char **argv, BenchOptions *options) {
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!std::strcmp(arg, "--help") || value == nullptr) return false;
+    ++i;
+    if (!std::strcmp(arg, "--boards")) {
+      options->boards = std::atoi(value);
+    } else if (!std::strcmp(arg, "--rounds")) {
+      options->rounds = std::atoi(value);
+    } else if (!std::strcmp(arg, "--seed")) {
+      options->seed =
+          static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", arg);
+      return false;
+    }
+  }
+  return options->boards > 0 && options->rounds > 0;
+}
+
+}  // namespace
+
+/**
+ * @brief Measures the autoplayer's board features with the cell by cell
+ * reference, the word kernel and the AVX2 kernels, one board at a time and
+ * in batches, and checks that all of them agree.
+ *
+ * @return 0 if every kernel matched the reference, 1 otherwise
+ */
+int main(int argc, char **argv) {
+  BenchOptions options;
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  std::vector<TestBoard> boards(options.boards);
+  FillBoards(boards, options.seed);
+  std::vector<BoardFeatures> expected(boards.size());
+  std::vector<BoardBatch> batches((boards.size() + BOARD_BATCH_SIZE - 1) /
+                                  BOARD_BATCH_SIZE);
+  for (std::size_t i = 0; i < boards.size(); i++) {
+    board_features_reference(boards[i].field, &expected[i]);
+    board_batch_set(&batches[i / BOARD_BATCH_SIZE],
+                    static_cast<int>(i % BOARD_BATCH_SIZE), &boards[i].board);
+  }
+  auto batched = [&](std::vector<BoardFeatures> &out, auto kernel) {
+    for (std::size_t b = 0; b < batches.size(); b++) {
+      std::size_t first = b * BOARD_BATCH_SIZE;
+      int count = static_cast<int>(
+          std::min<std::size_t>(BOARD_BATCH_SIZE, boards.size() - first));
+      kernel(&batches[b], count, &out[first]);
+    }
+  };
+
+  bool avx2 = board_features_avx2_supported();
+  std::printf("%-14s %10s %14s %9s\n", "kernel", "seconds", "boards/s",
+              "speedup");
+  double reference = 0, seconds = 0;
+  bool ok = Measure("reference", options, expected, 0, &reference,
+                    [&](std::vector<BoardFeatures> &out) {
+                      for (std::size_t i = 0; i < boards.size(); i++) {
+                        board_features_reference(boards[i].field, &out[i]);
+                      }
+                    });
+  ok = Measure("scalar", options, expected, reference, &seconds,
+               [&](std::vector<BoardFeatures> &out) {
+                 for (std::size_t i = 0; i < boards.size(); i++) {
+                   board_features_scalar(&boards[i].board, &out[i]);
+                 }
+               }) &&
+       ok;
+  ok = Measure("scalar batch", options, expected, reference, &seconds,
+               [&](std::vector<BoardFeatures> &out) {
+                 batched(out, board_features_batch_scalar);
+               }) &&
+       ok;
+  if (avx2) {
+    ok = Measure("avx2", options, expected, reference, &seconds,
+                 [&](std::vector<BoardFeatures> &out) {
+                   for (std::size_t i = 0; i < boards.size(); i++) {
+                     board_features_avx2(&boards[i].board, &out[i]);
+                   }
+                 }) &&
+         ok;
+    ok = Measure("avx2 batch", options, expected, reference, &seconds,
+                 [&](std::vector<BoardFeatures> &out) {
+                   batched(out, board_features_batch_avx2);
+                 }) &&
+         ok;
+  } else {
+    std::printf("avx2 kernels skipped, this CPU or board does not run them\n");
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../inc/replay.h"
+#include "../inc/snake/snake.h"
+#include "../inc/snake/snake_controller.h"
+#include "../inc/tetris/headless.h"
+
+/** @file */
+
+namespace {
+
+/**
+ * @brief State reached by playing a replay back.
+ */
+struct Outcome {
+  int score = 0;
+  std::uint64_t board_hash = 0;
+  long ticks = 0;  // Ticks actually run, for throughput
+};
+
+/**
+ * @brief Replays a Tetris recording through the headless session.
+ *
+ * The console loop handles an input before the gravity step of its frame,
+ * so every input is applied once the recorded number of ticks has run.
+ */
+Outcome PlayTetris(const Replay &replay) {
+  TetrisSession *session = tetris_session_create_seeded(
+      replay.seed, (replay.flags & REPLAY_FLAG_BAG) != 0);
+  ReplayCursor cursor;
+  replay_cursor_init(&cursor, &replay);
+
+  Outcome outcome;
+  std::uint32_t done = 0, tick = 0;
+  UserAction action = Start;
+  while (replay_cursor_next(&cursor, &tick, &action)) {
+    if (tick > done) {
+      outcome.ticks +=
+          tetris_session_step(session, nullptr, 0, tick - done).ticks;
+      done = tick;
+    }
+    tetris_session_step(session, &action, 1, 0);
+  }
+  if (replay.ticks > done) {
+    outcome.ticks +=
+        tetris_session_step(session, nullptr, 0, replay.ticks - done).ticks;
+  }
+
+  const GameInfo *info = tetris_session_info(session);
+  outcome.score = info->score;
+  outcome.board_hash = field_hash(info->field, TETRIS_H, TETRIS_W);
+  tetris_session_destroy(session);
+  return outcome;
+}
+
+/**
+ * @brief Runs snake ticks while the game is started, as SnakeView does.
+ */
+void RunSnakeTicks(s21::SnakeController &controller, std::uint32_t ticks,
+                   Outcome *outcome) {
+  for (std::uint32_t i = 0;
+       i < ticks && controller.snake_.GetPauseState() == STARTED; ++i) {
+    controller.Tick();
+    ++outcome->ticks;
+  }
+}
+
+/**
+ * @brief Replays a Snake recording through SnakeController.
+ */
+Outcome PlaySnake(const Replay &replay) {
+  s21::Snake snake(false, replay.seed);
+  s21::SnakeController controller(snake);
+  ReplayCursor cursor;
+  replay_cursor_init(&cursor, &replay);
+
+  Outcome outcome;
+  std::uint32_t done = 0, tick = 0;
+  UserAction action = Start;
+  while (replay_cursor_next(&cursor, &tick, &action)) {
+    if (tick > done) {
+      RunSnakeTicks(controller, tick - done, &outcome);
+      done = tick;
+    }
+    controller.UserInput(action, action == Action);
+  }
+  if (replay.ticks > done) {
+    RunSnakeTicks(controller, replay.ticks - done, &outcome);
+  }
+
+  GameInfo info = snake.GetGameInfo();
+  outcome.score = info.score;
+  outcome.board_hash = field_hash(info.field, FIELD_H, FIELD_W);
+  return outcome;
+}
+
+/**
+ * @brief Plays one file repeat times and prints whether it matches.
+ *
+ * @return false if the file cannot be read or the outcome differs
+ */
+bool CheckReplay(const char *path, int repeat) {
+  Replay replay;
+  if (!replay_load(&replay, path)) {
+    std::fprintf(stderr, "%s: not a replay file\n", path);
+    return false;
+  }
+
+  bool tetris = replay.game == REPLAY_TETRIS;
+  Outcome outcome;
+  long ticks = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; ++i) {
+    outcome = tetris ? PlayTetris(replay) : PlaySnake(replay);
+    ticks += outcome.ticks;
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+
+  bool score_ok = outcome.score == replay.score;
+  bool hash_ok = outcome.board_hash == replay.board_hash;
+  std::printf("%s: %s, %" PRIu32 " inputs, %" PRIu32 " ticks, score %d %s, "
+              "board %016" PRIx64 " %s\n",
+              path, tetris ? "tetris" : "snake", replay.events, replay.ticks,
+              outcome.score, score_ok ? "ok" : "MISMATCH", outcome.board_hash,
+              hash_ok ? "ok" : "MISMATCH");
+  if (!score_ok) std::printf("  expected score %d\n", replay.score);
+  if (!hash_ok) {
+    std::printf("  expected board %016" PRIx64 "\n", replay.board_hash);
+  }
+  std::printf("  %d playbacks in %.3f s, %.1f playbacks/sec, %.0f ticks/sec\n",
+              repeat, seconds, repeat / seconds, ticks / seconds);
+
+  replay_free(&replay);
+  return score_ok && hash_ok;
+}
+
+}  // namespace
+
+/**
+ * @brief Plays recorded sessions back headlessly at full speed and checks
+ * that every one ends with the recorded score and board.
+ *
+ * Usage: brickgame-replay [--repeat N] FILE...
+ *
+ * @return 0 if every replay matches, 1 otherwise
+ */
+int main(int argc, char **argv) {
+  int repeat = 1;
+  std::vector<const char *> paths;
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--repeat") && i + 1 < argc) {
+      repeat = std::max(1, std::atoi(argv[++i]));
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (paths.empty()) {
+    std::printf("Usage: %s [--repeat N] FILE...\n", argv[0]);
+    return 1;
+  }
+
+  bool all_ok = true;
+  for (const char *path : paths) all_ok = CheckReplay(path, repeat) && all_ok;
+  return all_ok ? 0 : 1;
+}
@@ -0,0 +1,634 @@
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../inc/sim/parse_number.h"
+#include "../inc/sim/work_stealing.h"
+#include "../inc/snake/snake.h"
+#include "../inc/snake/snake_controller.h"
+#include "../inc/snake/snake_mcts.h"
+#include "../inc/tetris/ai.h"
+#include "../inc/tetris/beam.h"
+#include "../inc/tetris/headless.h"
+#include "../inc/tetris/mcts.h"
+
+/** @file */
+
+namespace {
+
+enum class GameKind { kTetris, kSnake };
+enum class PolicyKind { kRandom, kScripted, kAi, kBeam, kMcts };
+// Boards Snake is compiled for in snake.cpp, Tetris plays the one its
+// engine is built for, see TETRIS_BOARD in the Makefile
+enum class BoardKind { kStandard, k16x40, k64x64 };
+constexpr int kBoardSizes[][2] = {{FIELD_W, FIELD_H}, {16, 40}, {64, 64}};
+
+/**
+ * @brief Tree search settings shared by both games.
+ *
+ * Games already run on every core, so a search grows one tree for a fixed
+ * number of iterations by default and batches stay reproducible.
+ */
+struct MctsOptions {
+  int threads = 1;
+  double time_limit_ms = 0;
+  int iterations = 200;
+  int rollout = -1;  // Pieces or ticks, -1 for the default of the game
+  bool greedy = true;
+};
+
+/**
+ * @brief Command line settings of a batch run.
+ */
+struct SimOptions {
+  GameKind game = GameKind::kTetris;
+  BoardKind board = BoardKind::kStandard;
+  PolicyKind policy = PolicyKind::kRandom;
+  std::string script = "LLA.RRD..";
+  std::size_t games = 1000;
+  unsigned threads = std::thread::hardware_concurrency();
+  std::uint64_t seed = 1;
+  bool use_bag = false;
+  long max_ticks = 100000;
+  std::size_t table_mb = 0;
+  TetrisBeamConfig beam = {TETRIS_BEAM_MAX_DEPTH, 32, 1, 0};
+  MctsOptions mcts;
+};
+
+/**
+ * @brief Final state of one simulated game.
+ */
+struct GameResult {
+  int score;
+  int level;
+  long ticks;
+  int size;        // Lines cleared for Tetris, snake length for Snake
+  long evaluated;  // Placements the autoplayer scored
+  long table_hits;
+  long table_misses;
+  TetrisBeamStats beam;
+  TetrisMctsStats mcts;  // placements counts Snake ticks
+};
+
+/**
+ * @brief Everything one worker accumulates, kept on its own cache lines.
+ */
+struct WorkerStats {
+  long games = 0;
+  long ticks = 0;
+  long evaluated = 0;
+  long table_hits = 0;
+  long table_misses = 0;
+  TetrisBeamStats beam = {};
+  TetrisMctsStats mcts = {};
+  std::vector<GameResult> results;
+};
+
+/**
+ * @brief Spreads consecutive game indices over the seed space.
+ */
+std::uint64_t MixSeed(std::uint64_t value) {
+  value += 0x9E3779B97F4A7C15ull;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+/**
+ * @brief Picks the input of every tick, at random or from a looped script.
+ *
+ * Script characters are L, R, U, D for the arrows, A for Action and '.' for
+ * a tick without input. Every game starts the script at a seed dependent
+ * offset, so scripted games still differ from each other.
+ */
+class Policy {
+ public:
+  Policy(const SimOptions &options, std::uint64_t seed)
+      : kind_(options.policy), script_(options.script), random_(seed) {
+    if (!script_.empty()) position_ = seed % script_.size();
+  }
+
+  /**
+   * @return false if this tick has no input
+   */
+  bool Next(GameKind game, UserAction *action) {
+    bool has_action = false;
+    if (kind_ == PolicyKind::kScripted) {
+      has_action = FromScript(action);
+    } else if (game == GameKind::kTetris) {
+      static const UserAction kTetrisMoves[] = {Left, Right, Action, Down};
+      std::uint64_t roll = random_() % 10;
+      has_action = roll < 4;
+      if (has_action) *action = kTetrisMoves[roll];
+    } else {
+      static const UserAction kSnakeMoves[] = {Up, Down, Left, Right};
+      std::uint64_t roll = random_() % 8;
+      has_action = roll < 4;
+      if (has_action) *action = kSnakeMoves[roll];
+    }
+    return has_action;
+  }
+
+ private:
+  bool FromScript(UserAction *action) {
+    if (script_.empty()) return false;
+    char symbol = script_[position_];
+    position_ = (position_ + 1) % script_.size();
+    switch (symbol) {
+      case 'L':
+        *action = Left;
+        break;
+      case 'R':
+        *action = Right;
+        break;
+      case 'U':
+        *action = Up;
+        break;
+      case 'D':
+        *action = Down;
+        break;
+      case 'A':
+        *action = Action;
+        break;
+      default:
+        return false;
+    }
+    return true;
+  }
+
+  PolicyKind kind_;
+  std::string script_;
+  std::mt19937_64 random_;
+  std::size_t position_ = 0;
+};
+
+/**
+ * @brief Plays one Tetris game through the headless step API.
+ *
+ * The seed drives both the pieces and the policy, so a game can be played
+ * again from its seed alone. The autoplayer places a whole piece per step,
+ * followed by one gravity tick, and shares the table with other games. The
+ * beam and mcts policies give every game its own search and threads. The
+ * session comes from the worker's arena, so games after the first do not
+ * allocate it.
+ */
+GameResult PlayTetris(const SimOptions &options, std::uint64_t seed,
+                      TTable *table, TetrisArena *arena) {
+  Policy policy(options, seed);
+  TetrisAi ai;
+  tetris_ai_init(&ai);
+  ai.table = table;
+  TetrisBeam *beam = options.policy == PolicyKind::kBeam
+                         ? tetris_beam_create(&options.beam)
+                         : nullptr;
+  TetrisMcts *mcts = nullptr;
+  if (options.policy == PolicyKind::kMcts) {
+    TetrisMctsConfig config;
+    tetris_mcts_default_config(&config);
+    config.threads = options.mcts.threads;
+    config.time_limit_ms = options.mcts.time_limit_ms;
+    config.iterations = options.mcts.iterations;
+    if (options.mcts.rollout >= 0) config.rollout_pieces = options.mcts.rollout;
+    config.greedy_rollouts = options.mcts.greedy;
+    config.seed = seed;
+    mcts = tetris_mcts_create(&config);
+  }
+  tetris_arena_reset(arena);
+  TetrisSession *session =
+      tetris_arena_session(arena, seed, options.use_bag);
+  GameResult result = {};
+  if (session == nullptr) {
+    std::fprintf(stderr, "no free session for the game of seed %" PRIu64 "\n",
+                 seed);
+    tetris_beam_destroy(beam);
+    tetris_mcts_destroy(mcts);
+    return result;
+  }
+
+  UserAction action = Start;
+  TetrisStepResult step = tetris_session_step(session, &action, 1, 0);
+  while (step.state == STARTED && result.ticks < options.max_ticks) {
+    if (beam) {
+      int count = tetris_beam_plan(beam, &ai, tetris_session_tetromino(session),
+                                   tetris_session_info(session));
+      step = tetris_session_step(session, ai.moves, count, 1);
+    } else if (mcts) {
+      int count = tetris_mcts_plan(mcts, &ai, tetris_session_tetromino(session),
+                                   tetris_session_info(session));
+      step = tetris_session_step(session, ai.moves, count, 1);
+    } else if (options.policy == PolicyKind::kAi) {
+      int count = tetris_ai_plan(&ai, tetris_session_tetromino(session),
+                                 tetris_session_info(session));
+      step = tetris_session_step(session, ai.moves, count, 1);
+    } else {
+      bool has_action = policy.Next(GameKind::kTetris, &action);
+      step = tetris_session_step(session, &action, has_action ? 1 : 0, 1);
+    }
+    result.ticks += step.ticks;
+    result.size += step.lines;
+  }
+  result.evaluated = ai.evaluated;
+  result.table_hits = ai.table_hits;
+  result.table_misses = ai.table_misses;
+  result.score = step.score;
+  result.level = step.level;
+  if (beam) tetris_beam_stats(beam, &result.beam);
+  if (mcts) tetris_mcts_stats(mcts, &result.mcts);
+
+  tetris_beam_destroy(beam);
+  tetris_mcts_destroy(mcts);
+  return result;
+}
+
+/**
+ * @brief Plays one Snake game on a W x H board through its controller, one
+ * move per tick, planned by a tree search with the mcts policy.
+ */
+template <int W, int H>
+GameResult PlaySnake(const SimOptions &options, std::uint64_t seed) {
+  Policy policy(options, seed);
+  s21::BasicSnake<W, H> snake(false, seed);
+  s21::BasicSnakeController<W, H> controller(snake);
+  std::unique_ptr<s21::BasicSnakeMcts<W, H>> mcts;
+  if (options.policy == PolicyKind::kMcts) {
+    auto config = s21::BasicSnakeMcts<W, H>::DefaultConfig();
+    config.threads = options.mcts.threads;
+    config.time_limit_ms = options.mcts.time_limit_ms;
+    config.iterations = options.mcts.iterations;
+    if (options.mcts.rollout >= 0) config.rollout_ticks = options.mcts.rollout;
+    config.greedy_rollouts = options.mcts.greedy;
+    config.seed = seed;
+    mcts = std::make_unique<s21::BasicSnakeMcts<W, H>>(config);
+  }
+
+  controller.UserInput(Start, false);
+  GameResult result = {};
+  UserAction action = Up;
+  while (snake.GetPauseState() == STARTED &&
+         result.ticks < options.max_ticks) {
+    if (mcts) {
+      controller.UserInput(mcts->Plan(snake), false);
+    } else if (policy.Next(GameKind::kSnake, &action)) {
+      controller.UserInput(action, false);
+    }
+    controller.Tick();
+    ++result.ticks;
+  }
+  result.score = snake.GetScore();
+  result.level = snake.GetLevel();
+  result.size = static_cast<int>(snake.snake_coordinates_.size());
+  if (mcts) {
+    const auto &stats = mcts->GetStats();
+    result.mcts = {stats.decisions, stats.iterations, stats.nodes,
+                   stats.ticks,     stats.total_ms,   stats.longest_ms};
+  }
+  return result;
+}
+
+GameResult PlaySnake(const SimOptions &options, std::uint64_t seed) {
+  switch (options.board) {
+    case BoardKind::k16x40:
+      return PlaySnake<16, 40>(options, seed);
+    case BoardKind::k64x64:
+      return PlaySnake<64, 64>(options, seed);
+    default:
+      return PlaySnake<FIELD_W, FIELD_H>(options, seed);
+  }
+}
+
+double Percentile(const std::vector<int> &sorted, double fraction) {
+  if (sorted.empty()) return 0;
+  std::size_t index =
+      static_cast<std::size_t>(fraction * (sorted.size() - 1));
+  return sorted[index];
+}
+
+void PrintDistribution(const char *name, std::vector<int> values) {
+  std::sort(values.begin(), values.end());
+  double sum = 0;
+  for (int value : values) sum += value;
+  std::printf("%-8s mean %10.1f  min %7d  p50 %7.0f  p90 %7.0f  p99 %7.0f"
+              "  max %7d\n",
+              name, values.empty() ? 0.0 : sum / values.size(),
+              values.empty() ? 0 : values.front(), Percentile(values, 0.5),
+              Percentile(values, 0.9), Percentile(values, 0.99),
+              values.empty() ? 0 : values.back());
+}
+
+void PrintHistogram(std::vector<int> values) {
+  if (values.empty()) return;
+  std::sort(values.begin(), values.end());
+  const int kBuckets = 10;
+  int low = values.front();
+  int width = std::max(1, (values.back() - low) / kBuckets + 1);
+  std::vector<std::size_t> counts(kBuckets, 0);
+  for (int value : values) {
+    ++counts[std::min(kBuckets - 1, (value - low) / width)];
+  }
+  std::size_t peak = *std::max_element(counts.begin(), counts.end());
+  for (int b = 0; b < kBuckets; ++b) {
+    int bar = static_cast<int>(40 * counts[b] / peak);
+    std::printf("  [%7d, %7d) %8zu %s\n", low + b * width,
+                low + (b + 1) * width, counts[b],
+                std::string(bar, '#').c_str());
+  }
+}
+
+void PrintUsage(const char *program) {
+  std::printf(
+      "Usage: %s [options]\n"
+      "  --game tetris|snake     engine to drive (tetris)\n"
+      "  --board 10x20|16x40|64x64  board (10x20), Tetris only plays the\n"
+      "                          board of its build\n"
+      "  --games N               number of games (1000)\n"
+      "  --threads N             worker threads (all cores)\n"
+      "  --policy random|script|ai|beam|mcts  input source (random), ai\n"
+      "                          and beam are Tetris only and place a\n"
+      "                          piece per tick, mcts plays both games\n"
+      "  --script STRING         looped inputs L R U D A . (LLA.RRD..)\n"
+      "  --seed N                base seed of the batch (1)\n"
+      "  --randomizer uniform|bag  Tetris piece sequence (uniform)\n"
+      "  --max-ticks N           stop a game after N ticks (100000)\n"
+      "  --table-mb N            autoplayer cache size, 0 for none (0)\n"
+      "  --beam-depth N          pieces the beam looks through, 1-3 (3)\n"
+      "  --beam-width N          positions kept per level (32)\n"
+      "  --beam-threads N        threads of every beam search (1)\n"
+      "  --beam-ms N             time limit of a plan, 0 for none (0)\n"
+      "  --mcts-threads N        trees of every tree search (1)\n"
+      "  --mcts-ms N             time limit of a decision, 0 for none (0)\n"
+      "  --mcts-iterations N     iterations per tree, 0 for none (200)\n"
+      "  --mcts-rollout N        rollout pieces or ticks (game default)\n"
+      "  --mcts-rollouts greedy|random  rollout moves (greedy)\n",
+      program);
+}
+
+// Accepted names of the enum options, in enum order
+constexpr const char *kGameNames[] = {"tetris", "snake"};
+constexpr const char *kBoardNames[] = {"10x20", "16x40", "64x64"};
+constexpr const char *kPolicyNames[] = {"random", "script", "ai", "beam",
+                                        "mcts"};
+constexpr const char *kRandomizerNames[] = {"uniform", "bag"};
+constexpr const char *kRolloutNames[] = {"greedy", "random"};
+
+// Index of value in names, -1 if it is none of them
+template <size_t N>
+int FindName(const char *value, const char *const (&names)[N]) {
+  int index = -1;
+  for (size_t i = 0; i < N && index < 0; ++i) {
+    if (!std::strcmp(value, names[i])) index = static_cast<int>(i);
+  }
+  return index;
+}
+
+bool ParseOptions(int argc, char **argv, SimOptions *options) {
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!std::strcmp(arg, "--help")) return false;
+    if (value == nullptr) {
+      std::fprintf(stderr, "missing value for %s\n", arg);
+      return false;
+    }
+    ++i;
+    bool valid = true;  // False for a value the option does not accept
+    long long number = 0;
+    if (!std::strcmp(arg, "--game")) {
+      int name = FindName(value, kGameNames);
+      valid = name >= 0;
+      options->game = static_cast<GameKind>(name);
+    } else if (!std::strcmp(arg, "--board")) {
+      int name = FindName(value, kBoardNames);
+      valid = name >= 0;
+      options->board = static_cast<BoardKind>(name);
+    } else if (!std::strcmp(arg, "--games")) {
+      valid = s21::ParseInteger(value, 1, LLONG_MAX, &number);
+      options->games = static_cast<std::size_t>(number);
+    } else if (!std::strcmp(arg, "--threads")) {
+      valid = s21::ParseInteger(value, 1, s21::kMaxOptionThreads, &number);
+      options->threads = static_cast<unsigned>(number);
+    } else if (!std::strcmp(arg, "--policy")) {
+      int name = FindName(value, kPolicyNames);
+      valid = name >= 0;
+      options->policy = static_cast<PolicyKind>(name);
+    } else if (!std::strcmp(arg, "--script")) {
+      options->script = value;
+    } else if (!std::strcmp(arg, "--seed")) {
+      valid = s21::ParseUnsigned(value, &options->seed);
+    } else if (!std::strcmp(arg, "--randomizer")) {
+      int name = FindName(value, kRandomizerNames);
+      valid = name >= 0;
+      options->use_bag = name == 1;
+    } else if (!std::strcmp(arg, "--max-ticks")) {
+      valid = s21::ParseInteger(value, 1, LONG_MAX, &number);
+      options->max_ticks = static_cast<long>(number);
+    } else if (!std::strcmp(arg, "--table-mb")) {
+      valid = s21::ParseInteger(value, 0, 1 << 20, &number);
+      options->table_mb = static_cast<std::size_t>(number);
+    } else if (!std::strcmp(arg, "--beam-depth")) {
+      valid = s21::ParseInteger(value, 1, TETRIS_BEAM_MAX_DEPTH, &number);
+      options->beam.depth = static_cast<int>(number);
+    } else if (!std::strcmp(arg, "--beam-width")) {
+      valid = s21::ParseInteger(value, 1, INT_MAX, &number);
+      options->beam.width = static_cast<int>(number);
+    } else if (!std::strcmp(arg, "--beam-threads")) {
+      valid = s21::ParseInteger(value, 1, s21::kMaxOptionThreads, &number);
+      options->beam.threads = static_cast<int>(number);
+    } else if (!std::strcmp(arg, "--beam-ms")) {
+      valid = s21::ParseReal(value, 0, 1e9, &options->beam.time_limit_ms);
+    } else if (!std::strcmp(arg, "--mcts-threads")) {
+      valid = s21::ParseInteger(value, 1, s21::kMaxOptionThreads, &number);
+      options->mcts.threads = static_cast<int>(number);
+    } else if (!std::strcmp(arg, "--mcts-ms")) {
+      valid = s21::ParseReal(value, 0, 1e9, &options->mcts.time_limit_ms);
+    } else if (!std::strcmp(arg, "--mcts-iterations")) {
+      valid = s21::ParseInteger(value, 0, INT_MAX, &number);
+      options->mcts.iterations = static_cast<int>(number);
+    } else if (!std::strcmp(arg, "--mcts-rollout")) {
+      valid = s21::ParseInteger(value, 1, INT_MAX, &number);
+      options->mcts.rollout = static_cast<int>(number);
+    } else if (!std::strcmp(arg, "--mcts-rollouts")) {
+      int name = FindName(value, kRolloutNames);
+      valid = name >= 0;
+      options->mcts.greedy = name == 0;
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", arg);
+      return false;
+    }
+    if (!valid) {
+      std::fprintf(stderr, "unknown value %s for %s\n", value, arg);
+      return false;
+    }
+  }
+  bool autoplayer = options->policy == PolicyKind::kAi ||
+                    options->policy == PolicyKind::kBeam;
+  if (autoplayer && options->game != GameKind::kTetris) {
+    std::fprintf(stderr, "the ai and beam policies only play tetris\n");
+    return false;
+  }
+  const int *size = kBoardSizes[static_cast<int>(options->board)];
+  if (options->game == GameKind::kTetris &&
+      (size[0] != TETRIS_W || size[1] != TETRIS_H)) {
+    std::fprintf(stderr,
+                 "this build plays tetris on %dx%d, build it with "
+                 "TETRIS_BOARD=%dx%d\n",
+                 TETRIS_W, TETRIS_H, size[0], size[1]);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+/**
+ * @brief Runs a batch of independent games on every core and prints the
+ * throughput and the score, level and length distributions.
+ */
+int main(int argc, char **argv) {
+  SimOptions options;
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  s21::WorkStealingScheduler scheduler(options.threads);
+  std::vector<s21::CacheAligned<WorkerStats>> stats(scheduler.Threads());
+
+  std::vector<TetrisArena *> arenas(scheduler.Threads());
+  bool allocated = true;
+  for (TetrisArena *&arena : arenas) {
+    arena = tetris_arena_create(1);
+    allocated = allocated && arena != nullptr;
+  }
+  if (!allocated) {
+    std::fprintf(stderr, "cannot allocate the game sessions\n");
+    for (TetrisArena *arena : arenas) tetris_arena_destroy(arena);
+    return 1;
+  }
+  TTable *table = options.policy == PolicyKind::kAi && options.table_mb
+                     ? ttable_create(options.table_mb)
+                     : nullptr;
+
+  auto begin = std::chrono::steady_clock::now();
+  scheduler.Run(options.games, [&](unsigned worker, std::size_t index) {
+    std::uint64_t seed = MixSeed(options.seed + index);
+    GameResult result =
+        options.game == GameKind::kTetris
+            ? PlayTetris(options, seed, table, arenas[worker])
+            : PlaySnake(options, seed);
+    WorkerStats &own = stats[worker].value;
+    ++own.games;
+    own.ticks += result.ticks;
+    own.evaluated += result.evaluated;
+    own.table_hits += result.table_hits;
+    own.table_misses += result.table_misses;
+    own.beam.plans += result.beam.plans;
+    own.beam.levels += result.beam.levels;
+    own.beam.timeouts += result.beam.timeouts;
+    own.beam.overruns += result.beam.overruns;
+    own.beam.nodes += result.beam.nodes;
+    own.beam.total_ms += result.beam.total_ms;
+    own.beam.longest_ms =
+        std::max(own.beam.longest_ms, result.beam.longest_ms);
+    own.mcts.decisions += result.mcts.decisions;
+    own.mcts.iterations += result.mcts.iterations;
+    own.mcts.nodes += result.mcts.nodes;
+    own.mcts.placements += result.mcts.placements;
+    own.mcts.total_ms += result.mcts.total_ms;
+    own.mcts.longest_ms =
+        std::max(own.mcts.longest_ms, result.mcts.longest_ms);
+    own.results.push_back(result);
+  });
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+
+  long games = 0, ticks = 0, evaluated = 0, hits = 0, misses = 0;
+  TetrisBeamStats beam = {};
+  TetrisMctsStats mcts = {};
+  std::vector<int> scores, levels, lengths, game_ticks;
+  for (const auto &worker : stats) {
+    beam.plans += worker.value.beam.plans;
+    beam.levels += worker.value.beam.levels;
+    beam.timeouts += worker.value.beam.timeouts;
+    beam.overruns += worker.value.beam.overruns;
+    beam.nodes += worker.value.beam.nodes;
+    beam.total_ms += worker.value.beam.total_ms;
+    beam.longest_ms = std::max(beam.longest_ms, worker.value.beam.longest_ms);
+    mcts.decisions += worker.value.mcts.decisions;
+    mcts.iterations += worker.value.mcts.iterations;
+    mcts.nodes += worker.value.mcts.nodes;
+    mcts.placements += worker.value.mcts.placements;
+    mcts.total_ms += worker.value.mcts.total_ms;
+    mcts.longest_ms = std::max(mcts.longest_ms, worker.value.mcts.longest_ms);
+    games += worker.value.games;
+    ticks += worker.value.ticks;
+    evaluated += worker.value.evaluated;
+    hits += worker.value.table_hits;
+    misses += worker.value.table_misses;
+    for (const GameResult &result : worker.value.results) {
+      scores.push_back(result.score);
+      levels.push_back(result.level);
+      lengths.push_back(result.size);
+      game_ticks.push_back(static_cast<int>(result.ticks));
+    }
+  }
+
+  bool tetris = options.game == GameKind::kTetris;
+  const int *size = kBoardSizes[static_cast<int>(options.board)];
+  std::printf("game %s %dx%d, policy %s, %ld games on %u threads in %.3f s\n",
+              kGameNames[static_cast<int>(options.game)], size[0], size[1],
+              kPolicyNames[static_cast<int>(options.policy)], games,
+              scheduler.Threads(), seconds);
+  std::printf("games/sec %.1f  ticks/sec %.0f\n", games / seconds,
+              ticks / seconds);
+  if (options.policy == PolicyKind::kAi ||
+      options.policy == PolicyKind::kBeam) {
+    std::printf("placements evaluated %ld  placements/sec %.0f\n", evaluated,
+                evaluated / seconds);
+    std::printf("table hits %ld  misses %ld  hit rate %.1f%%\n", hits,
+                misses, hits + misses ? 100.0 * hits / (hits + misses) : 0.0);
+  }
+  if (options.policy == PolicyKind::kBeam) {
+    std::printf("beam plans %ld  mean %.3f ms  longest %.3f ms  levels/plan "
+                "%.2f  nodes/plan %.0f  timeouts %ld  over the limit %ld\n",
+                beam.plans, beam.plans ? beam.total_ms / beam.plans : 0.0,
+                beam.longest_ms,
+                beam.plans ? static_cast<double>(beam.levels) / beam.plans
+                           : 0.0,
+                beam.plans ? static_cast<double>(beam.nodes) / beam.plans
+                           : 0.0,
+                beam.timeouts, beam.overruns);
+  }
+  if (options.policy == PolicyKind::kMcts) {
+    std::printf("mcts decisions %ld  mean %.3f ms  longest %.3f ms  "
+                "iterations/decision %.1f  %s/sec %.0f\n",
+                mcts.decisions,
+                mcts.decisions ? mcts.total_ms / mcts.decisions : 0.0,
+                mcts.longest_ms,
+                mcts.decisions
+                    ? static_cast<double>(mcts.iterations) / mcts.decisions
+                    : 0.0,
+                tetris ? "placements" : "ticks",
+                mcts.total_ms ? mcts.placements / (mcts.total_ms / 1000)
+                              : 0.0);
+  }
+  ttable_destroy(table);
+  for (TetrisArena *arena : arenas) tetris_arena_destroy(arena);
+  PrintDistribution("score", scores);
+  PrintDistribution("level", levels);
+  PrintDistribution(tetris ? "lines" : "length", lengths);
+  PrintDistribution("ticks", game_ticks);
+  std::printf("score histogram\n");
+  PrintHistogram(scores);
+  return 0;
+}
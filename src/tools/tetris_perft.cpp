@@ -0,0 +1,156 @@
+#include <chrono>
+#include <cinttypes>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../inc/sim/parse_number.h"
+#include "../inc/sim/work_stealing.h"
+#include "../inc/tetris/movegen.h"
+
+/** @file */
+
+namespace {
+
+// Letters of the figures in the order of the figures table
+const char kFigureLetters[] = "OIZSLJT";
+
+/**
+ * @brief Command line settings of a perft run.
+ */
+struct PerftOptions {
+  int depth = 4;
+  std::string pieces = "TIOLJSZ";
+  unsigned threads = std::thread::hardware_concurrency();
+};
+
+double SecondsSince(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       begin)
+      .count();
+}
+
+/**
+ * @brief Counts like tetris_perft, with the subtrees of the first piece's
+ * resting states spread over the workers.
+ */
+std::uint64_t ParallelPerft(const std::uint8_t *pieces, int depth,
+                            s21::WorkStealingScheduler &scheduler) {
+  Bitboard board;
+  bitboard_clear(&board);
+  if (depth <= 1) return tetris_perft(&board, pieces, depth);
+
+  TetrisMoves moves;
+  tetris_generate_moves(&moves, &board, pieces[0], 0, START_POS_FIGURE_X,
+                        START_POS_FIGURE_Y);
+  std::vector<s21::CacheAligned<std::uint64_t>> counts(scheduler.Threads());
+  scheduler.Run(moves.resting_count, [&](unsigned worker, std::size_t i) {
+    const MoveState &state = moves.states[moves.resting[i]];
+    const ShapeOrientation *shape = &shape_table[pieces[0]][state.rotation];
+    Bitboard child = board;
+    shape_place(&child, shape, state.x, state.y);
+    bitboard_remove_full_rows(&child, state.y + shape->top,
+                              state.y + shape->bottom);
+    counts[worker].value += tetris_perft(&child, pieces + 1, depth - 1);
+  });
+
+  std::uint64_t total = 0;
+  for (const auto &count : counts) total += count.value;
+  return total;
+}
+
+void PrintUsage(const char *program) {
+  std::printf(
+      "Usage: %s [options]\n"
+      "  --depth N        pieces to place (4)\n"
+      "  --pieces STRING  piece sequence from O I Z S L J T, repeated as\n"
+      "                   needed (TIOLJSZ)\n"
+      "  --threads N      workers of the parallel count (all cores)\n",
+      program);
+}
+
+bool ParseOptions(int argc, char **argv, PerftOptions *options) {
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!std::strcmp(arg, "--help") || value == nullptr) return false;
+    ++i;
+    bool valid = true;  // False for a value the option does not accept
+    long long number = 0;
+    if (!std::strcmp(arg, "--depth")) {
+      valid = s21::ParseInteger(value, 1, INT_MAX, &number);
+      options->depth = static_cast<int>(number);
+    } else if (!std::strcmp(arg, "--pieces")) {
+      options->pieces = value;
+    } else if (!std::strcmp(arg, "--threads")) {
+      valid = s21::ParseInteger(value, 1, s21::kMaxOptionThreads, &number);
+      options->threads = static_cast<unsigned>(number);
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", arg);
+      return false;
+    }
+    if (!valid) {
+      std::fprintf(stderr, "unknown value %s for %s\n", value, arg);
+      return false;
+    }
+  }
+  bool valid = options->depth > 0 && !options->pieces.empty();
+  for (char letter : options->pieces) {
+    valid = valid && letter && std::strchr(kFigureLetters, letter);
+  }
+  return valid;
+}
+
+}  // namespace
+
+/**
+ * @brief Counts the placement sequences of a fixed piece sequence on an
+ * empty field for every depth up to --depth, once on one thread and once on
+ * all workers, and checks that both counts agree.
+ *
+ * @return 0 if every serial and parallel count agree, 1 otherwise
+ */
+int main(int argc, char **argv) {
+  PerftOptions options;
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  std::vector<std::uint8_t> pieces(options.depth);
+  for (int d = 0; d < options.depth; ++d) {
+    char letter = options.pieces[d % options.pieces.size()];
+    pieces[d] = static_cast<std::uint8_t>(std::strchr(kFigureLetters, letter) -
+                                          kFigureLetters);
+  }
+
+  s21::WorkStealingScheduler scheduler(options.threads);
+  Bitboard board;
+  bitboard_clear(&board);
+  bool all_ok = true;
+  std::printf("%5s %16s %10s %14s %10s %14s\n", "depth", "count", "serial s",
+              "serial /s", "par s", "par /s");
+  for (int depth = 1; depth <= options.depth; ++depth) {
+    auto begin = std::chrono::steady_clock::now();
+    std::uint64_t serial = tetris_perft(&board, pieces.data(), depth);
+    double serial_seconds = SecondsSince(begin);
+
+    begin = std::chrono::steady_clock::now();
+    std::uint64_t parallel = ParallelPerft(pieces.data(), depth, scheduler);
+    double parallel_seconds = SecondsSince(begin);
+
+    bool ok = serial == parallel;
+    all_ok = all_ok && ok;
+    std::printf("%5d %16" PRIu64 " %10.3f %14.0f %10.3f %14.0f%s\n", depth,
+                serial, serial_seconds, serial / serial_seconds,
+                parallel_seconds, parallel / parallel_seconds,
+                ok ? "" : "  MISMATCH");
+  }
+  std::printf("%u threads\n", scheduler.Threads());
+  return all_ok ? 0 : 1;
+}
@@ -0,0 +1,466 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../inc/rng.h"
+#include "../inc/sim/parse_number.h"
+#include "../inc/sim/work_stealing.h"
+#include "../inc/tetris/ai.h"
+#include "../inc/tetris/headless.h"
+
+/** @file */
+
+namespace {
+
+// TetrisAiWeights as a vector, in the order of its fields
+constexpr int kWeights = 7;
+const char *const kWeightNames[kWeights] = {
+    "lines", "height", "holes", "bumpiness", "row_transitions",
+    "column_transitions", "wells"};
+const char kCheckpointMagic[] = "tetris-tune 2";
+
+using Genome = std::vector<double>;
+
+/**
+ * @brief Command line settings of a tuning run.
+ */
+struct TuneOptions {
+  int population = 24;
+  int generations = 10;
+  int games = 16;
+  int max_pieces = 300;
+  bool lookahead = false;
+  // Fitness options set on the command line, a resumed run must match them
+  bool games_given = false;
+  bool max_pieces_given = false;
+  bool lookahead_given = false;
+  unsigned threads = std::thread::hardware_concurrency();
+  std::uint64_t seed = 1;
+  std::string checkpoint;
+  std::string resume;
+};
+
+/**
+ * @brief Everything a run needs to continue: the options the fitness
+ * depends on, the genomes of the next generation and the best genome found
+ * so far.
+ */
+struct TuneState {
+  std::uint64_t seed = 1;
+  int games = 0;
+  int max_pieces = 0;
+  bool lookahead = false;
+  int generation = 0;
+  std::vector<Genome> population;
+  Genome best;
+  double best_fitness = -1;
+};
+
+std::uint64_t MixSeed(std::uint64_t value) {
+  value += 0x9E3779B97F4A7C15ull;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+double Uniform(Rng *rng) { return (rng_next(rng) >> 11) * 0x1.0p-53; }
+
+double Gaussian(Rng *rng) {
+  double u = 1.0 - Uniform(rng), v = Uniform(rng);
+  return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * v);
+}
+
+/**
+ * @brief Scales a genome to unit length. Scores are linear in the weights,
+ * so only the direction decides which move is played.
+ */
+void Normalize(Genome &genome) {
+  double length = 0;
+  for (double weight : genome) length += weight * weight;
+  length = std::sqrt(length);
+  if (length > 0) {
+    for (double &weight : genome) weight /= length;
+  }
+}
+
+TetrisAiWeights ToWeights(const Genome &genome) {
+  return {genome[0], genome[1], genome[2], genome[3],
+          genome[4], genome[5], genome[6]};
+}
+
+Genome DefaultGenome() {
+  TetrisAi ai;
+  tetris_ai_init(&ai);
+  const TetrisAiWeights &w = ai.weights;
+  Genome genome = {w.lines,           w.height,
+                   w.holes,           w.bumpiness,
+                   w.row_transitions, w.column_transitions,
+                   w.wells};
+  Normalize(genome);
+  return genome;
+}
+
+/**
+ * @brief Plays one seeded headless game with a genome.
+ *
+ * @return Lines cleared before the game ended or max_pieces were placed,
+ * -1 if the session cannot be allocated
+ */
+int PlayGame(const TuneOptions &options, const Genome &genome,
+             std::uint64_t seed) {
+  TetrisAi ai;
+  tetris_ai_init(&ai);
+  ai.weights = ToWeights(genome);
+  ai.lookahead = options.lookahead;
+  TetrisSession *session = tetris_session_create_seeded(seed, false);
+  if (session == nullptr) return -1;
+  UserAction start = Start;
+  TetrisStepResult step = tetris_session_step(session, &start, 1, 0);
+  int lines = 0;
+  for (int piece = 0; piece < options.max_pieces && step.state == STARTED;
+       ++piece) {
+    int count = tetris_ai_plan(&ai, tetris_session_tetromino(session),
+                               tetris_session_info(session));
+    step = tetris_session_step(session, ai.moves, count, 1);
+    lines += step.lines;
+  }
+  tetris_session_destroy(session);
+  return lines;
+}
+
+/**
+ * @brief Mean lines of every genome over the same seeded games.
+ *
+ * All genomes of a generation play the same piece sequences, so their
+ * fitness differs by the weights only. Every game is its own task and the
+ * sums are taken in index order, so the result does not depend on the
+ * thread count.
+ *
+ * @return Fitness of every genome, empty if a game could not be played
+ */
+std::vector<double> Evaluate(const TuneOptions &options,
+                             const TuneState &state,
+                             s21::WorkStealingScheduler &scheduler) {
+  std::size_t games = static_cast<std::size_t>(options.games);
+  std::vector<int> lines(state.population.size() * games);
+  scheduler.Run(lines.size(), [&](unsigned, std::size_t task) {
+    std::uint64_t seed = MixSeed(state.seed ^ MixSeed(state.generation) ^
+                                 (task % games));
+    lines[task] = PlayGame(options, state.population[task / games], seed);
+  });
+
+  std::vector<double> fitness(state.population.size(), 0.0);
+  for (std::size_t task = 0; task < lines.size(); ++task) {
+    fitness[task / games] += lines[task];
+  }
+  if (std::find(lines.begin(), lines.end(), -1) != lines.end()) fitness.clear();
+  for (double &value : fitness) value /= options.games;
+  return fitness;
+}
+
+/**
+ * @brief Picks the fittest of three random genomes.
+ */
+std::size_t Tournament(const std::vector<double> &fitness, Rng *rng) {
+  std::size_t best = rng_below(rng, static_cast<uint32_t>(fitness.size()));
+  for (int round = 1; round < 3; ++round) {
+    std::size_t other = rng_below(rng, static_cast<uint32_t>(fitness.size()));
+    if (fitness[other] > fitness[best]) best = other;
+  }
+  return best;
+}
+
+/**
+ * @brief Breeds the next generation: the best eighth is kept as is, the
+ * rest are fitness weighted blends of two tournament winners, some with
+ * one weight nudged.
+ */
+std::vector<Genome> Breed(const std::vector<Genome> &population,
+                          const std::vector<double> &fitness, Rng *rng) {
+  std::vector<std::size_t> order(population.size());
+  for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) {
+                     return fitness[a] > fitness[b];
+                   });
+
+  std::vector<Genome> next;
+  std::size_t elite = std::max<std::size_t>(1, population.size() / 8);
+  for (std::size_t i = 0; i < elite; ++i) next.push_back(population[order[i]]);
+  while (next.size() < population.size()) {
+    std::size_t a = Tournament(fitness, rng), b = Tournament(fitness, rng);
+    double share_a = fitness[a] + 1, share_b = fitness[b] + 1;
+    Genome child(kWeights);
+    for (int w = 0; w < kWeights; ++w) {
+      child[w] = population[a][w] * share_a + population[b][w] * share_b;
+    }
+    Normalize(child);
+    if (Uniform(rng) < 0.3) {
+      child[rng_below(rng, kWeights)] += 0.2 * Gaussian(rng);
+      Normalize(child);
+    }
+    next.push_back(child);
+  }
+  return next;
+}
+
+/**
+ * @brief Writes the state next to the checkpoint and renames it over the
+ * checkpoint, so an interrupted write never leaves a broken file.
+ */
+bool SaveCheckpoint(const std::string &path, const TuneState &state) {
+  std::string temporary = path + ".tmp";
+  std::FILE *file = std::fopen(temporary.c_str(), "w");
+  bool ok = file != nullptr;
+  if (ok) {
+    std::fprintf(file, "%s\nseed %llu\ngames %d\nmax-pieces %d\n",
+                 kCheckpointMagic,
+                 static_cast<unsigned long long>(state.seed), state.games,
+                 state.max_pieces);
+    std::fprintf(file, "lookahead %d\ngeneration %d\npopulation %zu\n",
+                 state.lookahead ? 1 : 0, state.generation,
+                 state.population.size());
+    std::fprintf(file, "best %.17g", state.best_fitness);
+    for (double weight : state.best) std::fprintf(file, " %.17g", weight);
+    std::fprintf(file, "\n");
+    for (const Genome &genome : state.population) {
+      for (int w = 0; w < kWeights; ++w) {
+        std::fprintf(file, w ? " %.17g" : "%.17g", genome[w]);
+      }
+      std::fprintf(file, "\n");
+    }
+    ok = !std::ferror(file);
+    ok = std::fclose(file) == 0 && ok;
+  }
+  return ok && std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool LoadCheckpoint(const std::string &path, TuneState *state) {
+  std::FILE *file = std::fopen(path.c_str(), "r");
+  if (file == nullptr) return false;
+  char magic[32] = {0};
+  unsigned long long seed = 0;
+  int lookahead = 0;
+  std::size_t size = 0;
+  bool ok = std::fgets(magic, sizeof(magic), file) &&
+            !std::strncmp(magic, kCheckpointMagic,
+                          std::strlen(kCheckpointMagic)) &&
+            std::fscanf(file, " seed %llu games %d max-pieces %d lookahead %d",
+                        &seed, &state->games, &state->max_pieces,
+                        &lookahead) == 4 &&
+            std::fscanf(file, " generation %d population %zu",
+                        &state->generation, &size) == 2 &&
+            std::fscanf(file, " best %lf", &state->best_fitness) == 1;
+  state->seed = seed;
+  state->lookahead = lookahead != 0;
+  state->best.assign(kWeights, 0.0);
+  for (int w = 0; ok && w < kWeights; ++w) {
+    ok = std::fscanf(file, "%lf", &state->best[w]) == 1;
+  }
+  state->population.assign(size, Genome(kWeights));
+  for (std::size_t i = 0; ok && i < size; ++i) {
+    for (int w = 0; ok && w < kWeights; ++w) {
+      ok = std::fscanf(file, "%lf", &state->population[i][w]) == 1;
+    }
+  }
+  std::fclose(file);
+  return ok && size > 0 && state->games > 0 && state->max_pieces > 0;
+}
+
+/**
+ * @brief First generation: the shipped weights and random directions.
+ */
+TuneState InitialState(const TuneOptions &options) {
+  TuneState state;
+  state.seed = options.seed;
+  state.games = options.games;
+  state.max_pieces = options.max_pieces;
+  state.lookahead = options.lookahead;
+  Rng rng;
+  rng_seed(&rng, MixSeed(options.seed));
+  state.population.push_back(DefaultGenome());
+  while (state.population.size() <
+         static_cast<std::size_t>(options.population)) {
+    Genome genome(kWeights);
+    for (double &weight : genome) weight = Gaussian(&rng);
+    Normalize(genome);
+    state.population.push_back(genome);
+  }
+  state.best = state.population[0];
+  return state;
+}
+
+void PrintGenome(const char *label, const Genome &genome) {
+  std::printf("%s", label);
+  for (int w = 0; w < kWeights; ++w) {
+    std::printf(" %s=%.6f", kWeightNames[w], genome[w]);
+  }
+  std::printf("\n");
+}
+
+void PrintUsage(const char *program) {
+  std::printf(
+      "Usage: %s [options]\n"
+      "  --population N     genomes per generation (24)\n"
+      "  --generations N    generations to run (10)\n"
+      "  --games N          seeded games per genome (16)\n"
+      "  --max-pieces N     pieces per game (300)\n"
+      "  --lookahead 0|1    also place the preview piece (0)\n"
+      "  --threads N        worker threads (all cores)\n"
+      "  --seed N           seed of the run (1)\n"
+      "  --checkpoint FILE  write the state after every generation\n"
+      "  --resume FILE      continue from a checkpoint, with the games,\n"
+      "                     max pieces and lookahead it was tuned with\n",
+      program);
+}
+
+bool ParseOptions(int argc, char **argv, TuneOptions *options) {
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!std::strcmp(arg, "--help") || value == nullptr) return false;
+    ++i;
+    bool valid = true;  // False for a value the option does not accept
+    long long number = 0;
+    if (!std::strcmp(arg, "--population")) {
+      valid = s21::ParseInteger(value, 2, INT_MAX, &number);
+      options->population = static_cast<int>(number);
+    } else if (!std::strcmp(arg, "--generations")) {
+      valid = s21::ParseInteger(value, 1, INT_MAX, &number);
+      options->generations = static_cast<int>(number);
+    } else if (!std::strcmp(arg, "--games")) {
+      valid = s21::ParseInteger(value, 1, INT_MAX, &number);
+      options->games = static_cast<int>(number);
+      options->games_given = true;
+    } else if (!std::strcmp(arg, "--max-pieces")) {
+      valid = s21::ParseInteger(value, 1, INT_MAX, &number);
+      options->max_pieces = static_cast<int>(number);
+      options->max_pieces_given = true;
+    } else if (!std::strcmp(arg, "--lookahead")) {
+      valid = s21::ParseInteger(value, 0, 1, &number);
+      options->lookahead = number != 0;
+      options->lookahead_given = true;
+    } else if (!std::strcmp(arg, "--threads")) {
+      valid = s21::ParseInteger(value, 1, s21::kMaxOptionThreads, &number);
+      options->threads = static_cast<unsigned>(number);
+    } else if (!std::strcmp(arg, "--seed")) {
+      valid = s21::ParseUnsigned(value, &options->seed);
+    } else if (!std::strcmp(arg, "--checkpoint")) {
+      options->checkpoint = value;
+    } else if (!std::strcmp(arg, "--resume")) {
+      options->resume = value;
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", arg);
+      return false;
+    }
+    if (!valid) {
+      std::fprintf(stderr, "unknown value %s for %s\n", value, arg);
+      return false;
+    }
+  }
+  return options->population > 1 && options->generations > 0 &&
+         options->games > 0 && options->max_pieces > 0;
+}
+
+}  // namespace
+
+/**
+ * @brief Tunes the autoplayer's weights with a genetic algorithm over
+ * seeded headless games played on every core.
+ *
+ * Every generation is derived from the run seed and its number, and the
+ * checkpoint keeps the options the fitness depends on, so a run resumed from
+ * a checkpoint continues exactly as if it had not stopped.
+ *
+ * @return 0 on success, 1 on bad options or checkpoint errors
+ */
+int main(int argc, char **argv) {
+  TuneOptions options;
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  TuneState state;
+  if (!options.resume.empty()) {
+    if (!LoadCheckpoint(options.resume, &state)) {
+      std::fprintf(stderr, "cannot read checkpoint %s\n",
+                   options.resume.c_str());
+      return 1;
+    }
+    bool same = (!options.games_given || state.games == options.games) &&
+                (!options.max_pieces_given ||
+                 state.max_pieces == options.max_pieces) &&
+                (!options.lookahead_given ||
+                 state.lookahead == options.lookahead);
+    if (!same) {
+      std::fprintf(stderr,
+                   "checkpoint %s was tuned with --games %d --max-pieces %d "
+                   "--lookahead %d\n",
+                   options.resume.c_str(), state.games, state.max_pieces,
+                   state.lookahead ? 1 : 0);
+      return 1;
+    }
+    options.games = state.games;
+    options.max_pieces = state.max_pieces;
+    options.lookahead = state.lookahead;
+    std::printf("resumed %s at generation %d\n", options.resume.c_str(),
+                state.generation);
+  } else {
+    state = InitialState(options);
+  }
+
+  s21::WorkStealingScheduler scheduler(options.threads);
+  std::printf("%4s %10s %10s %10s %10s\n", "gen", "best", "mean", "games/s",
+              "seconds");
+  int last = state.generation + options.generations;
+  bool ok = true;
+  while (ok && state.generation < last) {
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<double> fitness = Evaluate(options, state, scheduler);
+    if (fitness.empty()) {
+      std::fprintf(stderr, "cannot allocate a game session\n");
+      ok = false;
+      break;
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - begin)
+                         .count();
+
+    std::size_t top = static_cast<std::size_t>(
+        std::max_element(fitness.begin(), fitness.end()) - fitness.begin());
+    double mean = 0;
+    for (double value : fitness) mean += value;
+    mean /= fitness.size();
+    if (fitness[top] > state.best_fitness) {
+      state.best_fitness = fitness[top];
+      state.best = state.population[top];
+    }
+    std::printf("%4d %10.1f %10.1f %10.0f %10.2f\n", state.generation,
+                fitness[top], mean,
+                fitness.size() * options.games / seconds, seconds);
+    std::fflush(stdout);
+
+    Rng rng;
+    rng_seed(&rng, MixSeed(state.seed + 1 + state.generation));
+    state.population = Breed(state.population, fitness, &rng);
+    state.generation++;
+    if (!options.checkpoint.empty() &&
+        !SaveCheckpoint(options.checkpoint, state)) {
+      std::fprintf(stderr, "cannot write checkpoint %s\n",
+                   options.checkpoint.c_str());
+      ok = false;
+    }
+  }
+
+  std::printf("best fitness %.1f lines\n", state.best_fitness);
+  PrintGenome("best", state.best);
+  return ok ? 0 : 1;
+}